@@ -5,16 +5,29 @@
 
 #include "code.h"
 #include "UI.h"
+#include "Configure.h"
+#include "Benchmark.h"
 
 using namespace std;
 
 /**
  * 主函数
- * 创建UI对象并启动仿真系统
+ * 解析命令行参数，创建UI对象并启动仿真系统
+ * @param argc 参数个数
+ * @param argv 参数列表，例如 --backend=threaded 或 --benchmark=grid-layout
  * @return 程序退出码
  */
-int main()
+int main(int argc, char* argv[])
 {
+	if (!parseCommandLine(argc, argv)) {
+		cerr << "usage: FluidSimulationSystem [--backend=scalar|threaded|simd|cuda] [--backend2d=...] [--backend3d=...] [--advection2d=semi-lagrangian|bfecc|maccormack] [--trace=euler|rk2|rk3] [--trace2d=...] [--trace3d=...] [--pressure2d=gauss-seidel|pcg|multigrid|mgpcg|rb-sor|fft|mixed-precision] [--pressure3d=jacobi|chebyshev|pcg|multigrid|mgpcg|fft] [--benchmark=grid-layout|grid-sampling|pressure-warm-start]" << endl;
+		return 1;
+	}
+
+	if (!benchmarkName.empty()) {
+		return Glb::RunBenchmark(benchmarkName) ? 0 : 1;
+	}
+
 	FluidSimulation::UI ui;
 	ui.run();
 	return 0;
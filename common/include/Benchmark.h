@@ -0,0 +1,31 @@
+﻿/**
+ * Benchmark.h: 性能测试
+ * 不启动窗口，直接运行指定的测试并输出结果（同时写入日志）
+ */
+
+#pragma once
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+#include <string>
+
+namespace Glb {
+
+	/**
+	 * 按名称运行性能测试
+	 * @param name 测试名称，例如 grid-layout
+	 * @return 名称合法时返回 true
+	 */
+	bool RunBenchmark(const std::string& name);
+
+	// 比较 3D 网格线性布局与块布局在半拉格朗日平流中的耗时 (128^3 与 256^3)
+	void BenchmarkGridLayout3d();
+
+	// 比较逐点插值与 AVX2 批量插值的耗时 (2D 512^2 与 3D 128^3，约 100 万个随机采样点)
+	void BenchmarkGridSampling();
+
+	// 比较压力求解从 0 开始与热启动在固定容差下的迭代次数 (2D 256^2 与 3D 64^3，右端项逐帧缓慢变化)
+	void BenchmarkPressureWarmStart();
+}
+
+#endif // !__BENCHMARK_H__
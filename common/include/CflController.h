@@ -0,0 +1,65 @@
+﻿#pragma once
+#ifndef __CFL_CONTROLLER_H__
+#define __CFL_CONTROLLER_H__
+#include <string>
+#include "Global.h"
+
+namespace Glb {
+
+    /**
+     * CFL 时间步控制器
+     * 一帧需要推进 frameTime，每个子步满足 dt * vmax <= cfl * cellSize，子步数不超过 maxSubsteps
+     * 达到子步上限时本帧少推进一些时间，以稳定性优先
+     */
+    class CflController {
+    public:
+        CflController(float frameTime, float cfl, int maxSubsteps)
+            : mFrameTime(frameTime), mCfl(cfl), mMaxSubsteps(maxSubsteps < 1 ? 1 : maxSubsteps), mElapsed(0.0f), mSubsteps(0) {
+        }
+
+        // 本帧是否已经推进完毕
+        bool done() const {
+            return mElapsed >= mFrameTime || mSubsteps >= mMaxSubsteps;
+        }
+
+        // 根据当前最大速度给出下一子步的时间步长，vmax 为 0 时直接推进剩余时间
+        float next(float vmax, float cellSize) {
+            float remaining = mFrameTime - mElapsed;
+            float dt = remaining;
+            if (vmax > 0.0f) {
+                float limit = mCfl * cellSize / vmax;
+                if (limit < remaining) {
+                    // 剩余时间不足两步时平分，避免最后一步过小
+                    dt = 2.0f * limit > remaining ? 0.5f * remaining : limit;
+                }
+            }
+            mElapsed = dt >= remaining ? mFrameTime : mElapsed + dt;
+            mSubsteps++;
+            return dt;
+        }
+
+        int substeps() const {
+            return mSubsteps;
+        }
+
+        float elapsed() const {
+            return mElapsed;
+        }
+
+        // 把本帧的平均时间步长与子步数写入计时器
+        void report() const {
+            float dt = mSubsteps > 0 ? mElapsed / mSubsteps : 0.0f;
+            Timer::getInstance().recordValue("dt", std::to_string(dt).substr(0, 7));
+            Timer::getInstance().recordValue("substeps", std::to_string(mSubsteps));
+        }
+
+    private:
+        float mFrameTime;       // 一帧推进的时间
+        float mCfl;             // CFL 数
+        int mMaxSubsteps;       // 子步数上限
+        float mElapsed;         // 本帧已推进的时间
+        int mSubsteps;          // 本帧已执行的子步数
+    };
+}
+
+#endif
@@ -40,6 +40,82 @@ extern float fontSize;      // 字体大小
 // 仿真状态
 extern bool simulating;     // 是否正在进行仿真
 
+/**
+ * 求解器后端类型
+ * 在组件初始化时选择，切换后需要 Rerun
+ */
+enum SolverBackend
+{
+    BACKEND_SCALAR = 0,     // 单线程参考实现
+    BACKEND_THREADED,       // OpenMP 多线程
+    BACKEND_SIMD,           // AVX2 向量化 + 多线程
+    BACKEND_CUDA,           // CUDA (仅 3D)
+    BACKEND_COUNT
+};
+
+extern const char* solverBackendNames[BACKEND_COUNT];   // 后端名称，用于 UI 与命令行
+
+/**
+ * 平流格式
+ * BFECC 与 MacCormack 在半拉格朗日的基础上补偿一阶误差，
+ * 结果限制在回溯点所在单元的最小/最大值之间以保持稳定
+ */
+enum AdvectionScheme
+{
+    ADVECT_SEMI_LAGRANGIAN = 0, // 一阶半拉格朗日，每步回溯 1 次
+    ADVECT_BFECC,               // Back and Forth Error Compensation and Correction，每步回溯 3 次
+    ADVECT_MACCORMACK,          // MacCormack，每步回溯 3 次、插值 2 次
+    ADVECT_SCHEME_COUNT
+};
+
+extern const char* advectionSchemeNames[ADVECT_SCHEME_COUNT];   // 平流格式名称，用于 UI 与命令行
+
+/**
+ * 半拉格朗日回溯的积分方法
+ * RK2 为中点法，RK3 为 Ralston 三阶方法，每多一阶多采样一次速度
+ */
+enum TraceIntegrator
+{
+    TRACE_EULER = 0,            // 前向 Euler，一阶
+    TRACE_RK2,                  // 中点法，二阶
+    TRACE_RK3,                  // Ralston RK3，三阶
+    TRACE_INTEGRATOR_COUNT
+};
+
+extern const char* traceIntegratorNames[TRACE_INTEGRATOR_COUNT];   // 回溯积分方法名称，用于 UI 与命令行
+
+/**
+ * 压力泊松方程的求解器
+ */
+enum PressureSolver
+{
+    PRESSURE_GAUSS_SEIDEL = 0,  // 最多 100 次原地 Gauss-Seidel 迭代
+    PRESSURE_PCG,               // 预条件共轭梯度（2D 为 MIC(0)，3D 为对角预条件），迭代到残差满足容差
+    PRESSURE_MULTIGRID,         // 几何多重网格，FMG 后做 V-cycle 直到残差满足容差；2D 有固体时改用 mgpcg
+    PRESSURE_MGPCG,             // 以一次 V-cycle 为预条件的共轭梯度
+    PRESSURE_JACOBI,            // 最多 40 次 Jacobi 迭代（仅 3D，2D 改用 Gauss-Seidel）
+    PRESSURE_RED_BLACK_SOR,     // 最多 100 次红黑排序的 SOR 迭代，可按行并行（仅 2D）
+    PRESSURE_FFT,               // 无障碍长方体上基于 FFT 的直接求解；2D 有固体时改用 mgpcg，3D 仅 CPU 后端
+    PRESSURE_CHEBYSHEV,         // Chebyshev 加速的 Jacobi 迭代到残差满足容差，支持 CUDA（仅 3D，2D 改用 Gauss-Seidel）
+    PRESSURE_MIXED_PRECISION,   // 单精度 mgpcg 求修正量、双精度计算残差的迭代改进（仅 2D，3D 的压力本身为单精度，改用 Jacobi）
+    PRESSURE_SOLVER_COUNT
+};
+
+extern const char* pressureSolverNames[PRESSURE_SOLVER_COUNT];     // 压力求解器名称，用于 UI 与命令行
+
+/**
+ * 解析命令行参数
+ * 支持 --backend=<name>、--backend2d=<name>、--backend3d=<name>
+ * name 为 scalar / threaded / simd / cuda
+ * 以及 --advection2d=<name>，name 为 semi-lagrangian / bfecc / maccormack
+ * 以及 --trace=<name>、--trace2d=<name>、--trace3d=<name>，name 为 euler / rk2 / rk3
+ * 以及 --pressure2d=<name>、--pressure3d=<name>，name 为 gauss-seidel / pcg / multigrid / mgpcg / jacobi / rb-sor / fft / chebyshev / mixed-precision
+ * @return 参数全部合法时返回 true
+ */
+bool parseCommandLine(int argc, char* argv[]);
+
+extern std::string benchmarkName;   // --benchmark=<name> 指定的性能测试，为空时正常启动
+
 /**
  * 2D 欧拉流体模拟参数命名空间
  * 存放 2D 欧拉流体模拟相关的配置参数
@@ -62,7 +138,19 @@ namespace Eulerian2dPara
     extern float theCellSize2d;
     extern bool addSolid;
 
-    extern float dt;
+    extern float dt;                // 自适应时为一帧推进的时间
+    extern bool adaptiveDt;         // 按 CFL 条件把一帧分成若干子步
+    extern float cflNumber;
+    extern int maxSubsteps;
+    extern int backend;
+    extern int advectionScheme;
+    extern int traceIntegrator;
+    extern int pressureSolver;
+    extern float pressureTolerance;     // 相对于右端项最大值的容差
+    extern int pressureMaxIterations;
+    extern float sorOmega;              // 红黑 SOR 的松弛因子，取值 (0, 2)
+    extern int pressureCheckInterval;   // 固定次数的迭代每隔多少次检查一次残差，0 表示不检查
+    extern bool warmStartPressure;      // 以上一次的压力（按 dt 缩放）作为初值
 
     extern float contrast;
     extern int drawModel;
@@ -103,9 +191,20 @@ namespace Eulerian3dPara
     extern int gridNumY;
     extern int gridNumZ;
 
-    extern float dt;
+    extern float dt;                // 自适应时为一帧推进的时间
+    extern bool adaptiveDt;         // 按 CFL 条件把一帧分成若干子步
+    extern float cflNumber;
+    extern int maxSubsteps;
     extern bool useBFECC;
+    extern int traceIntegrator;
     extern bool useReflection;
+    extern int backend;
+    extern bool sparseScalars;
+    extern int pressureSolver;          // CUDA 后端只支持 Jacobi 与 Chebyshev，其他求解器改用 Jacobi
+    extern float pressureTolerance;     // 相对于右端项最大值的容差
+    extern int pressureMaxIterations;
+    extern int pressureCheckInterval;   // Jacobi 每隔多少次检查一次残差，0 表示不检查；Chebyshev 为 0 时每 10 次检查一次
+    extern bool warmStartPressure;      // 以上一步的压力（按 dt 缩放）作为初值
 
     extern float airDensity;
     extern float ambientTemp;
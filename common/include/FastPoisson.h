@@ -0,0 +1,100 @@
+﻿#pragma once
+#ifndef __FAST_POISSON_H__
+#define __FAST_POISSON_H__
+#include <complex>
+#include <vector>
+
+namespace Glb {
+
+	typedef std::complex<double> Complex;
+
+	/**
+	 * 任意长度的复数 FFT
+	 * 长度只含 2、3、5、7 的因子时使用 Stockham 自动排序的混合基算法
+	 * 否则用 Bluestein 算法转换为长度只含 2、3 因子的循环卷积
+	 * 变换本身不修改成员，多个线程可以共用一个 FFT，各自提供 work
+	 */
+	class FFT {
+	public:
+		FFT();
+
+		void setup(int n);
+		int size() const { return mN; }
+		// work 需要的元素个数
+		int workSize() const { return mChirp.empty() ? mM : 2 * mM; }
+
+		// X_k = sum_j x_j e^{-2 pi i j k / n}，原地变换
+		void forward(Complex* data, Complex* work) const;
+		// x_j = sum_k X_k e^{2 pi i j k / n}，不除以 n
+		void inverse(Complex* data, Complex* work) const;
+
+	private:
+		// 长度为 mM 的混合基正变换，work 至少 mM 个元素
+		void stockham(Complex* data, Complex* work) const;
+
+		int mN;
+		int mM;                         // 混合基变换的长度，n 可分解时等于 n
+		std::vector<int> mRadix;        // mM 的因子，按变换的顺序排列
+		std::vector<Complex> mTwiddle;  // e^{-2 pi i k / mM}
+		std::vector<Complex> mChirp;    // Bluestein: e^{-pi i j^2 / n}
+		std::vector<Complex> mKernel;   // Bluestein: 共轭 chirp 周期延拓后的 FFT，已除以 mM
+	};
+
+	/**
+	 * 无障碍长方体区域上的快速泊松求解器，不需要迭代
+	 * 对每个单元求解 sum_n (x_c - x_n) = b_c，n 取 6 (2D 为 4) 个邻居，与 PoissonMultigrid 的方程一致
+	 * NEUMANN: 网格外为固体，不计入邻居，沿 x (3D 时还有 y) 方向做 DCT-II
+	 * DIRICHLET: 网格外一层的值为 0，沿 x (3D 时还有 y) 方向做 DST-I
+	 * 变换后各频率互相独立，沿最后一个方向只剩三对角方程，用追赶法求解，复杂度 O(N log N)
+	 * 2D 时 nz = 1，数据按 x + y * nx + z * nx * ny 存放
+	 */
+	class FastPoisson {
+	public:
+		enum Boundary { NEUMANN = 0, DIRICHLET = 1 };
+
+		FastPoisson();
+
+		// 为 false 时在调用线程上串行执行
+		void setParallel(bool parallel);
+
+		// 设置网格尺寸与边界条件，与上次相同时不重新计算变换表
+		void setup(int nx, int ny, int nz, Boundary boundary);
+
+		// 直接求解；NEUMANN 时先去掉 b 的均值，解的均值为 0
+		void solve(const double* b, double* x);
+		void solve(const float* b, float* x);
+
+	private:
+		struct Axis {
+			int n;          // 该方向的单元数
+			int stride;     // 相邻单元在数组中的间隔
+			int lines;      // 该方向上的直线数
+			FFT fft;
+			std::vector<Complex> shift;     // DCT-II: e^{-pi i k / (2 n)}
+			std::vector<int> order;         // DCT-II: 偶数位置在前、奇数位置倒序在后的重排
+			std::vector<double> sine;       // DST-I: sin(pi j / (n + 1))
+			std::vector<double> eigen;      // 一维 Laplace 算子的特征值
+			std::vector<double> norm;       // 正变换矩阵各行的范数平方，逆变换为转置后除以它
+		};
+
+		void setupAxis(Axis& axis, int n);
+		// 沿第 a 个方向对 mData 做正变换，transpose 为 true 时做转置变换
+		void transform(int a, bool transpose);
+		// 第 line 条直线的第一个单元
+		int lineStart(int a, int line) const;
+		// 沿最后一个方向对每个频率求解三对角方程
+		void solveLines();
+		void solveData();
+
+		bool mParallel;
+		int mDim[3];
+		Boundary mBoundary;
+		Axis mAxes[3];
+		int mNumAxes;                   // 做变换的方向数，nz = 1 时为 1，第 mNumAxes 个方向用追赶法
+		std::vector<double> mData;
+		std::vector<double> mLambda;    // 各频率在变换方向上的特征值之和
+		std::vector<double> mNorm;      // 各频率在变换方向上的范数平方之积
+	};
+}
+
+#endif
@@ -6,6 +6,9 @@
 #include <unordered_map>
 #include <glm/glm.hpp>
 #include <string>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 namespace Glb {
 
@@ -32,16 +35,18 @@ namespace Glb {
         std::chrono::system_clock::time_point now;          // 性能分析的当前时间点
 
         std::unordered_map<std::string, unsigned long long int> record;  // 记录各阶段耗时
+        std::unordered_map<std::string, std::string> values;            // 记录时间步长等附加信息
 
     public:
         // 检查记录是否为空
         bool empty() {
-            return record.empty();
+            return record.empty() && values.empty();
         }
 
         // 清空记录
         void clear() {
             record.clear();
+            values.clear();
         }
 
         // 开始计时
@@ -82,6 +87,11 @@ namespace Glb {
             }
         }
 
+        // 记录某个附加信息的当前值
+        void recordValue(const std::string& key, const std::string& value) {
+            values[key] = value;
+        }
+
         // 获取当前性能统计信息
         std::string currentStatus() {
             std::string str;
@@ -95,10 +105,37 @@ namespace Glb {
                 str += timing.first + ": " + std::to_string(percentage).substr(0, 5) + "%% \n";
             }
 
+            for (const auto& value : values) {
+                str += value.first + ": " + value.second + " \n";
+            }
+
             return str;
         }
     };
 
+    // 检测当前 CPU 与操作系统是否支持 AVX2 + FMA，用于选择 SIMD 后端
+    inline bool cpuSupportsAVX2() {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) {
+            return false;
+        }
+        __cpuid(info, 1);
+        bool fma = (info[2] & (1 << 12)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (!fma || !osxsave || (_xgetbv(0) & 0x6) != 0x6) {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+        return false;
+#endif
+    }
+
     // 随机数生成器类
     class RandomGenerator {
     private:
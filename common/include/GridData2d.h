@@ -3,85 +3,178 @@
 #define __GRID_DATA_2D_H__
 
 #pragma warning(disable: 4244 4267 4996)
-#include <boost/numeric/ublas/vector.hpp>
-#include <boost/numeric/ublas/io.hpp>
+#include <vector>
+#include <cassert>
 #include <glm/glm.hpp>
+#include "GridDataSIMD.h"
 
 namespace Glb {
 
-	using namespace boost::numeric;
+	// CPU ݵĴ洢ȣ CMake ѡ FLUID_SINGLE_PRECISION 
+	// ȿʹڴ룬ʹ SIMD ÿδԪӱ
+#ifdef FLUID_SINGLE_PRECISION
+	typedef float Real;
+#else
+	typedef double Real;
+#endif
 
-	// 2Dݻ,ڴ洢ʹMACϵı
-	class GridData2d
+	// Ĭϵ㣨ghost cell
+	// ֵʵ mSize + 2βֵ i - 1 ڱ߽紦ǯƣ 3 㹻
+	const int GRID_GHOST_LAYERS = 3;
+
+	// ݵĴλãԪĻĳһ
+	enum GridStagger
+	{
+		STAGGER_CENTER = -1,	// λڵԪ
+		STAGGER_X = 0,			// Xٶȷλ
+		STAGGER_Y = 1,			// Yٶȷλ
+		STAGGER_Z = 2			// Zٶȷ3D
+	};
+
+	/**
+	 * 2Dģ壬ڴ洢ʹMACϵıٶȷ
+	 * Ԫ뽻ڱȷʺΪ
+	 * ѭеķʿֱչΪ±д
+	 *
+	 * ܸ mGhost 鵥ԪԽֱ鵥Ԫϣʱж
+	 * 鵥Ԫֵ fillBoundary() ͳһд룺
+	 * ԽΪĬֵ෽ȡڲֵǯƵȼۣ
+	 * ޸ڲݺ fillBoundary()д鵥Ԫֵ´ʱ
+	 * @tparam T Ԫ
+	 * @tparam Axis ȡֵ GridStagger
+	 */
+	template <typename T, int Axis>
+	class StaggeredGrid2d
 	{
 	public:
-		GridData2d();
-		GridData2d(const GridData2d& orig);
-		virtual ~GridData2d();
-		virtual GridData2d& operator=(const GridData2d& orig);
+		// άȡ Eulerian2dPara
+		StaggeredGrid2d(int ghost = GRID_GHOST_LAYERS);
+		// ָά뵥ԪС
+		StaggeredGrid2d(int dim0, int dim1, float cellSize, int ghost = GRID_GHOST_LAYERS);
+		StaggeredGrid2d(const StaggeredGrid2d& orig) = default;
+		// ƶֻתڲ飬ڴ
+		StaggeredGrid2d(StaggeredGrid2d&& orig) noexcept = default;
+		StaggeredGrid2d& operator=(StaggeredGrid2d&& orig) noexcept = default;
+		// Ƹֵͬ copyFromߴͬʱ·
+		StaggeredGrid2d& operator=(const StaggeredGrid2d& orig)
+		{
+			if (this != &orig)
+				copyFrom(orig);
+			return *this;
+		}
+
+		// O(1) ȫ
+		void swap(StaggeredGrid2d& other);
+		//  other ݣͬʱеĴ洢
+		void copyFrom(const StaggeredGrid2d& other);
 
-		// Ĭֵʼ
-		virtual void initialize(double dfltValue = 0.0);
+		// Ĭֵʼ񣨰鵥Ԫ
+		void initialize(T dfltValue = T(0));
+
+		// ڲ鵥Ԫ
+		void fillBoundary();
 
 		// (i,j)λϵĿɸı
 		// ʹ GridData2d(i, j) = num ʽиֵ
-		virtual double& operator()(int i, int j);
+		// ij ԳΧ mGhost Ԫ
+		inline T& operator()(int i, int j)
+		{
+			assert(i >= -mGhost && i < mSize[0] + mGhost && j >= -mGhost && j < mSize[1] + mGhost);
+			return mData[mOrigin + i + j * mStride];
+		}
 
-		// ꣬زֵõֵ
+		// ꣬˫Բֵõֵ
 		// ڳΧĵ㣬Ĭֵ
-		virtual double interpolate(const glm::vec2& pt);	
+		T interpolate(const glm::vec2& pt);
+
+		// ꣬˫Բֵ 2x2 ݵСֵֵ
+		void getRange(const glm::vec2& pt, T& lo, T& hi);
+
+		// ֵxy Ϊ n ꣨SoAд out
+		// gridSimdEnabled() ʱ AVX2 gather  interpolate(pt) ͬ
+		void interpolate(const float* x, const float* y, T* out, int n);
 
-		// ݣmDataΪublasв
-		ublas::vector<double>& data();
+		// ֵʹõ
+		GridSampleDesc sampleDesc() const;
+
+		// ݣ鵥ԪţпΪ mStride
+		std::vector<T>& data() { return mData; }
 
 		// ꣬ظõڵԪ
-		virtual void getCell(const glm::vec2& pt, int& i, int& j);
+		void getCell(const glm::vec2& pt, int& i, int& j);
+
+		glm::vec2 worldToSelf(const glm::vec2& pt) const;
 
-		virtual glm::vec2 worldToSelf(const glm::vec2& pt) const;
-		double mDfltValue;				// Ĭֵڳʼ
+		T mDfltValue;					// Ĭֵڳʼ
 		glm::vec2 mMax;					// άռе꣬ʾĳߴ
-		ublas::vector<double> mData;	    // 洢ݵһά
-		float cellSize;                  // ԪС
-		int dim[2];                      // ά
+		std::vector<T> mData;			// 洢ݵһά
+		float cellSize;                 // ԪС
+		int dim[2];                     // άȣԪ
+		int mSize[2];                   // άȣȵԪ 1
+		int mGhost;                     // 
+		int mStride;                    // 鵥Ԫп
+		int mOrigin;                    // (0,0)  mData е±
 	};
 
-	// Xٶȷ
-	class GridData2dX : public GridData2d
+	/**
+	 * βֵCatmull-Rom бʣ deltaq = q3 - q2 ෴ʱضΪ 0µļֵ
+	 * ضѡʵ֣֧
+	 */
+	template <typename T>
+	inline T monotonicCubic(T q1, T q2, T q3, T q4, T t)
 	{
-	public:
-		GridData2dX();
-		virtual ~GridData2dX();
-		virtual void initialize(double dfltValue = 0.0);
-		virtual double& operator()(int i, int j);
-		virtual glm::vec2 worldToSelf(const glm::vec2& pt) const;
-	};
+		T deltaq = q3 - q2;
+		T d1 = (q3 - q1) * 0.5;
+		T d2 = (q4 - q2) * 0.5;
+
+		// Force monotonic: if d1/d2 differ in sign to deltaq, make it zero
+		bool rising = deltaq > 0.0001;
+		T up1 = d1 > 0 ? d1 : 0.0, down1 = d1 < 0 ? d1 : 0.0;
+		T up2 = d2 > 0 ? d2 : 0.0, down2 = d2 < 0 ? d2 : 0.0;
+		d1 = rising ? up1 : down1;
+		d2 = rising ? up2 : down2;
 
-	// Yٶȷ
-	class GridData2dY : public GridData2d
+		return q2 + d1 * t + (3 * deltaq - 2 * d1 - d2) * t * t + (-2 * deltaq + d1 + d2) * t * t * t;
+	}
+
+	/**
+	 *  N ͬʱβֵ鹲ò t
+	 * q[r * N + s] Ϊ s ĵ r 㣻黥أѭɱ
+	 */
+	template <typename T, int N>
+	inline void monotonicCubicN(const T* q, T t, T* out)
 	{
-	public:
-		GridData2dY();
-		virtual ~GridData2dY();
-		virtual void initialize(double dfltValue = 0.0);
-		virtual double& operator()(int i, int j);
-		virtual glm::vec2 worldToSelf(const glm::vec2& pt) const;
-	};
+		for (int s = 0; s < N; s++)
+			out[s] = monotonicCubic(q[s], q[N + s], q[2 * N + s], q[3 * N + s], t);
+	}
 
-	// ʹβֵ
-	class CubicGridData2d : public GridData2d
+	/**
+	 * ʹβֵĵԪ
+	 * ȶ 4x4 ģ壬 j ͬʱֵ 4 С i ֵ 1 
+	 */
+	template <typename T>
+	class CubicGrid2d : public StaggeredGrid2d<T, STAGGER_CENTER>
 	{
 	public:
-		CubicGridData2d();
-		CubicGridData2d(const CubicGridData2d& orig);
-		virtual ~CubicGridData2d();
-		virtual double interpolate(const glm::vec2& pt);
-
-	protected:
-		// βֵ
-		double cubic(double q1, double q2, double q3, double q4, double t);
-		double interpX(int i, int j, double fracty, double fractx);
-		double interpY(int i, int j, double fracty);
+		CubicGrid2d(int ghost = GRID_GHOST_LAYERS) : StaggeredGrid2d<T, STAGGER_CENTER>(ghost) {}
+		CubicGrid2d(int dim0, int dim1, float cellSize, int ghost = GRID_GHOST_LAYERS)
+			: StaggeredGrid2d<T, STAGGER_CENTER>(dim0, dim1, cellSize, ghost) {}
+
+		T interpolate(const glm::vec2& pt);
+		// βֵͬ StaggeredGrid2d::interpolate
+		void interpolate(const float* x, const float* y, T* out, int n);
 	};
+
+	template <typename T, int Axis>
+	inline void swap(StaggeredGrid2d<T, Axis>& a, StaggeredGrid2d<T, Axis>& b)
+	{
+		a.swap(b);
+	}
+
+	typedef StaggeredGrid2d<Real, STAGGER_CENTER> GridData2d;	// Ԫĵı
+	typedef StaggeredGrid2d<Real, STAGGER_X> GridData2dX;		// Xٶȷ
+	typedef StaggeredGrid2d<Real, STAGGER_Y> GridData2dY;		// Yٶȷ
+	typedef CubicGrid2d<Real> CubicGridData2d;					// ʹβֵ
 }
 
 #endif
\ No newline at end of file
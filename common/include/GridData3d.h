@@ -3,95 +3,186 @@
 #define __GRID_DATA_3D_H__
 
 #pragma warning(disable: 4244 4267 4996)
-#include <boost/numeric/ublas/vector.hpp>
-#include <boost/numeric/ublas/io.hpp>
+#include <vector>
 #include <glm/glm.hpp>
+#include "GridData2d.h"
 
 namespace Glb {
 
-	using namespace boost::numeric;
+	// 3Dڴ沼
+	enum GridLayout
+	{
+		LAYOUT_LINEAR = 0,	// Դ: i 죬 k j
+		LAYOUT_BRICK = 1	//  8x8x8 ĿţΪ ikj ˳
+	};
 
-	// 3Dݻ,ڴ洢ʹMACϵı
-	class GridData3d
+	// 鲼ÿı߳Ϊ 2 ݣ
+	const int GRID_BRICK_BITS = 3;
+	const int GRID_BRICK_SIZE = 1 << GRID_BRICK_BITS;
+
+	/**
+	 * 3Dģ壬ڴ洢ʹMACϵıٶȷ
+	 *  StaggeredGrid2d ͬԪ뽻ڱȷܴ鵥Ԫ
+	 * ±ɷֽΪƫ֮: idx = offsetI(i) + offsetJ(j) + offsetK(k)
+	 * Բ/βֵģ󲽳鲼ʹͬһ 4KB 
+	 * @tparam T Ԫ
+	 * @tparam Axis ȡֵ GridStagger
+	 * @tparam Layout ڴ沼֣ȡֵ GridLayout
+	 */
+	template <typename T, int Axis, int Layout = LAYOUT_LINEAR>
+	class StaggeredGrid3d
 	{
 	public:
-		GridData3d();
-		GridData3d(const GridData3d& orig);
-		virtual ~GridData3d();
-		virtual GridData3d& operator=(const GridData3d& orig);
-
-		// Ĭֵʼ
-		virtual void initialize(double dfltValue = 0.0);
+		// άȡ Eulerian3dPara
+		StaggeredGrid3d(int ghost = GRID_GHOST_LAYERS);
+		// ָά뵥ԪС
+		StaggeredGrid3d(int dim0, int dim1, int dim2, float cellSize, int ghost = GRID_GHOST_LAYERS);
+		StaggeredGrid3d(const StaggeredGrid3d& orig) = default;
+		// ƶֻתڲ飬ڴ
+		StaggeredGrid3d(StaggeredGrid3d&& orig) noexcept = default;
+		StaggeredGrid3d& operator=(StaggeredGrid3d&& orig) noexcept = default;
+		// Ƹֵͬ copyFromߴͬʱ·
+		StaggeredGrid3d& operator=(const StaggeredGrid3d& orig)
+		{
+			if (this != &orig)
+				copyFrom(orig);
+			return *this;
+		}
+
+		// O(1) ȫ
+		void swap(StaggeredGrid3d& other);
+		//  other ݣͬʱеĴ洢
+		void copyFrom(const StaggeredGrid3d& other);
+
+		// Ĭֵʼ񣨰鵥Ԫ
+		void initialize(T dfltValue = T(0));
+
+		// ڲ鵥Ԫ
+		void fillBoundary();
 
 		// (i,j,k)λϵĿɸı
-		virtual double& operator()(int i, int j, int k);
-
-		// ꣬زֵõֵ
-		virtual double interpolate(const glm::vec3& pt);
-
-		ublas::vector<double>& data();
+		// ijk ԳΧ mGhost Ԫ
+		inline T& operator()(int i, int j, int k)
+		{
+			assert(i >= -mGhost && i < mSize[0] + mGhost &&
+				j >= -mGhost && j < mSize[1] + mGhost &&
+				k >= -mGhost && k < mSize[2] + mGhost);
+			return mData[offsetI(i) + offsetJ(j) + offsetK(k)];
+		}
+
+		// ڴ˳ڲݣf(i, j, k)
+		// 鲼дʱиõľֲ
+		template <typename F>
+		void forEachCell(F f)
+		{
+			if (Layout == LAYOUT_LINEAR) {
+				for (int j = 0; j < mSize[1]; j++)
+					for (int k = 0; k < mSize[2]; k++)
+						for (int i = 0; i < mSize[0]; i++)
+							f(i, j, k);
+				return;
+			}
+			for (int bj = 0; bj < mBricks[1]; bj++)
+				for (int bk = 0; bk < mBricks[2]; bk++)
+					for (int bi = 0; bi < mBricks[0]; bi++) {
+						// 鸲ǵڲΧ
+						int i0 = bi * GRID_BRICK_SIZE - mGhost, i1 = i0 + GRID_BRICK_SIZE;
+						int j0 = bj * GRID_BRICK_SIZE - mGhost, j1 = j0 + GRID_BRICK_SIZE;
+						int k0 = bk * GRID_BRICK_SIZE - mGhost, k1 = k0 + GRID_BRICK_SIZE;
+						i0 = i0 < 0 ? 0 : i0; i1 = i1 > mSize[0] ? mSize[0] : i1;
+						j0 = j0 < 0 ? 0 : j0; j1 = j1 > mSize[1] ? mSize[1] : j1;
+						k0 = k0 < 0 ? 0 : k0; k1 = k1 > mSize[2] ? mSize[2] : k1;
+						for (int j = j0; j < j1; j++)
+							for (int k = k0; k < k1; k++)
+								for (int i = i0; i < i1; i++)
+									f(i, j, k);
+					}
+		}
+
+		// ꣬Բֵõֵ
+		T interpolate(const glm::vec3& pt);
+
+		// ֵxyz Ϊ n ꣨SoAд out
+		// Բ gridSimdEnabled() ʱ AVX2 gather ֵ
+		void interpolate(const float* x, const float* y, const float* z, T* out, int n);
+
+		// 洢ݵ飬鵥Ԫ鲼ʱ˳
+		std::vector<T>& data() { return mData; }
 
 		// ꣬ظõڵԪ
-		virtual void getCell(const glm::vec3& pt, int& i, int& j, int& k);
+		void getCell(const glm::vec3& pt, int& i, int& j, int& k);
 
 		glm::vec3 mMax;
 
 	protected:
-		virtual glm::vec3 worldToSelf(const glm::vec3& pt) const;
-		double mDfltValue;				// Ĭֵڳʼ
-		ublas::vector<double> mData;	    // 洢ݵһά
-		float cellSize;                  // ԪС
-		int dim[3];                      // ά
-	};
-
-	// Xٶȷ
-	class GridData3dX : public GridData3d
-	{
-	public:
-		GridData3dX();
-		virtual ~GridData3dX();
-		virtual void initialize(double dfltValue = 0.0);
-		virtual double& operator()(int i, int j, int k);
-		virtual glm::vec3 worldToSelf(const glm::vec3& pt) const;
+		glm::vec3 worldToSelf(const glm::vec3& pt) const;
+
+		// ֵʹõԲ֣
+		GridSampleDesc sampleDesc() const;
+
+		// ±ƫƣ֮ͼΪ mData е±
+		inline int offsetI(int i) const
+		{
+			int p = i + mGhost;
+			if (Layout == LAYOUT_LINEAR)
+				return p;
+			return ((p >> GRID_BRICK_BITS) << (3 * GRID_BRICK_BITS)) + (p & (GRID_BRICK_SIZE - 1));
+		}
+		inline int offsetK(int k) const
+		{
+			int p = k + mGhost;
+			if (Layout == LAYOUT_LINEAR)
+				return p * mStride[0];
+			return (p >> GRID_BRICK_BITS) * mStride[0] + ((p & (GRID_BRICK_SIZE - 1)) << GRID_BRICK_BITS);
+		}
+		inline int offsetJ(int j) const
+		{
+			int p = j + mGhost;
+			if (Layout == LAYOUT_LINEAR)
+				return p * mStride[1];
+			return (p >> GRID_BRICK_BITS) * mStride[1] + ((p & (GRID_BRICK_SIZE - 1)) << (2 * GRID_BRICK_BITS));
+		}
+
+		T mDfltValue;					// Ĭֵڳʼ
+		std::vector<T> mData;			// 洢ݵһά
+		float cellSize;                 // ԪС
+		int dim[3];                     // άȣԪ
+		int mSize[3];                   // άȣȵԪ 1
+		int mGhost;                     // 
+		int mStride[2];                 // kj Ĳ鲼ʱΪԽһĲ
+		int mBricks[3];                 // 鲼ʱĿ
 	};
 
-	// Yٶȷ
-	class GridData3dY : public GridData3d
+	/**
+	 * ʹβֵĵԪ
+	 * ȶ 4x4x4 ģ壬 jik ֵ16 + 4 + 1 Σ
+	 */
+	template <typename T, int Layout = LAYOUT_LINEAR>
+	class CubicGrid3d : public StaggeredGrid3d<T, STAGGER_CENTER, Layout>
 	{
 	public:
-		GridData3dY();
-		virtual ~GridData3dY();
-		virtual void initialize(double dfltValue = 0.0);
-		virtual double& operator()(int i, int j, int k);
-		virtual glm::vec3 worldToSelf(const glm::vec3& pt) const;
-	};
+		CubicGrid3d(int ghost = GRID_GHOST_LAYERS) : StaggeredGrid3d<T, STAGGER_CENTER, Layout>(ghost) {}
+		CubicGrid3d(int dim0, int dim1, int dim2, float cellSize, int ghost = GRID_GHOST_LAYERS)
+			: StaggeredGrid3d<T, STAGGER_CENTER, Layout>(dim0, dim1, dim2, cellSize, ghost) {}
 
-	// Zٶȷ
-	class GridData3dZ : public GridData3d
-	{
-	public:
-		GridData3dZ();
-		virtual ~GridData3dZ();
-		virtual void initialize(double dfltValue = 0.0);
-		virtual double& operator()(int i, int j, int k);
-		virtual glm::vec3 worldToSelf(const glm::vec3& pt) const;
+		T interpolate(const glm::vec3& pt);
+		// βֵͬ StaggeredGrid3d::interpolate
+		void interpolate(const float* x, const float* y, const float* z, T* out, int n);
 	};
 
-	// ʹβֵ
-	class CubicGridData3d : public GridData3d
+	template <typename T, int Axis, int Layout>
+	inline void swap(StaggeredGrid3d<T, Axis, Layout>& a, StaggeredGrid3d<T, Axis, Layout>& b)
 	{
-	public:
-		CubicGridData3d();
-		CubicGridData3d(const CubicGridData3d& orig);
-		virtual ~CubicGridData3d();
-		virtual double interpolate(const glm::vec3& pt);
-
-	protected:
-		// βֵ
-		double cubic(double q1, double q2, double q3, double q4, double t);
-		double interpX(int i, int j, int k, double fracty, double fractx);
-		double interpY(int i, int j, int k, double fracty);
-	};
+		a.swap(b);
+	}
+
+	typedef StaggeredGrid3d<Real, STAGGER_CENTER> GridData3d;	// Ԫĵı
+	typedef StaggeredGrid3d<Real, STAGGER_X> GridData3dX;		// Xٶȷ
+	typedef StaggeredGrid3d<Real, STAGGER_Y> GridData3dY;		// Yٶȷ
+	typedef StaggeredGrid3d<Real, STAGGER_Z> GridData3dZ;		// Zٶȷ
+	typedef CubicGrid3d<Real> CubicGridData3d;					// ʹβֵ
+	typedef StaggeredGrid3d<Real, STAGGER_CENTER, LAYOUT_BRICK> BrickGridData3d;	// 鲼ֵĵԪı
+	typedef CubicGrid3d<Real, LAYOUT_BRICK> BrickCubicGridData3d;					// 鲼֡βֵ
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,41 @@
+﻿/**
+ * GridDataSIMD.h: 网格批量插值的 AVX2 内核
+ * 对应的 GridDataSIMD.cpp 单独以 AVX2 指令集编译，由 GridData2d/3d 的批量 interpolate 调用
+ * 内核只依赖 GridSampleDesc 描述的网格参数，调用前需确认 gridSimdEnabled()
+ */
+
+#pragma once
+#ifndef __GRID_DATA_SIMD_H__
+#define __GRID_DATA_SIMD_H__
+
+namespace Glb {
+
+	// 批量插值所需的网格参数，由网格在调用前填写
+	struct GridSampleDesc
+	{
+		float cellSize;
+		float shift[3];			// 世界坐标到网格坐标的平移：交错方向为 0，其余方向为半个单元
+		float maxPos[3];		// 网格坐标的上界，即 mMax
+		int origin;				// 下标 (0, 0[, 0]) 在数据数组中的位置
+		int stride[2];			// 2D: j 方向的步长；3D: k、j 方向的步长（仅线性布局）
+	};
+
+	// 是否使用 AVX2 批量插值，CPU 不支持 AVX2 时始终为 false
+	// 由求解器后端设置，scalar / threaded 后端保持逐点插值
+	void setGridSimdEnabled(bool enabled);
+	bool gridSimdEnabled();
+
+	// 以下内核按 SIMD 宽度整批处理（双精度 4 个，单精度 8 个），返回已处理的采样数
+	// 剩余的采样由调用者逐点插值；结果与逐点插值逐位一致
+	// x、y、z 为采样点的世界坐标（SoA），结果写入 out
+	int bilinearBatchAVX2(const float* data, const GridSampleDesc& g, const float* x, const float* y, float* out, int n);
+	int bilinearBatchAVX2(const double* data, const GridSampleDesc& g, const float* x, const float* y, double* out, int n);
+	int bicubicBatchAVX2(const float* data, const GridSampleDesc& g, const float* x, const float* y, float* out, int n);
+	int bicubicBatchAVX2(const double* data, const GridSampleDesc& g, const float* x, const float* y, double* out, int n);
+	int trilinearBatchAVX2(const float* data, const GridSampleDesc& g, const float* x, const float* y, const float* z, float* out, int n);
+	int trilinearBatchAVX2(const double* data, const GridSampleDesc& g, const float* x, const float* y, const float* z, double* out, int n);
+	int tricubicBatchAVX2(const float* data, const GridSampleDesc& g, const float* x, const float* y, const float* z, float* out, int n);
+	int tricubicBatchAVX2(const double* data, const GridSampleDesc& g, const float* x, const float* y, const float* z, double* out, int n);
+}
+
+#endif // !__GRID_DATA_SIMD_H__
@@ -0,0 +1,80 @@
+﻿#pragma once
+#ifndef __MULTIGRID_H__
+#define __MULTIGRID_H__
+#include <vector>
+
+namespace Glb {
+
+	/**
+	 * 单元中心网格上的几何多重网格泊松求解器
+	 * 对流体单元 c 求解 sum_n (x_c - x_n) = b_c，n 取 c 的非固体邻居
+	 * 固体单元与网格外为 Neumann 边界，Dirichlet 单元的值固定为 0
+	 * 2D 时 nz = 1，只在 x、y 方向粗化
+	 * 粗网格的单元只要有一个子单元为 Dirichlet 即为 Dirichlet，否则只要有一个子单元为流体即为流体
+	 * 因此一个单元厚的固体墙在粗网格上消失，此时独立求解收敛很慢，应作为共轭梯度的预条件使用
+	 * 数据按 x + y * nx + z * nx * ny 存放
+	 */
+	class PoissonMultigrid {
+	public:
+		enum CellType { SOLID = 0, FLUID = 1, DIRICHLET = 2 };
+
+		PoissonMultigrid();
+
+		// 为 false 时在调用线程上串行执行
+		void setParallel(bool parallel);
+
+		// 设置网格尺寸与单元类型，与上次相同时不重建层级
+		void setup(int nx, int ny, int nz, const std::vector<unsigned char>& type);
+
+		/**
+		 * 独立求解：先做一次 FMG，再做 V-cycle 直到残差的无穷范数不超过 tolerance * max|b|
+		 * useInitialGuess 为 true 时以 x 的输入为初值，跳过 FMG 直接做 V-cycle
+		 * 非流体单元上 x 的结果为 0
+		 * @return 使用的 V-cycle 次数（FMG 计为 1 次），residual 为最终残差的无穷范数
+		 */
+		int solve(const float* b, float* x, double tolerance, int maxIterations, bool useInitialGuess, double& residual);
+
+		/**
+		 * 共轭梯度，multigridPreconditioner 为 true 时每次迭代用一次 V-cycle 作预条件，否则用对角预条件
+		 * useInitialGuess 为 true 时以 x 的输入为初值，否则从 0 开始
+		 * @return 使用的迭代次数，residual 为最终残差的无穷范数
+		 */
+		int solvePCG(const float* b, float* x, double tolerance, int maxIterations, bool multigridPreconditioner, bool useInitialGuess, double& residual);
+
+	private:
+		struct Level {
+			int nx, ny, nz;
+			std::vector<unsigned char> type;
+			std::vector<float> diag;    // 非固体邻居数，非流体单元为 0
+			std::vector<float> x, b, r;
+		};
+
+		void buildLevel(Level& level);
+		// 红黑 Gauss-Seidel，reverse 为 true 时先黑后红，前后光滑顺序相反使 V-cycle 对称
+		void smooth(Level& level, int sweeps, bool reverse);
+		// 比较 3D 最细层逐次扫描与波前推进的光滑耗时，设置 mWavefront
+		void tuneWavefront();
+		// r = b - A x，返回 r 在流体单元上的无穷范数
+		double residual(Level& level);
+		// coarse.b = 4 / 2^d * P^T fine.r，P 为 prolongate 使用的线性插值
+		void restrict(const Level& fine, Level& coarse);
+		// fine.x += P coarse.x，add 为 false 时直接赋值
+		void prolongate(const Level& coarse, Level& fine, bool add);
+		void vcycle(int l);
+		// 从 level 0 的 b 出发做一次完整多重网格，结果写入 level 0 的 x
+		void fmg();
+		// 最细层上 y = A x
+		void applyA(const std::vector<float>& x, std::vector<float>& y);
+		// 全 Neumann 时解只确定到一个常数，去掉流体单元上的均值
+		void removeMean(std::vector<float>& v);
+		double dot(const std::vector<float>& a, const std::vector<float>& b);
+
+		bool mParallel;
+		bool mSingular;                 // 最细层没有 Dirichlet 单元
+		bool mWavefront;                // 最细层的光滑使用沿 z 的波前推进
+		std::vector<Level> mLevels;
+		std::vector<float> mX, mR, mZ, mS, mQ;  // PCG 的解、残差、预条件残差、搜索方向与 A s
+	};
+}
+
+#endif
@@ -0,0 +1,108 @@
+﻿#pragma once
+#ifndef __PRESSURE_MONITOR_H__
+#define __PRESSURE_MONITOR_H__
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include "Global.h"
+
+namespace Glb {
+
+    /**
+     * 压力求解的收敛监视
+     * 固定次数的迭代求解器每 checkInterval 次迭代计算一次残差，残差不超过 tolerance * max|b| 时提前结束，b 为右端项
+     * checkInterval 为 0 时不在迭代中检查，只在结束时计算一次最终残差
+     * 压力从 0 开始迭代时初始残差即右端项的最大值，热启动时容差仍相对于右端项的最大值
+     */
+    class PressureMonitor {
+    public:
+        PressureMonitor(double tolerance, int checkInterval)
+            : mTolerance(tolerance), mInterval(checkInterval < 0 ? 0 : checkInterval),
+            mIterations(0), mChecked(0), mInitial(0.0), mReference(0.0), mResidual(0.0),
+            mStart(std::chrono::steady_clock::now()) {
+        }
+
+        void begin(double initialResidual) {
+            begin(initialResidual, initialResidual);
+        }
+
+        // 以非零初值开始迭代，rhsNorm 为右端项的最大值
+        void begin(double initialResidual, double rhsNorm) {
+            mInitial = initialResidual;
+            mReference = rhsNorm;
+            mResidual = initialResidual;
+            mIterations = 0;
+            mChecked = 0;
+        }
+
+        // 最近一次计算的残差是否满足容差，右端项为 0 或初值已足够好时一开始就已收敛
+        bool converged() const {
+            return mResidual <= mTolerance * mReference;
+        }
+
+        // 完成一次迭代，需要计算残差时返回 true
+        bool step() {
+            return step(1);
+        }
+
+        // 一次完成 count 次迭代，count 不超过 untilCheck 时与逐次调用 step() 等价
+        bool step(int count) {
+            mIterations += count;
+            return mInterval > 0 && mIterations % mInterval == 0;
+        }
+
+        // 到下一次检查残差还需的迭代次数，不超过 limit；用于把多次迭代合并执行
+        int untilCheck(int limit) const {
+            if (mInterval == 0)
+                return limit;
+            int n = mInterval - mIterations % mInterval;
+            return n < limit ? n : limit;
+        }
+
+        void update(double residual) {
+            mResidual = residual;
+            mChecked = mIterations;
+        }
+
+        // 最后一次迭代之后是否已经计算过残差
+        bool upToDate() const {
+            return mChecked == mIterations;
+        }
+
+        // 自带收敛判断的求解器（PCG、多重网格）直接给出结果
+        void finish(int iterations, double residual) {
+            mIterations = iterations;
+            update(residual);
+        }
+
+        int iterations() const {
+            return mIterations;
+        }
+
+        // 从构造到现在经过的毫秒数
+        double elapsed() const {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mStart).count();
+        }
+
+        // 把初始/最终残差写入计时器，迭代次数与耗时由调用者按帧累计
+        void report() const {
+            char text[32];
+            snprintf(text, sizeof(text), "%.3e", mInitial);
+            Timer::getInstance().recordValue("pressure initial residual", text);
+            snprintf(text, sizeof(text), "%.3e", mResidual);
+            Timer::getInstance().recordValue("pressure residual", text);
+        }
+
+    private:
+        double mTolerance;      // 相对于右端项的最大值 max|b|
+        int mInterval;          // 检查残差的间隔
+        int mIterations;        // 已完成的迭代次数
+        int mChecked;           // 最近一次计算残差时的迭代次数
+        double mInitial;        // 初始残差的无穷范数
+        double mReference;      // 右端项的无穷范数，容差相对于它
+        double mResidual;       // 最近一次计算的残差的无穷范数
+        std::chrono::steady_clock::time_point mStart;
+    };
+}
+
+#endif
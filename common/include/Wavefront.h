@@ -0,0 +1,37 @@
+﻿#pragma once
+#ifndef __WAVEFRONT_H__
+#define __WAVEFRONT_H__
+
+namespace Glb {
+
+	/**
+	 * 沿 z 方向的波前 (时间分块) 调度，把对整个体积的多次扫描合并为一次推进
+	 * 每次扫描是一次 Jacobi 迭代或红黑 Gauss-Seidel 的一个颜色，只读取相邻平面上一次扫描的结果
+	 * 第 s 步处理第 p 次扫描的平面 first + s - 2p：依赖的平面在之前的步已经完成，同一步内的各次扫描互不相关，可以一起并行
+	 * Ping-Pong 的 Jacobi 中第 p 次扫描覆盖的是第 p - 2 次的结果，它的读者也都在之前的步完成
+	 * 活跃的平面只有 2 * passes 层左右，多次扫描在缓存中完成，数据只从内存读写一遍
+	 * 平面为 [first, last)，每个平面有 rows 行，fn(pass, z, row) 处理一行
+	 */
+	template <typename Fn>
+	inline void forEachWavefront(int first, int last, int passes, int rows, bool parallel, Fn fn)
+	{
+		const int planes = last - first;
+		if (planes <= 0 || passes <= 0 || rows <= 0) {
+			return;
+		}
+		const int steps = planes + 2 * (passes - 1);
+		for (int s = 0; s < steps; s++) {
+			// 满足 0 <= s - 2p < planes 的扫描
+			int begin = s >= planes ? (s - planes + 2) / 2 : 0;
+			int end = s / 2 + 1 < passes ? s / 2 + 1 : passes;
+			int count = (end - begin) * rows;
+#pragma omp parallel for if(parallel)
+			for (int item = 0; item < count; item++) {
+				int p = begin + item / rows;
+				fn(p, first + s - 2 * p, item % rows);
+			}
+		}
+	}
+}
+
+#endif
@@ -11,6 +11,20 @@ float fontSize = 16.0f;     // 默认字体大小
 
 bool simulating = false;    // 当前是否处于仿真状态
 
+// 求解器后端名称，顺序与 SolverBackend 一致
+const char* solverBackendNames[BACKEND_COUNT] = { "scalar", "threaded", "simd", "cuda" };
+
+// 平流格式名称，顺序与 AdvectionScheme 一致
+const char* advectionSchemeNames[ADVECT_SCHEME_COUNT] = { "semi-lagrangian", "bfecc", "maccormack" };
+
+// 回溯积分方法名称，顺序与 TraceIntegrator 一致
+const char* traceIntegratorNames[TRACE_INTEGRATOR_COUNT] = { "euler", "rk2", "rk3" };
+
+// 压力求解器名称，顺序与 PressureSolver 一致
+const char* pressureSolverNames[PRESSURE_SOLVER_COUNT] = { "gauss-seidel", "pcg", "multigrid", "mgpcg", "jacobi", "rb-sor", "fft", "chebyshev", "mixed-precision" };
+
+std::string benchmarkName = "";
+
 // 2D 欧拉流体模拟参数
 namespace Eulerian2dPara
 {
@@ -34,6 +48,18 @@ namespace Eulerian2dPara
 
     // 物理参数
     float dt = 0.01;                // 时间步长
+    bool adaptiveDt = false;        // 自适应时间步长
+    float cflNumber = 5.0;          // 每个子步最多移动的单元数，半拉格朗日在 CFL > 1 时仍然稳定
+    int maxSubsteps = 8;            // 每帧的子步数上限
+    int backend = BACKEND_THREADED; // 求解器后端
+    int advectionScheme = ADVECT_SEMI_LAGRANGIAN;  // 平流格式
+    int traceIntegrator = TRACE_EULER;  // 回溯积分方法
+    int pressureSolver = PRESSURE_GAUSS_SEIDEL;    // 压力求解器
+    float pressureTolerance = 1e-4; // 压力求解的相对容差
+    int pressureMaxIterations = 200;    // 压力求解的最大迭代次数
+    float sorOmega = 1.8;           // 红黑 SOR 的松弛因子
+    int pressureCheckInterval = 0;  // 检查压力残差的迭代间隔，默认不检查，与固定次数的迭代一致
+    bool warmStartPressure = false; // 压力热启动
     float airDensity = 1.3;         // 空气密度
     float ambientTemp = 0.0;        // 环境温度
     float boussinesqAlpha = 500.0;  // Boussinesq 公式中的 alpha 系数
@@ -59,8 +85,23 @@ namespace Eulerian3dPara
     int gridNumZ = 100;             // Z 方向网格数
 
     float dt = 0.01;
+    bool adaptiveDt = false;        // 自适应时间步长
+    float cflNumber = 5.0;          // 每个子步最多移动的单元数，半拉格朗日在 CFL > 1 时仍然稳定
+    int maxSubsteps = 8;            // 每帧的子步数上限
     bool useBFECC = false;
+    int traceIntegrator = TRACE_EULER;  // 回溯积分方法
     bool useReflection = false;
+#ifdef FLUID_USE_CUDA
+    int backend = BACKEND_CUDA;     // 求解器后端
+#else
+    int backend = BACKEND_THREADED;
+#endif
+    bool sparseScalars = true;      // CPU 后端只在活跃块上平流密度与温度
+    int pressureSolver = PRESSURE_JACOBI;   // 压力求解器
+    float pressureTolerance = 1e-4; // 压力求解的相对容差
+    int pressureMaxIterations = 200;    // 压力求解的最大迭代次数
+    int pressureCheckInterval = 0;  // 检查压力残差的迭代间隔，默认不检查，与固定次数的迭代一致
+    bool warmStartPressure = false; // 压力热启动
     
     // 物理参数
     float airDensity = 1.3;         // 空气密度
@@ -74,4 +115,119 @@ std::vector<Glb::Component*> methodComponents;
 
 // 资源路径
 std::string shaderPath = "E:/File/ShanghaiTech/Course/2025_Fall/Computer_Graphics_I/Homework/project/NKU_CG_FluidSim-main/code/resources/shaders";
-std::string picturePath = "E:/File/ShanghaiTech/Course/2025_Fall/Computer_Graphics_I/Homework/project/NKU_CG_FluidSim-main/code/resources/pictures";
\ No newline at end of file
+std::string picturePath = "E:/File/ShanghaiTech/Course/2025_Fall/Computer_Graphics_I/Homework/project/NKU_CG_FluidSim-main/code/resources/pictures";
+
+// 按名称查找后端，找不到时返回 -1
+static int findBackend(const std::string& name)
+{
+    for (int i = 0; i < BACKEND_COUNT; i++) {
+        if (name == solverBackendNames[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// 按名称查找平流格式，找不到时返回 -1
+static int findAdvectionScheme(const std::string& name)
+{
+    for (int i = 0; i < ADVECT_SCHEME_COUNT; i++) {
+        if (name == advectionSchemeNames[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// 按名称查找回溯积分方法，找不到时返回 -1
+static int findTraceIntegrator(const std::string& name)
+{
+    for (int i = 0; i < TRACE_INTEGRATOR_COUNT; i++) {
+        if (name == traceIntegratorNames[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// 按名称查找压力求解器，找不到时返回 -1
+static int findPressureSolver(const std::string& name)
+{
+    for (int i = 0; i < PRESSURE_SOLVER_COUNT; i++) {
+        if (name == pressureSolverNames[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool parseCommandLine(int argc, char* argv[])
+{
+    bool ok = true;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+        if (key == "--backend" || key == "--backend2d" || key == "--backend3d") {
+            int b = findBackend(value);
+            if (b < 0) {
+                std::cerr << "Unknown backend: " << value << std::endl;
+                ok = false;
+                continue;
+            }
+            if (key != "--backend3d") {
+                Eulerian2dPara::backend = b;
+            }
+            if (key != "--backend2d") {
+                Eulerian3dPara::backend = b;
+            }
+        }
+        else if (key == "--advection2d") {
+            int s = findAdvectionScheme(value);
+            if (s < 0) {
+                std::cerr << "Unknown advection scheme: " << value << std::endl;
+                ok = false;
+                continue;
+            }
+            Eulerian2dPara::advectionScheme = s;
+        }
+        else if (key == "--trace" || key == "--trace2d" || key == "--trace3d") {
+            int t = findTraceIntegrator(value);
+            if (t < 0) {
+                std::cerr << "Unknown trace integrator: " << value << std::endl;
+                ok = false;
+                continue;
+            }
+            if (key != "--trace3d") {
+                Eulerian2dPara::traceIntegrator = t;
+            }
+            if (key != "--trace2d") {
+                Eulerian3dPara::traceIntegrator = t;
+            }
+        }
+        else if (key == "--pressure2d" || key == "--pressure3d") {
+            int s = findPressureSolver(value);
+            if (s < 0) {
+                std::cerr << "Unknown pressure solver: " << value << std::endl;
+                ok = false;
+                continue;
+            }
+            if (key == "--pressure2d") {
+                Eulerian2dPara::pressureSolver = s;
+            }
+            else {
+                Eulerian3dPara::pressureSolver = s;
+            }
+        }
+        else if (key == "--benchmark") {
+            benchmarkName = value;
+        }
+        else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,514 @@
+﻿/**
+ * FastPoisson.cpp: 基于 FFT 的快速泊松求解器实现
+ * DCT-II 用 Makhoul 的 n 点 FFT 算法计算，DST-I 用 Numerical Recipes 中 sinft 的 n + 1 点 FFT 算法计算
+ */
+
+#include "FastPoisson.h"
+#include <cmath>
+#include <utility>
+
+namespace Glb {
+
+	static const double PI = 3.14159265358979323846;
+
+	// 不处理 inf/nan 的复数乘法，std::complex 的乘法在部分编译器上会调用较慢的库函数
+	static inline Complex mul(const Complex& a, const Complex& b)
+	{
+		return Complex(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+	}
+
+	// 混合基变换支持的最大素因子，含更大素因子的长度使用 Bluestein 算法
+	static const int MAX_RADIX = 7;
+
+	// 把 n 分解为 4、2、3、5、7 的乘积，不能分解时返回 false
+	static bool factorize(int n, std::vector<int>& radix)
+	{
+		radix.clear();
+		static const int candidates[5] = { 4, 2, 3, 5, 7 };
+		for (int c = 0; c < 5; c++) {
+			while (n % candidates[c] == 0) {
+				radix.push_back(candidates[c]);
+				n /= candidates[c];
+			}
+		}
+		return n == 1;
+	}
+
+	static bool smooth23(int n)
+	{
+		while (n % 2 == 0) {
+			n /= 2;
+		}
+		while (n % 3 == 0) {
+			n /= 3;
+		}
+		return n == 1;
+	}
+
+	FFT::FFT()
+		: mN(0), mM(0)
+	{
+	}
+
+	void FFT::setup(int n)
+	{
+		if (n == mN) {
+			return;
+		}
+		mN = n;
+		mChirp.clear();
+		mKernel.clear();
+		if (factorize(n, mRadix)) {
+			mM = n;
+		}
+		else {
+			// 循环卷积的长度不小于 2n - 1，取只含因子 2、3 的最小长度
+			mM = 2 * n - 1;
+			while (!smooth23(mM)) {
+				mM++;
+			}
+			factorize(mM, mRadix);
+		}
+
+		mTwiddle.resize(mM);
+		for (int k = 0; k < mM; k++) {
+			mTwiddle[k] = std::polar(1.0, -2.0 * PI * k / mM);
+		}
+		if (mM == n) {
+			return;
+		}
+
+		// j k = (j^2 + k^2 - (k - j)^2) / 2，j^2 对 2n 取模以保持角度的精度
+		mChirp.resize(n);
+		for (int j = 0; j < n; j++) {
+			long long j2 = (long long)j * j % (2LL * n);
+			mChirp[j] = std::polar(1.0, -PI * (double)j2 / n);
+		}
+		mKernel.assign(mM, Complex(0.0, 0.0));
+		for (int m = 0; m < n; m++) {
+			mKernel[m] = std::conj(mChirp[m]);
+			if (m > 0) {
+				mKernel[mM - m] = std::conj(mChirp[m]);
+			}
+		}
+		std::vector<Complex> work(mM);
+		stockham(mKernel.data(), work.data());
+		for (int m = 0; m < mM; m++) {
+			mKernel[m] /= (double)mM;
+		}
+	}
+
+	void FFT::stockham(Complex* data, Complex* work) const
+	{
+		// 每一级把长度为 n 的 s 个交错子序列各拆成 p 个长度为 m 的子序列，结果在 x 与 y 之间交替
+		Complex* x = data;
+		Complex* y = work;
+		int n = mM, s = 1;
+		for (size_t stage = 0; stage < mRadix.size(); stage++) {
+			const int p = mRadix[stage];
+			const int m = n / p;
+			const int step = mM / n;
+			const int root = mM / p;
+			for (int q = 0; q < m; q++) {
+				Complex w[MAX_RADIX];
+				for (int t = 0; t < p; t++) {
+					w[t] = mTwiddle[q * t * step];
+				}
+				Complex* in = x + s * q;
+				Complex* out = y + s * p * q;
+				if (p == 2) {
+					for (int k = 0; k < s; k++) {
+						Complex a0 = in[k], a1 = in[k + s * m];
+						out[k] = a0 + a1;
+						out[k + s] = mul(a0 - a1, w[1]);
+					}
+				}
+				else if (p == 4) {
+					for (int k = 0; k < s; k++) {
+						Complex a0 = in[k], a1 = in[k + s * m], a2 = in[k + 2 * s * m], a3 = in[k + 3 * s * m];
+						Complex t0 = a0 + a2, t1 = a0 - a2, t2 = a1 + a3, t3 = a1 - a3;
+						// 乘以 -i
+						t3 = Complex(t3.imag(), -t3.real());
+						out[k] = t0 + t2;
+						out[k + s] = mul(t1 + t3, w[1]);
+						out[k + 2 * s] = mul(t0 - t2, w[2]);
+						out[k + 3 * s] = mul(t1 - t3, w[3]);
+					}
+				}
+				else {
+					for (int k = 0; k < s; k++) {
+						Complex a[MAX_RADIX];
+						for (int r = 0; r < p; r++) {
+							a[r] = in[k + s * m * r];
+						}
+						for (int t = 0; t < p; t++) {
+							Complex sum = a[0];
+							int e = 0;
+							for (int r = 1; r < p; r++) {
+								e += t;
+								if (e >= p) {
+									e -= p;
+								}
+								sum += mul(a[r], mTwiddle[e * root]);
+							}
+							out[k + s * t] = t == 0 ? sum : mul(sum, w[t]);
+						}
+					}
+				}
+			}
+			std::swap(x, y);
+			n = m;
+			s *= p;
+		}
+		if (x != data) {
+			for (int k = 0; k < mM; k++) {
+				data[k] = x[k];
+			}
+		}
+	}
+
+	void FFT::forward(Complex* data, Complex* work) const
+	{
+		if (mChirp.empty()) {
+			stockham(data, work);
+			return;
+		}
+
+		// Bluestein: X_k = c_k sum_j (x_j c_j) conj(c_{k-j})，卷积放在 work 的前半部分，后半部分为变换的缓冲
+		Complex* conv = work;
+		Complex* scratch = work + mM;
+		for (int j = 0; j < mM; j++) {
+			conv[j] = j < mN ? mul(data[j], mChirp[j]) : Complex(0.0, 0.0);
+		}
+		stockham(conv, scratch);
+		// 逆变换通过共轭转换为正变换
+		for (int j = 0; j < mM; j++) {
+			conv[j] = std::conj(mul(conv[j], mKernel[j]));
+		}
+		stockham(conv, scratch);
+		for (int j = 0; j < mN; j++) {
+			conv[j] = std::conj(conv[j]);
+		}
+		for (int k = 0; k < mN; k++) {
+			data[k] = mul(conv[k], mChirp[k]);
+		}
+	}
+
+	void FFT::inverse(Complex* data, Complex* work) const
+	{
+		for (int j = 0; j < mN; j++) {
+			data[j] = std::conj(data[j]);
+		}
+		forward(data, work);
+		for (int j = 0; j < mN; j++) {
+			data[j] = std::conj(data[j]);
+		}
+	}
+
+	FastPoisson::FastPoisson()
+		: mParallel(true), mBoundary(NEUMANN), mNumAxes(0)
+	{
+		mDim[0] = mDim[1] = mDim[2] = 0;
+	}
+
+	void FastPoisson::setParallel(bool parallel)
+	{
+		mParallel = parallel;
+	}
+
+	void FastPoisson::setup(int nx, int ny, int nz, Boundary boundary)
+	{
+		if (mDim[0] == nx && mDim[1] == ny && mDim[2] == nz && mBoundary == boundary) {
+			return;
+		}
+		mDim[0] = nx;
+		mDim[1] = ny;
+		mDim[2] = nz;
+		mBoundary = boundary;
+		mNumAxes = nz > 1 ? 2 : 1;
+
+		int strides[3] = { 1, nx, nx * ny };
+		int size = nx * ny * nz;
+		for (int a = 0; a < 3; a++) {
+			mAxes[a].n = mDim[a];
+			mAxes[a].stride = strides[a];
+			mAxes[a].lines = size / mDim[a];
+			if (a < mNumAxes) {
+				setupAxis(mAxes[a], mDim[a]);
+			}
+		}
+		mData.resize(size);
+
+		// 频率 c 在前 mNumAxes 个方向上的下标为 (c / stride) % n
+		int count = mAxes[mNumAxes].stride;
+		mLambda.resize(count);
+		mNorm.resize(count);
+		for (int c = 0; c < count; c++) {
+			mLambda[c] = 0.0;
+			mNorm[c] = 1.0;
+			for (int a = 0; a < mNumAxes; a++) {
+				int k = (c / mAxes[a].stride) % mAxes[a].n;
+				mLambda[c] += mAxes[a].eigen[k];
+				mNorm[c] *= mAxes[a].norm[k];
+			}
+		}
+	}
+
+	void FastPoisson::setupAxis(Axis& axis, int n)
+	{
+		axis.n = n;
+		axis.eigen.resize(n);
+		axis.norm.resize(n);
+		if (mBoundary == NEUMANN) {
+			// n 点 FFT 计算 DCT-II，order[p] 为重排后第 p 个元素在直线上的位置
+			axis.fft.setup(n);
+			axis.shift.resize(n);
+			axis.order.resize(n);
+			for (int p = 0; p < n; p++) {
+				axis.order[p] = 2 * p < n ? 2 * p : 2 * (n - 1 - p) + 1;
+			}
+			for (int k = 0; k < n; k++) {
+				axis.shift[k] = std::polar(1.0, -PI * k / (2.0 * n));
+				axis.eigen[k] = 2.0 - 2.0 * std::cos(PI * k / n);
+				axis.norm[k] = k == 0 ? n : 0.5 * n;
+			}
+		}
+		else {
+			// n + 1 点 FFT 计算 DST-I
+			axis.fft.setup(n + 1);
+			axis.shift.clear();
+			axis.order.clear();
+			axis.sine.resize(n + 1);
+			for (int j = 0; j <= n; j++) {
+				axis.sine[j] = std::sin(PI * j / (n + 1));
+			}
+			for (int k = 0; k < n; k++) {
+				axis.eigen[k] = 2.0 - 2.0 * std::cos(PI * (k + 1) / (n + 1));
+				axis.norm[k] = 0.5 * (n + 1);
+			}
+		}
+	}
+
+	int FastPoisson::lineStart(int a, int line) const
+	{
+		int nx = mDim[0], ny = mDim[1];
+		if (a == 0) {
+			return line * nx;
+		}
+		if (a == 1) {
+			return line % nx + (line / nx) * nx * ny;
+		}
+		return line;
+	}
+
+	void FastPoisson::transform(int a, bool transpose)
+	{
+		const Axis& axis = mAxes[a];
+		const int n = axis.n;
+		const int m = axis.fft.size();
+		const int stride = axis.stride;
+		const int pairs = (axis.lines + 1) / 2;
+		const bool neumann = mBoundary == NEUMANN;
+		const Complex half(0.5, 0.0), minusHalfI(0.0, -0.5);
+#pragma omp parallel if(mParallel)
+		{
+			std::vector<Complex> buffer(m), work(axis.fft.workSize());
+			// 两条实数直线分别放在实部与虚部，一次复数 FFT 同时变换两条，最后一条单独时虚部为 0
+#pragma omp for
+			for (int pair = 0; pair < pairs; pair++) {
+				double* x = mData.data() + lineStart(a, 2 * pair);
+				double* y = 2 * pair + 1 < axis.lines ? mData.data() + lineStart(a, 2 * pair + 1) : nullptr;
+
+				if (neumann && transpose) {
+					// C^T z: V_k = (z_k - i z_{n-k}) e^{pi i k / (2n)}，z_0 之外的系数减半，逆 FFT 的结果为实数
+					for (int k = 0; k < n; k++) {
+						double s = k == 0 ? 1.0 : 0.5;
+						double x0 = s * x[k * stride], x1 = k == 0 ? 0.0 : s * x[(n - k) * stride];
+						double y0 = y ? s * y[k * stride] : 0.0, y1 = y && k > 0 ? s * y[(n - k) * stride] : 0.0;
+						Complex w = std::conj(axis.shift[k]);
+						buffer[k] = mul(Complex(x0, -x1), w) + mul(Complex(y1, y0), w);
+					}
+					axis.fft.inverse(buffer.data(), work.data());
+					for (int p = 0; p < n; p++) {
+						int i = axis.order[p];
+						x[i * stride] = buffer[p].real();
+						if (y) {
+							y[i * stride] = buffer[p].imag();
+						}
+					}
+				}
+				else if (neumann) {
+					// Makhoul: v = (x_0, x_2, x_4, ..., x_3, x_1)，X_k = Re(e^{-pi i k / (2n)} V_k)
+					for (int p = 0; p < n; p++) {
+						int i = axis.order[p];
+						buffer[p] = Complex(x[i * stride], y ? y[i * stride] : 0.0);
+					}
+					axis.fft.forward(buffer.data(), work.data());
+					for (int k = 0; k < n; k++) {
+						Complex z = buffer[k], zc = std::conj(buffer[k == 0 ? 0 : n - k]);
+						x[k * stride] = mul(mul(z + zc, half), axis.shift[k]).real();
+						if (y) {
+							y[k * stride] = mul(mul(z - zc, minusHalfI), axis.shift[k]).real();
+						}
+					}
+				}
+				else {
+					// DST-I (Numerical Recipes sinft): u_j = sin(pi j / N) (x_j + x_{N-j}) + (x_j - x_{N-j}) / 2，N = n + 1
+					// 由 N 点 FFT 的 U_k 得到 X_{2k} = -Im(U_k)，X_{2k+1} = X_{2k-1} + Re(U_k)，X_1 = Re(U_0) / 2
+					// 下标从 1 开始，x_j 位于直线的第 j - 1 个单元；DST-I 的矩阵是对称的，转置变换与正变换相同
+					buffer[0] = Complex(0.0, 0.0);
+					for (int j = 1; j <= n; j++) {
+						double xa = x[(j - 1) * stride], xb = x[(n - j) * stride];
+						double ya = y ? y[(j - 1) * stride] : 0.0, yb = y ? y[(n - j) * stride] : 0.0;
+						double s = axis.sine[j];
+						buffer[j] = Complex(s * (xa + xb) + 0.5 * (xa - xb), s * (ya + yb) + 0.5 * (ya - yb));
+					}
+					axis.fft.forward(buffer.data(), work.data());
+
+					double oddX = 0.0, oddY = 0.0;
+					for (int k = 0; 2 * k <= n; k++) {
+						Complex z = buffer[k], zc = std::conj(buffer[k == 0 ? 0 : m - k]);
+						Complex ux = mul(z + zc, half), uy = mul(z - zc, minusHalfI);
+						if (k > 0) {
+							x[(2 * k - 1) * stride] = -ux.imag();
+							if (y) {
+								y[(2 * k - 1) * stride] = -uy.imag();
+							}
+						}
+						if (2 * k + 1 <= n) {
+							oddX = k == 0 ? 0.5 * ux.real() : oddX + ux.real();
+							oddY = k == 0 ? 0.5 * uy.real() : oddY + uy.real();
+							x[2 * k * stride] = oddX;
+							if (y) {
+								y[2 * k * stride] = oddY;
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	void FastPoisson::solveLines()
+	{
+		// 第 c 条直线为 (lambda_c + L) x = b，L 是一维 Laplace 算子，直线之间相距 1，每次处理相邻的一段直线
+		const Axis& axis = mAxes[mNumAxes];
+		const int n = axis.n;
+		const int count = axis.stride;
+		const int chunk = 64;
+		const int chunks = (count + chunk - 1) / chunk;
+		const bool neumann = mBoundary == NEUMANN;
+#pragma omp parallel if(mParallel)
+		{
+			std::vector<double> upper(n * chunk);
+#pragma omp for
+			for (int block = 0; block < chunks; block++) {
+				const int begin = block * chunk;
+				const int end = begin + chunk < count ? begin + chunk : count;
+				const int width = end - begin;
+				double* v = mData.data() + begin;
+				double* u = upper.data();
+
+				// 消元: upper_k = -1 / m_k, v_k = (v_k + v_{k-1}) / m_k, m_k = d_k + upper_{k-1}
+				for (int k = 0; k < n; k++) {
+					double* vk = v + k * count;
+					double* uk = u + k * width;
+					double edge = neumann && (k == 0 || k == n - 1) ? 1.0 : 2.0;
+					for (int l = 0; l < width; l++) {
+						double lambda = mLambda[begin + l];
+						if (neumann && lambda <= 1e-12 && k == 0) {
+							// 全 Neumann 的零频率方程奇异，固定 x_0 = 0，最后再去掉均值
+							vk[l] = 0.0;
+							uk[l] = 0.0;
+							continue;
+						}
+						double diag = lambda + (n == 1 ? 0.0 : edge);
+						if (k > 0) {
+							diag += u[(k - 1) * width + l];
+							vk[l] = (vk[l] + vk[l - count]) / diag;
+						}
+						else {
+							vk[l] = vk[l] / diag;
+						}
+						uk[l] = -1.0 / diag;
+					}
+				}
+				for (int k = n - 2; k >= 0; k--) {
+					double* vk = v + k * count;
+					double* uk = u + k * width;
+					for (int l = 0; l < width; l++) {
+						vk[l] -= uk[l] * vk[l + count];
+					}
+				}
+
+				for (int l = 0; l < width; l++) {
+					double norm = mNorm[begin + l];
+					if (neumann && mLambda[begin + l] <= 1e-12) {
+						double mean = 0.0;
+						for (int k = 0; k < n; k++) {
+							mean += v[k * count + l];
+						}
+						mean /= n;
+						for (int k = 0; k < n; k++) {
+							v[k * count + l] -= mean;
+						}
+					}
+					for (int k = 0; k < n; k++) {
+						v[k * count + l] /= norm;
+					}
+				}
+			}
+		}
+	}
+
+	void FastPoisson::solveData()
+	{
+		const int size = (int)mData.size();
+		double* v = mData.data();
+
+		// 全 Neumann 时方程只在 b 与常数正交时有解
+		if (mBoundary == NEUMANN) {
+			double sum = 0.0;
+			for (int c = 0; c < size; c++) {
+				sum += v[c];
+			}
+			double mean = sum / size;
+			for (int c = 0; c < size; c++) {
+				v[c] -= mean;
+			}
+		}
+
+		// A = T^-1 (Lambda + L) T，T^-1 = T^T N^-1，N 为 T 各行的范数平方
+		for (int a = 0; a < mNumAxes; a++) {
+			transform(a, false);
+		}
+		solveLines();
+		for (int a = 0; a < mNumAxes; a++) {
+			transform(a, true);
+		}
+	}
+
+	void FastPoisson::solve(const double* b, double* x)
+	{
+		int size = (int)mData.size();
+		for (int c = 0; c < size; c++) {
+			mData[c] = b[c];
+		}
+		solveData();
+		for (int c = 0; c < size; c++) {
+			x[c] = mData[c];
+		}
+	}
+
+	void FastPoisson::solve(const float* b, float* x)
+	{
+		int size = (int)mData.size();
+		for (int c = 0; c < size; c++) {
+			mData[c] = b[c];
+		}
+		solveData();
+		for (int c = 0; c < size; c++) {
+			x[c] = (float)mData[c];
+		}
+	}
+}
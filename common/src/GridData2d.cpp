@@ -1,269 +1,229 @@
 #include "GridData2d.h"
 #include "Configure.h"
+#include "Global.h"
+#include <algorithm>
+#include <utility>
 
 namespace Glb
 {
+    // 开关放在未以 AVX2 编译的文件中，不支持 AVX2 的 CPU 上也可以安全调用
+    static bool sGridSimd = false;
 
-    GridData2d::GridData2d() : mDfltValue(0.0), mMax(0.0, 0.0), cellSize(Eulerian2dPara::theCellSize2d)
+    void setGridSimdEnabled(bool enabled)
     {
-        dim[0] = Eulerian2dPara::theDim2d[0];
-        dim[1] = Eulerian2dPara::theDim2d[1];
+        sGridSimd = enabled && cpuSupportsAVX2();
     }
 
-    GridData2d::GridData2d(const GridData2d &orig) : mDfltValue(orig.mDfltValue)
+    bool gridSimdEnabled()
     {
-        mData = orig.mData;
-        mMax = orig.mMax;
-        cellSize = orig.cellSize;
-        dim[0] = orig.dim[0];
-        dim[1] = orig.dim[1];
+        return sGridSimd;
     }
 
-    GridData2d::~GridData2d()
+    template <typename T, int Axis>
+    StaggeredGrid2d<T, Axis>::StaggeredGrid2d(int ghost)
+        : StaggeredGrid2d(Eulerian2dPara::theDim2d[0], Eulerian2dPara::theDim2d[1], Eulerian2dPara::theCellSize2d, ghost)
     {
     }
 
-    ublas::vector<double> &GridData2d::data()
+    template <typename T, int Axis>
+    StaggeredGrid2d<T, Axis>::StaggeredGrid2d(int dim0, int dim1, float cellSize, int ghost)
+        : mDfltValue(0), mMax(0.0, 0.0), cellSize(cellSize), mGhost(ghost)
     {
-        return mData;
+        dim[0] = dim0;
+        dim[1] = dim1;
+        mSize[0] = dim[0] + (Axis == STAGGER_X ? 1 : 0);
+        mSize[1] = dim[1] + (Axis == STAGGER_Y ? 1 : 0);
+        mStride = mSize[0] + 2 * mGhost;
+        mOrigin = mGhost + mGhost * mStride;
     }
 
-    GridData2d &GridData2d::operator=(const GridData2d &orig)
+    template <typename T, int Axis>
+    void StaggeredGrid2d<T, Axis>::swap(StaggeredGrid2d& other)
     {
-        if (this == &orig)
-        {
-            return *this;
-        }
-        mData = orig.mData;
-        mMax = orig.mMax;
-        cellSize = orig.cellSize;
-        dim[0] = orig.dim[0];
-        dim[1] = orig.dim[1];
-        return *this;
+        std::swap(mDfltValue, other.mDfltValue);
+        std::swap(mMax, other.mMax);
+        mData.swap(other.mData);
+        std::swap(cellSize, other.cellSize);
+        std::swap(dim, other.dim);
+        std::swap(mSize, other.mSize);
+        std::swap(mGhost, other.mGhost);
+        std::swap(mStride, other.mStride);
+        std::swap(mOrigin, other.mOrigin);
     }
 
-    void GridData2d::initialize(double dfltValue)
+    template <typename T, int Axis>
+    void StaggeredGrid2d<T, Axis>::copyFrom(const StaggeredGrid2d& other)
     {
-        mDfltValue = dfltValue;
-        mMax[0] = cellSize * dim[0];
-        mMax[1] = cellSize * dim[1];
-        mData.resize(dim[0] * dim[1], false);
-        std::fill(mData.begin(), mData.end(), mDfltValue);
+        mDfltValue = other.mDfltValue;
+        mMax = other.mMax;
+        cellSize = other.cellSize;
+        dim[0] = other.dim[0]; dim[1] = other.dim[1];
+        mSize[0] = other.mSize[0]; mSize[1] = other.mSize[1];
+        mGhost = other.mGhost;
+        mStride = other.mStride;
+        mOrigin = other.mOrigin;
+        if (mData.size() == other.mData.size())
+            std::copy(other.mData.begin(), other.mData.end(), mData.begin());
+        else
+            mData = other.mData;
     }
 
-    double &GridData2d::operator()(int i, int j)
+    template <typename T, int Axis>
+    void StaggeredGrid2d<T, Axis>::initialize(T dfltValue)
     {
-        static double dflt = 0;
-        dflt = mDfltValue; // HACK: Protect against setting the default value
-
-        if (i < 0 || j < 0 ||
-            i > dim[0] - 1 ||
-            j > dim[1] - 1)
-            return dflt;
+        mDfltValue = dfltValue;
+        mMax[0] = cellSize * mSize[0]; // 交错方向 plus one
+        mMax[1] = cellSize * mSize[1];
+        mData.assign(mStride * (mSize[1] + 2 * mGhost), mDfltValue);
+    }
 
-        int col = i;
-        int row = j * dim[0];
+    template <typename T, int Axis>
+    void StaggeredGrid2d<T, Axis>::fillBoundary()
+    {
+        // 单元中心的数据越界时一律为默认值，幽灵单元在 initialize 之后不会改变
+        if (Axis == STAGGER_CENTER)
+            return;
 
-        return mData(col + row);
+        for (int j = -mGhost; j < mSize[1] + mGhost; j++)
+        {
+            bool rowInside = j >= 0 && j < mSize[1];
+            int jc = j < 0 ? 0 : (j > mSize[1] - 1 ? mSize[1] - 1 : j);
+            for (int i = -mGhost; i < mSize[0] + mGhost; i++)
+            {
+                // 内部行只需处理两侧的幽灵单元
+                if (rowInside && i == 0)
+                    i = mSize[0];
+
+                int ic = i < 0 ? 0 : (i > mSize[0] - 1 ? mSize[0] - 1 : i);
+                bool staggeredOut = Axis == STAGGER_X ? ic != i : jc != j;
+                (*this)(i, j) = staggeredOut ? mDfltValue : (*this)(ic, jc);
+            }
+        }
     }
 
-    void GridData2d::getCell(const glm::vec2 &pt, int &i, int &j)
+    template <typename T, int Axis>
+    void StaggeredGrid2d<T, Axis>::getCell(const glm::vec2 &pt, int &i, int &j)
     {
         glm::vec2 pos = worldToSelf(pt);
         i = (int)(pos[0] / cellSize);
         j = (int)(pos[1] / cellSize);
     }
 
-    double GridData2d::interpolate(const glm::vec2 &pt)
+    template <typename T, int Axis>
+    T StaggeredGrid2d<T, Axis>::interpolate(const glm::vec2 &pt)
     {
         glm::vec2 pos = worldToSelf(pt);
 
         int i = (int)(pos[0] / cellSize);
         int j = (int)(pos[1] / cellSize);
 
-        double scale = 1.0 / cellSize;
-        double fractx = scale * (pos[0] - i * cellSize);
-        double fracty = scale * (pos[1] - j * cellSize);
+        T scale = 1.0 / cellSize;
+        T fractx = scale * (pos[0] - i * cellSize);
+        T fracty = scale * (pos[1] - j * cellSize);
 
         assert(fractx < 1.0 && fractx >= 0);
         assert(fracty < 1.0 && fracty >= 0);
 
-        double tmp1 = (*this)(i, j);
-        double tmp2 = (*this)(i, j + 1);
-        double tmp3 = (*this)(i + 1, j);
-        double tmp4 = (*this)(i + 1, j + 1);
+        T tmp1 = (*this)(i, j);
+        T tmp2 = (*this)(i, j + 1);
+        T tmp3 = (*this)(i + 1, j);
+        T tmp4 = (*this)(i + 1, j + 1);
 
-        double tmp12 = LERP(tmp1, tmp2, fracty);
-        double tmp34 = LERP(tmp3, tmp4, fracty);
+        T tmp12 = LERP(tmp1, tmp2, fracty);
+        T tmp34 = LERP(tmp3, tmp4, fracty);
 
-        double tmp = LERP(tmp12, tmp34, fractx);
+        T tmp = LERP(tmp12, tmp34, fractx);
         return tmp;
     }
 
-    glm::vec2 GridData2d::worldToSelf(const glm::vec2 &pt) const
-    {
-        glm::vec2 out;
-        out[0] = min(max(0.0, pt[0] - cellSize * 0.5), mMax[0]);
-        out[1] = min(max(0.0, pt[1] - cellSize * 0.5), mMax[1]);
-        return out;
-    }
-
-    GridData2dX::GridData2dX() : GridData2d()
-    {
-    }
-
-    GridData2dX::~GridData2dX()
-    {
-    }
-
-    void GridData2dX::initialize(double dfltValue)
-    {
-        GridData2d::initialize(dfltValue);
-        mMax[0] = cellSize * (dim[0] + 1); // plus one
-        mMax[1] = cellSize * dim[1];
-        mData.resize((dim[0] + 1) * dim[1], false);
-        std::fill(mData.begin(), mData.end(), mDfltValue);
-    }
-
-    double &GridData2dX::operator()(int i, int j)
+    template <typename T, int Axis>
+    void StaggeredGrid2d<T, Axis>::getRange(const glm::vec2 &pt, T &lo, T &hi)
     {
-        static double dflt = 0;
-        dflt = mDfltValue;
-
-        if (i < 0 || i > dim[0])
-            return dflt;
-
-        if (j < 0)
-            j = 0;
-        if (j > dim[1] - 1)
-            j = dim[1] - 1;
-
-        int col = i;
-        int row = j * (dim[0] + 1);
-
-        return mData(row + col);
-    }
+        glm::vec2 pos = worldToSelf(pt);
 
-    glm::vec2 GridData2dX::worldToSelf(const glm::vec2 &pt) const
-    {
-        glm::vec2 out;
-        out[0] = min(max(0.0, pt[0]), mMax[0]);
-        out[1] = min(max(0.0, pt[1] - cellSize * 0.5), mMax[1]);
-        return out;
-    }
+        int i = (int)(pos[0] / cellSize);
+        int j = (int)(pos[1] / cellSize);
 
-    GridData2dY::GridData2dY() : GridData2d()
-    {
-    }
+        T tmp1 = (*this)(i, j);
+        T tmp2 = (*this)(i, j + 1);
+        T tmp3 = (*this)(i + 1, j);
+        T tmp4 = (*this)(i + 1, j + 1);
 
-    GridData2dY::~GridData2dY()
-    {
+        T lo12 = tmp1 < tmp2 ? tmp1 : tmp2, hi12 = tmp1 < tmp2 ? tmp2 : tmp1;
+        T lo34 = tmp3 < tmp4 ? tmp3 : tmp4, hi34 = tmp3 < tmp4 ? tmp4 : tmp3;
+        lo = lo12 < lo34 ? lo12 : lo34;
+        hi = hi12 < hi34 ? hi34 : hi12;
     }
 
-    void GridData2dY::initialize(double dfltValue)
+    template <typename T, int Axis>
+    void StaggeredGrid2d<T, Axis>::interpolate(const float* x, const float* y, T* out, int n)
     {
-        GridData2d::initialize(dfltValue);
-        mMax[0] = cellSize * dim[0];
-        mMax[1] = cellSize * (dim[1] + 1);
-        mData.resize(dim[0] * (dim[1] + 1), false);
-        std::fill(mData.begin(), mData.end(), mDfltValue);
+        int s = 0;
+        if (sGridSimd)
+            s = bilinearBatchAVX2(mData.data(), sampleDesc(), x, y, out, n);
+        for (; s < n; s++)
+            out[s] = interpolate(glm::vec2(x[s], y[s]));
     }
 
-    double &GridData2dY::operator()(int i, int j)
+    template <typename T, int Axis>
+    GridSampleDesc StaggeredGrid2d<T, Axis>::sampleDesc() const
     {
-        static double dflt = 0;
-        dflt = mDfltValue; // Protect against setting the default value
-
-        if (j < 0 || j > dim[1])
-            return dflt;
-
-        if (i < 0)
-            i = 0;
-        if (i > dim[0] - 1)
-            i = dim[0] - 1;
-
-        int col = i;
-        int row = j * dim[0];
-
-        return mData(row + col);
+        GridSampleDesc g;
+        g.cellSize = cellSize;
+        g.shift[0] = Axis == STAGGER_X ? 0.0f : cellSize * 0.5f;
+        g.shift[1] = Axis == STAGGER_Y ? 0.0f : cellSize * 0.5f;
+        g.shift[2] = 0.0f;
+        g.maxPos[0] = mMax[0];
+        g.maxPos[1] = mMax[1];
+        g.maxPos[2] = 0.0f;
+        g.origin = mOrigin;
+        g.stride[0] = mStride;
+        g.stride[1] = 0;
+        return g;
     }
 
-    glm::vec2 GridData2dY::worldToSelf(const glm::vec2 &pt) const
+    template <typename T, int Axis>
+    glm::vec2 StaggeredGrid2d<T, Axis>::worldToSelf(const glm::vec2 &pt) const
     {
+        // 交错方向上数据位于面中心，不需要半个单元的偏移
         glm::vec2 out;
-        out[0] = min(max(0.0, pt[0] - cellSize * 0.5), mMax[0]);
-        out[1] = min(max(0.0, pt[1]), mMax[1]);
+        out[0] = min(max(0.0, pt[0] - (Axis == STAGGER_X ? 0.0 : cellSize * 0.5)), mMax[0]);
+        out[1] = min(max(0.0, pt[1] - (Axis == STAGGER_Y ? 0.0 : cellSize * 0.5)), mMax[1]);
         return out;
     }
 
-    CubicGridData2d::CubicGridData2d() : GridData2d()
-    {
-    }
-
-    CubicGridData2d::CubicGridData2d(const CubicGridData2d &orig) : GridData2d(orig)
-    {
-    }
-
-    CubicGridData2d::~CubicGridData2d()
-    {
-    }
-
-    double CubicGridData2d::cubic(double q1, double q2, double q3, double q4, double t)
-    {
-        double deltaq = q3 - q2;
-        double d1 = (q3 - q1) * 0.5;
-        double d2 = (q4 - q2) * 0.5;
-
-        // Force monotonic: if d1/d2 differ in sign to deltaq, make it zero
-        if (deltaq > 0.0001)
-        {
-            d1 = d1 > 0 ? d1 : 0.0;
-            d2 = d2 > 0 ? d2 : 0.0;
-        }
-        else if (deltaq < 0.0001)
-        {
-            d1 = d1 < 0 ? d1 : 0.0;
-            d2 = d2 < 0 ? d2 : 0.0;
-        }
-
-        double tmp = q2 + d1 * t + (3 * deltaq - 2 * d1 - d2) * t * t + (-2 * deltaq + d1 + d2) * t * t * t;
-        return tmp;
-    }
-
-    double CubicGridData2d::interpY(int i, int j, double fracty)
-    {
-        double tmp1 = (*this)(i, j - 1 < 0 ? j : j - 1);
-        double tmp2 = (*this)(i, j);
-        double tmp3 = (*this)(i, j + 1);
-        double tmp4 = (*this)(i, j + 2);
-        return cubic(tmp1, tmp2, tmp3, tmp4, fracty);
-    }
-
-    double CubicGridData2d::interpX(int i, int j, double fracty, double fractx)
-    {
-        double tmp1 = interpY(i - 1 < 0 ? i : i - 1, j, fracty); // hack
-        double tmp2 = interpY(i, j, fracty);
-        double tmp3 = interpY(i + 1, j, fracty);
-        double tmp4 = interpY(i + 2, j, fracty);
-        return cubic(tmp1, tmp2, tmp3, tmp4, fractx);
-    }
-
-    double CubicGridData2d::interpolate(const glm::vec2 &pt)
+    template <typename T>
+    T CubicGrid2d<T>::interpolate(const glm::vec2 &pt)
     {
         // Bicubic Interpolation
-        glm::vec2 pos = worldToSelf(pt);
+        glm::vec2 pos = this->worldToSelf(pt);
+        float cellSize = this->cellSize;
 
         int i = (int)(pos[0] / cellSize);
         int j = (int)(pos[1] / cellSize);
 
-        double scale = 1.0 / cellSize;
-        double fractx = scale * (pos[0] - i * cellSize);
-        double fracty = scale * (pos[1] - j * cellSize);
+        T scale = 1.0 / cellSize;
+        T fractx = scale * (pos[0] - i * cellSize);
+        T fracty = scale * (pos[1] - j * cellSize);
 
         assert(fractx < 1.0 && fractx >= 0);
         assert(fracty < 1.0 && fracty >= 0);
 
-        double tmp = interpX(i, j, fracty, fractx);
+        // 4x4 模板在各方向上的偏移，低侧越界时钳制到自身
+        int stride = this->mStride;
+        int oi[4] = { i - 1 < 0 ? i : i - 1, i, i + 1, i + 2 };
+        int oj[4] = { (j - 1 < 0 ? j : j - 1) * stride, j * stride, (j + 1) * stride, (j + 2) * stride };
+
+        // q[r * 4 + a]: 第 a 列 (i 方向) 的第 r 个点 (j 方向)
+        const T* data = this->mData.data() + this->mOrigin;
+        T q[16];
+        for (int r = 0; r < 4; r++)
+            for (int a = 0; a < 4; a++)
+                q[r * 4 + a] = data[oi[a] + oj[r]];
+
+        T column[4];
+        monotonicCubicN<T, 4>(q, fracty, column);
+        T tmp = monotonicCubic(column[0], column[1], column[2], column[3], fractx);
         return tmp;
 
         // Bilinear Interpolation
@@ -282,4 +242,24 @@ namespace Glb
         return tmp;
         */
     }
+
+    template <typename T>
+    void CubicGrid2d<T>::interpolate(const float* x, const float* y, T* out, int n)
+    {
+        int s = 0;
+        if (sGridSimd)
+            s = bicubicBatchAVX2(this->mData.data(), this->sampleDesc(), x, y, out, n);
+        for (; s < n; s++)
+            out[s] = interpolate(glm::vec2(x[s], y[s]));
+    }
+
+    // 显式实例化，单/双精度均可使用
+    template class StaggeredGrid2d<float, STAGGER_CENTER>;
+    template class StaggeredGrid2d<float, STAGGER_X>;
+    template class StaggeredGrid2d<float, STAGGER_Y>;
+    template class CubicGrid2d<float>;
+    template class StaggeredGrid2d<double, STAGGER_CENTER>;
+    template class StaggeredGrid2d<double, STAGGER_X>;
+    template class StaggeredGrid2d<double, STAGGER_Y>;
+    template class CubicGrid2d<double>;
 }
@@ -1,79 +1,118 @@
 #include "GridData3d.h"
 #include "Configure.h"
+#include <algorithm>
+#include <utility>
 
 namespace Glb
 {
 
-    GridData3d::GridData3d() : mDfltValue(0.0), mMax(0.0, 0.0, 0.0), cellSize(Eulerian3dPara::theCellSize3d)
+    template <typename T, int Axis, int Layout>
+    StaggeredGrid3d<T, Axis, Layout>::StaggeredGrid3d(int ghost)
+        : StaggeredGrid3d(Eulerian3dPara::theDim3d[0], Eulerian3dPara::theDim3d[1], Eulerian3dPara::theDim3d[2], Eulerian3dPara::theCellSize3d, ghost)
     {
-        dim[0] = Eulerian3dPara::theDim3d[0];
-        dim[1] = Eulerian3dPara::theDim3d[1];
-        dim[2] = Eulerian3dPara::theDim3d[2];
     }
 
-    GridData3d::GridData3d(const GridData3d &orig) : mDfltValue(orig.mDfltValue)
+    template <typename T, int Axis, int Layout>
+    StaggeredGrid3d<T, Axis, Layout>::StaggeredGrid3d(int dim0, int dim1, int dim2, float cellSize, int ghost)
+        : mMax(0.0, 0.0, 0.0), mDfltValue(0), cellSize(cellSize), mGhost(ghost)
     {
-        mData = orig.mData;
-        mMax = orig.mMax;
-        cellSize = orig.cellSize;
-        dim[0] = orig.dim[0];
-        dim[1] = orig.dim[1];
-        dim[2] = orig.dim[2];
-    }
+        dim[0] = dim0;
+        dim[1] = dim1;
+        dim[2] = dim2;
+        mSize[0] = dim[0] + (Axis == STAGGER_X ? 1 : 0);
+        mSize[1] = dim[1] + (Axis == STAGGER_Y ? 1 : 0);
+        mSize[2] = dim[2] + (Axis == STAGGER_Z ? 1 : 0);
+        for (int a = 0; a < 3; a++)
+            mBricks[a] = (mSize[a] + 2 * mGhost + GRID_BRICK_SIZE - 1) >> GRID_BRICK_BITS;
 
-    GridData3d::~GridData3d()
-    {
+        if (Layout == LAYOUT_LINEAR) {
+            mStride[0] = mSize[0] + 2 * mGhost;
+            mStride[1] = mStride[0] * (mSize[2] + 2 * mGhost);
+        }
+        else {
+            // 一行块 (k 方向跨一个块) 与一层块 (j 方向跨一个块) 的长度
+            mStride[0] = mBricks[0] << (3 * GRID_BRICK_BITS);
+            mStride[1] = mStride[0] * mBricks[2];
+        }
     }
 
-    ublas::vector<double> &GridData3d::data()
+    template <typename T, int Axis, int Layout>
+    void StaggeredGrid3d<T, Axis, Layout>::swap(StaggeredGrid3d& other)
     {
-        return mData;
+        std::swap(mMax, other.mMax);
+        std::swap(mDfltValue, other.mDfltValue);
+        mData.swap(other.mData);
+        std::swap(cellSize, other.cellSize);
+        std::swap(dim, other.dim);
+        std::swap(mSize, other.mSize);
+        std::swap(mGhost, other.mGhost);
+        std::swap(mStride, other.mStride);
+        std::swap(mBricks, other.mBricks);
     }
 
-    GridData3d &GridData3d::operator=(const GridData3d &orig)
+    template <typename T, int Axis, int Layout>
+    void StaggeredGrid3d<T, Axis, Layout>::copyFrom(const StaggeredGrid3d& other)
     {
-        if (this == &orig)
-        {
-            return *this;
+        mMax = other.mMax;
+        mDfltValue = other.mDfltValue;
+        cellSize = other.cellSize;
+        for (int a = 0; a < 3; a++) {
+            dim[a] = other.dim[a];
+            mSize[a] = other.mSize[a];
+            mBricks[a] = other.mBricks[a];
         }
-        mData = orig.mData;
-        mMax = orig.mMax;
-        cellSize = orig.cellSize;
-        dim[0] = orig.dim[0];
-        dim[1] = orig.dim[1];
-        dim[2] = orig.dim[2];
-        return *this;
+        mGhost = other.mGhost;
+        mStride[0] = other.mStride[0];
+        mStride[1] = other.mStride[1];
+        if (mData.size() == other.mData.size())
+            std::copy(other.mData.begin(), other.mData.end(), mData.begin());
+        else
+            mData = other.mData;
     }
 
-    void GridData3d::initialize(double dfltValue)
+    template <typename T, int Axis, int Layout>
+    void StaggeredGrid3d<T, Axis, Layout>::initialize(T dfltValue)
     {
         mDfltValue = dfltValue;
-        mMax[0] = cellSize * dim[0];
-        mMax[1] = cellSize * dim[1];
-        mMax[2] = cellSize * dim[2];
-        mData.resize(dim[0] * dim[1] * dim[2], false);
-        std::fill(mData.begin(), mData.end(), mDfltValue);
+        mMax[0] = cellSize * mSize[0];
+        mMax[1] = cellSize * mSize[1];
+        mMax[2] = cellSize * mSize[2];
+        if (Layout == LAYOUT_LINEAR)
+            mData.assign(mStride[1] * (mSize[1] + 2 * mGhost), mDfltValue);
+        else
+            mData.assign(mStride[1] * mBricks[1], mDfltValue);
     }
 
-    double &GridData3d::operator()(int i, int j, int k)
+    template <typename T, int Axis, int Layout>
+    void StaggeredGrid3d<T, Axis, Layout>::fillBoundary()
     {
-        static double dflt = 0;
-        dflt = mDfltValue;
-
-        if (i < 0 || j < 0 || k < 0 ||
-            i > dim[0] - 1 ||
-            j > dim[1] - 1 ||
-            k > dim[2] - 1)
-            return dflt;
+        // 单元中心的数据越界时一律为默认值，幽灵单元在 initialize 之后不会改变
+        if (Axis == STAGGER_CENTER)
+            return;
 
-        int col = i;
-        int row = k * dim[0];
-        int stack = j * dim[0] * dim[2];
-
-        return mData(col + row + stack);
+        for (int j = -mGhost; j < mSize[1] + mGhost; j++)
+        {
+            int jc = j < 0 ? 0 : (j > mSize[1] - 1 ? mSize[1] - 1 : j);
+            for (int k = -mGhost; k < mSize[2] + mGhost; k++)
+            {
+                int kc = k < 0 ? 0 : (k > mSize[2] - 1 ? mSize[2] - 1 : k);
+                bool rowInside = jc == j && kc == k;
+                for (int i = -mGhost; i < mSize[0] + mGhost; i++)
+                {
+                    // 内部行只需处理两侧的幽灵单元
+                    if (rowInside && i == 0)
+                        i = mSize[0];
+
+                    int ic = i < 0 ? 0 : (i > mSize[0] - 1 ? mSize[0] - 1 : i);
+                    bool staggeredOut = Axis == STAGGER_X ? ic != i : (Axis == STAGGER_Y ? jc != j : kc != k);
+                    (*this)(i, j, k) = staggeredOut ? mDfltValue : (*this)(ic, jc, kc);
+                }
+            }
+        }
     }
 
-    void GridData3d::getCell(const glm::vec3 &pt, int &i, int &j, int &k)
+    template <typename T, int Axis, int Layout>
+    void StaggeredGrid3d<T, Axis, Layout>::getCell(const glm::vec3 &pt, int &i, int &j, int &k)
     {
         glm::vec3 pos = worldToSelf(pt);
         i = (int)(pos[0] / cellSize);
@@ -81,7 +120,8 @@ namespace Glb
         k = (int)(pos[2] / cellSize);
     }
 
-    double GridData3d::interpolate(const glm::vec3 &pt)
+    template <typename T, int Axis, int Layout>
+    T StaggeredGrid3d<T, Axis, Layout>::interpolate(const glm::vec3 &pt)
     {
         glm::vec3 pos = worldToSelf(pt);
 
@@ -89,272 +129,153 @@ namespace Glb
         int j = (int)(pos[1] / cellSize);
         int k = (int)(pos[2] / cellSize);
 
-        double scale = 1.0 / cellSize;
-        double fractx = scale * (pos[0] - i * cellSize);
-        double fracty = scale * (pos[1] - j * cellSize);
-        double fractz = scale * (pos[2] - k * cellSize);
+        T scale = 1.0 / cellSize;
+        T fractx = scale * (pos[0] - i * cellSize);
+        T fracty = scale * (pos[1] - j * cellSize);
+        T fractz = scale * (pos[2] - k * cellSize);
 
         assert(fractx < 1.0 && fractx >= 0);
         assert(fracty < 1.0 && fracty >= 0);
         assert(fractz < 1.0 && fractz >= 0);
 
-        double tmp1 = (*this)(i, j, k);
-        double tmp2 = (*this)(i, j + 1, k);
-        double tmp3 = (*this)(i + 1, j, k);
-        double tmp4 = (*this)(i + 1, j + 1, k);
-
-        double tmp5 = (*this)(i, j, k + 1);
-        double tmp6 = (*this)(i, j + 1, k + 1);
-        double tmp7 = (*this)(i + 1, j, k + 1);
-        double tmp8 = (*this)(i + 1, j + 1, k + 1);
-
-        double tmp12 = LERP(tmp1, tmp2, fracty);
-        double tmp34 = LERP(tmp3, tmp4, fracty);
-
-        double tmp56 = LERP(tmp5, tmp6, fracty);
-        double tmp78 = LERP(tmp7, tmp8, fracty);
-
-        double tmp1234 = LERP(tmp12, tmp34, fractx);
-        double tmp5678 = LERP(tmp56, tmp78, fractx);
-
-        double tmp = LERP(tmp1234, tmp5678, fractz);
-        return tmp;
-    }
-
-    glm::vec3 GridData3d::worldToSelf(const glm::vec3 &pt) const
-    {
-        glm::vec3 out;
-        out[0] = min(max(0.0, pt[0] - cellSize * 0.5), mMax[0]);
-        out[1] = min(max(0.0, pt[1] - cellSize * 0.5), mMax[1]);
-        out[2] = min(max(0.0, pt[2] - cellSize * 0.5), mMax[2]);
-        return out;
-    }
-
-    GridData3dX::GridData3dX() : GridData3d()
-    {
-    }
+        // 下标可按方向分解，8 个角点只需计算 6 个偏移
+        int i0 = offsetI(i), i1 = offsetI(i + 1);
+        int j0 = offsetJ(j), j1 = offsetJ(j + 1);
+        int k0 = offsetK(k), k1 = offsetK(k + 1);
 
-    GridData3dX::~GridData3dX()
-    {
-    }
+        T tmp1 = mData[i0 + j0 + k0];
+        T tmp2 = mData[i0 + j1 + k0];
+        T tmp3 = mData[i1 + j0 + k0];
+        T tmp4 = mData[i1 + j1 + k0];
 
-    void GridData3dX::initialize(double dfltValue)
-    {
-        GridData3d::initialize(dfltValue);
-        mMax[0] = cellSize * (dim[0] + 1);
-        mMax[1] = cellSize * dim[1];
-        mMax[2] = cellSize * dim[2];
-        mData.resize((dim[0] + 1) * dim[1] * dim[2], false);
-        std::fill(mData.begin(), mData.end(), mDfltValue);
-    }
+        T tmp5 = mData[i0 + j0 + k1];
+        T tmp6 = mData[i0 + j1 + k1];
+        T tmp7 = mData[i1 + j0 + k1];
+        T tmp8 = mData[i1 + j1 + k1];
 
-    double &GridData3dX::operator()(int i, int j, int k)
-    {
-        static double dflt = 0;
-        dflt = mDfltValue; // Protect against setting the default value
-
-        if (i < 0 || i > dim[0])
-            return dflt;
-
-        if (j < 0)
-            j = 0;
-        if (j > dim[1] - 1)
-            j = dim[1] - 1;
-        if (k < 0)
-            k = 0;
-        if (k > dim[2] - 1)
-            k = dim[2] - 1;
-
-        int col = i;
-        int row = k * (dim[0] + 1);
-        int stack = j * (dim[0] + 1) * dim[2];
-        return mData(stack + row + col);
-    }
+        T tmp12 = LERP(tmp1, tmp2, fracty);
+        T tmp34 = LERP(tmp3, tmp4, fracty);
 
-    glm::vec3 GridData3dX::worldToSelf(const glm::vec3 &pt) const
-    {
-        glm::vec3 out;
-        out[0] = min(max(0.0, pt[0]), mMax[0]);
-        out[1] = min(max(0.0, pt[1] - cellSize * 0.5), mMax[1]);
-        out[2] = min(max(0.0, pt[2] - cellSize * 0.5), mMax[2]);
-        return out;
-    }
-
-    GridData3dY::GridData3dY() : GridData3d()
-    {
-    }
+        T tmp56 = LERP(tmp5, tmp6, fracty);
+        T tmp78 = LERP(tmp7, tmp8, fracty);
 
-    GridData3dY::~GridData3dY()
-    {
-    }
-
-    void GridData3dY::initialize(double dfltValue)
-    {
-        GridData3d::initialize(dfltValue);
-        mMax[0] = cellSize * dim[0];
-        mMax[1] = cellSize * (dim[1] + 1);
-        mMax[2] = cellSize * dim[2];
-        mData.resize(dim[0] * (dim[1] + 1) * dim[2], false);
-        std::fill(mData.begin(), mData.end(), mDfltValue);
-    }
+        T tmp1234 = LERP(tmp12, tmp34, fractx);
+        T tmp5678 = LERP(tmp56, tmp78, fractx);
 
-    double &GridData3dY::operator()(int i, int j, int k)
-    {
-        static double dflt = 0;
-        dflt = mDfltValue;
-
-        if (j < 0 || j > dim[1])
-            return dflt;
-
-        if (i < 0)
-            i = 0;
-        if (i > dim[0] - 1)
-            i = dim[0] - 1;
-        if (k < 0)
-            k = 0;
-        if (k > dim[2] - 1)
-            k = dim[2] - 1;
-
-        int col = i;
-        int row = k * dim[0];
-        int stack = j * dim[0] * dim[2];
-        return mData(stack + row + col);
-    }
-
-    glm::vec3 GridData3dY::worldToSelf(const glm::vec3 &pt) const
-    {
-        glm::vec3 out;
-        out[0] = min(max(0.0, pt[0] - cellSize * 0.5), mMax[0]);
-        out[1] = min(max(0.0, pt[1]), mMax[1]);
-        out[2] = min(max(0.0, pt[2] - cellSize * 0.5), mMax[2]);
-        return out;
-    }
-
-    GridData3dZ::GridData3dZ() : GridData3d()
-    {
-    }
-
-    GridData3dZ::~GridData3dZ()
-    {
+        T tmp = LERP(tmp1234, tmp5678, fractz);
+        return tmp;
     }
 
-    void GridData3dZ::initialize(double dfltValue)
+    template <typename T, int Axis, int Layout>
+    void StaggeredGrid3d<T, Axis, Layout>::interpolate(const float* x, const float* y, const float* z, T* out, int n)
     {
-        GridData3d::initialize(dfltValue);
-        mMax[0] = cellSize * dim[0];
-        mMax[1] = cellSize * dim[1];
-        mMax[2] = cellSize * (dim[2] + 1);
-        mData.resize(dim[0] * dim[1] * (dim[2] + 1), false);
-        std::fill(mData.begin(), mData.end(), mDfltValue);
+        // 块布局的下标不能由 i、j、k 线性组合得到，逐点插值
+        int s = 0;
+        if (Layout == LAYOUT_LINEAR && gridSimdEnabled())
+            s = trilinearBatchAVX2(mData.data(), sampleDesc(), x, y, z, out, n);
+        for (; s < n; s++)
+            out[s] = interpolate(glm::vec3(x[s], y[s], z[s]));
     }
 
-    double &GridData3dZ::operator()(int i, int j, int k)
+    template <typename T, int Axis, int Layout>
+    GridSampleDesc StaggeredGrid3d<T, Axis, Layout>::sampleDesc() const
     {
-        static double dflt = 0;
-        dflt = mDfltValue;
-
-        if (k < 0 || k > dim[2])
-            return dflt;
-
-        if (i < 0)
-            i = 0;
-        if (i > dim[0] - 1)
-            i = dim[0] - 1;
-        if (j < 0)
-            j = 0;
-        if (j > dim[1] - 1)
-            j = dim[1] - 1;
-
-        int col = i;
-        int row = k * dim[0];
-        int stack = j * dim[0] * (dim[2] + 1);
-
-        return mData(stack + row + col);
+        GridSampleDesc g;
+        g.cellSize = cellSize;
+        g.shift[0] = Axis == STAGGER_X ? 0.0f : cellSize * 0.5f;
+        g.shift[1] = Axis == STAGGER_Y ? 0.0f : cellSize * 0.5f;
+        g.shift[2] = Axis == STAGGER_Z ? 0.0f : cellSize * 0.5f;
+        g.maxPos[0] = mMax[0];
+        g.maxPos[1] = mMax[1];
+        g.maxPos[2] = mMax[2];
+        g.origin = offsetI(0) + offsetJ(0) + offsetK(0);
+        g.stride[0] = mStride[0];
+        g.stride[1] = mStride[1];
+        return g;
     }
 
-    glm::vec3 GridData3dZ::worldToSelf(const glm::vec3 &pt) const
+    template <typename T, int Axis, int Layout>
+    glm::vec3 StaggeredGrid3d<T, Axis, Layout>::worldToSelf(const glm::vec3 &pt) const
     {
+        // 交错方向上数据位于面中心，不需要半个单元的偏移
         glm::vec3 out;
-        out[0] = min(max(0.0, pt[0] - cellSize * 0.5), mMax[0]);
-        out[1] = min(max(0.0, pt[1] - cellSize * 0.5), mMax[1]);
-        out[2] = min(max(0.0, pt[2]), mMax[2]);
+        out[0] = min(max(0.0, pt[0] - (Axis == STAGGER_X ? 0.0 : cellSize * 0.5)), mMax[0]);
+        out[1] = min(max(0.0, pt[1] - (Axis == STAGGER_Y ? 0.0 : cellSize * 0.5)), mMax[1]);
+        out[2] = min(max(0.0, pt[2] - (Axis == STAGGER_Z ? 0.0 : cellSize * 0.5)), mMax[2]);
         return out;
     }
 
-    CubicGridData3d::CubicGridData3d() : GridData3d()
-    {
-    }
-
-    CubicGridData3d::CubicGridData3d(const CubicGridData3d &orig) : GridData3d(orig)
+    template <typename T, int Layout>
+    T CubicGrid3d<T, Layout>::interpolate(const glm::vec3 &pt)
     {
-    }
-
-    CubicGridData3d::~CubicGridData3d()
-    {
-    }
-
-    double CubicGridData3d::cubic(double q1, double q2, double q3, double q4, double t)
-    {
-        double deltaq = q3 - q2;
-        double d1 = (q3 - q1) * 0.5;
-        double d2 = (q4 - q2) * 0.5;
-
-        if (deltaq > 0.0001)
-        {
-            d1 = d1 > 0 ? d1 : 0.0;
-            d2 = d2 > 0 ? d2 : 0.0;
-        }
-        else if (deltaq < 0.0001)
-        {
-            d1 = d1 < 0 ? d1 : 0.0;
-            d2 = d2 < 0 ? d2 : 0.0;
-        }
-
-        double tmp = q2 + d1 * t + (3 * deltaq - 2 * d1 - d2) * t * t + (-2 * deltaq + d1 + d2) * t * t * t;
-        return tmp;
-    }
-
-    double CubicGridData3d::interpY(int i, int j, int k, double fracty)
-    {
-        double tmp1 = (*this)(i, j - 1 < 0 ? j : j - 1, k);
-        double tmp2 = (*this)(i, j, k);
-        double tmp3 = (*this)(i, j + 1, k);
-        double tmp4 = (*this)(i, j + 2, k);
-        return cubic(tmp1, tmp2, tmp3, tmp4, fracty);
-    }
-
-    double CubicGridData3d::interpX(int i, int j, int k, double fracty, double fractx)
-    {
-        double tmp1 = interpY(i - 1 < 0 ? i : i - 1, j, k, fracty);
-        double tmp2 = interpY(i, j, k, fracty);
-        double tmp3 = interpY(i + 1, j, k, fracty);
-        double tmp4 = interpY(i + 2, j, k, fracty);
-        return cubic(tmp1, tmp2, tmp3, tmp4, fractx);
-    }
-
-    double CubicGridData3d::interpolate(const glm::vec3 &pt)
-    {
-        glm::vec3 pos = worldToSelf(pt);
+        glm::vec3 pos = this->worldToSelf(pt);
+        float cellSize = this->cellSize;
 
         int i = (int)(pos[0] / cellSize);
         int j = (int)(pos[1] / cellSize);
         int k = (int)(pos[2] / cellSize);
 
-        double scale = 1.0 / cellSize;
-        double fractx = scale * (pos[0] - i * cellSize);
-        double fracty = scale * (pos[1] - j * cellSize);
-        double fractz = scale * (pos[2] - k * cellSize);
+        T scale = 1.0 / cellSize;
+        T fractx = scale * (pos[0] - i * cellSize);
+        T fracty = scale * (pos[1] - j * cellSize);
+        T fractz = scale * (pos[2] - k * cellSize);
 
         assert(fractx < 1.0 && fractx >= 0);
         assert(fracty < 1.0 && fracty >= 0);
         assert(fractz < 1.0 && fractz >= 0);
 
-        double tmp1 = interpX(i, j, k - 1 < 0 ? k : k - 1, fracty, fractx);
-        double tmp2 = interpX(i, j, k, fracty, fractx);
-        double tmp3 = interpX(i, j, k + 1, fracty, fractx);
-        double tmp4 = interpX(i, j, k + 2, fracty, fractx);
-
-        double tmp = cubic(tmp1, tmp2, tmp3, tmp4, fractz);
+        // 4x4x4 模板在各方向上的偏移，低侧越界时钳制到自身
+        int oi[4] = { this->offsetI(i - 1 < 0 ? i : i - 1), this->offsetI(i), this->offsetI(i + 1), this->offsetI(i + 2) };
+        int oj[4] = { this->offsetJ(j - 1 < 0 ? j : j - 1), this->offsetJ(j), this->offsetJ(j + 1), this->offsetJ(j + 2) };
+        int ok[4] = { this->offsetK(k - 1 < 0 ? k : k - 1), this->offsetK(k), this->offsetK(k + 1), this->offsetK(k + 2) };
+
+        // 一次读入整个模板，q[r * 16 + a * 4 + c] 为 (oi[a], oj[r], ok[c]) 处的值
+        const T* data = this->mData.data();
+        T q[64];
+        for (int a = 0; a < 4; a++)
+            for (int c = 0; c < 4; c++) {
+                const T* line = data + oi[a] + ok[c];
+                for (int r = 0; r < 4; r++)
+                    q[r * 16 + a * 4 + c] = line[oj[r]];
+            }
+
+        // 沿 j 方向 16 次、i 方向 4 次、k 方向 1 次，前两步各组同时计算
+        T line[16], plane[4];
+        monotonicCubicN<T, 16>(q, fracty, line);
+        monotonicCubicN<T, 4>(line, fractx, plane);
+        T tmp = monotonicCubic(plane[0], plane[1], plane[2], plane[3], fractz);
         return tmp;
     }
+
+    template <typename T, int Layout>
+    void CubicGrid3d<T, Layout>::interpolate(const float* x, const float* y, const float* z, T* out, int n)
+    {
+        int s = 0;
+        if (Layout == LAYOUT_LINEAR && gridSimdEnabled())
+            s = tricubicBatchAVX2(this->mData.data(), this->sampleDesc(), x, y, z, out, n);
+        for (; s < n; s++)
+            out[s] = interpolate(glm::vec3(x[s], y[s], z[s]));
+    }
+
+    // 显式实例化，单/双精度均可使用
+    template class StaggeredGrid3d<float, STAGGER_CENTER>;
+    template class StaggeredGrid3d<float, STAGGER_X>;
+    template class StaggeredGrid3d<float, STAGGER_Y>;
+    template class StaggeredGrid3d<float, STAGGER_Z>;
+    template class CubicGrid3d<float>;
+    template class StaggeredGrid3d<double, STAGGER_CENTER>;
+    template class StaggeredGrid3d<double, STAGGER_X>;
+    template class StaggeredGrid3d<double, STAGGER_Y>;
+    template class StaggeredGrid3d<double, STAGGER_Z>;
+    template class CubicGrid3d<double>;
+    template class StaggeredGrid3d<float, STAGGER_CENTER, LAYOUT_BRICK>;
+    template class StaggeredGrid3d<float, STAGGER_X, LAYOUT_BRICK>;
+    template class StaggeredGrid3d<float, STAGGER_Y, LAYOUT_BRICK>;
+    template class StaggeredGrid3d<float, STAGGER_Z, LAYOUT_BRICK>;
+    template class CubicGrid3d<float, LAYOUT_BRICK>;
+    template class StaggeredGrid3d<double, STAGGER_CENTER, LAYOUT_BRICK>;
+    template class StaggeredGrid3d<double, STAGGER_X, LAYOUT_BRICK>;
+    template class StaggeredGrid3d<double, STAGGER_Y, LAYOUT_BRICK>;
+    template class StaggeredGrid3d<double, STAGGER_Z, LAYOUT_BRICK>;
+    template class CubicGrid3d<double, LAYOUT_BRICK>;
 }
@@ -0,0 +1,347 @@
+﻿/**
+ * GridDataSIMD.cpp: 网格批量插值的 AVX2 内核
+ * 该文件单独以 AVX2 指令集编译，未以 AVX2 编译时所有内核返回 0，全部退化为逐点插值
+ * 运算顺序与 GridData2d/3d 中的标量插值完全相同，且不允许编译器合并乘加
+ */
+
+#include "GridDataSIMD.h"
+#include <cmath>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace Glb
+{
+#if defined(__AVX2__)
+    // 双精度：坐标以 4 路单精度计算，插值以 4 路双精度计算
+    struct LanesD
+    {
+        enum { N = 4 };
+        typedef double T;
+        typedef __m256d V;
+        typedef __m128 F;
+        typedef __m128i I;
+
+        static F loadF(const float* p) { return _mm_loadu_ps(p); }
+        static F setF(float v) { return _mm_set1_ps(v); }
+        static F subF(F a, F b) { return _mm_sub_ps(a, b); }
+        static F mulF(F a, F b) { return _mm_mul_ps(a, b); }
+        static F divF(F a, F b) { return _mm_div_ps(a, b); }
+        static F maxF(F a, F b) { return _mm_max_ps(a, b); }
+        static F minF(F a, F b) { return _mm_min_ps(a, b); }
+        static I truncF(F a) { return _mm_cvttps_epi32(a); }
+        static F toF(I a) { return _mm_cvtepi32_ps(a); }
+
+        static I setI(int v) { return _mm_set1_epi32(v); }
+        static I addI(I a, I b) { return _mm_add_epi32(a, b); }
+        static I mulI(I a, I b) { return _mm_mullo_epi32(a, b); }
+        static I maxI(I a, I b) { return _mm_max_epi32(a, b); }
+
+        static V widen(F a) { return _mm256_cvtps_pd(a); }
+        static V set(T v) { return _mm256_set1_pd(v); }
+        static V add(V a, V b) { return _mm256_add_pd(a, b); }
+        static V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+        static V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+        static V max(V a, V b) { return _mm256_max_pd(a, b); }
+        static V min(V a, V b) { return _mm256_min_pd(a, b); }
+        // mask ? a : b
+        static V select(V mask, V a, V b) { return _mm256_blendv_pd(b, a, mask); }
+        static V gather(const T* base, I idx) { return _mm256_i32gather_pd(base, idx, 8); }
+        static void store(T* p, V v) { _mm256_storeu_pd(p, v); }
+
+        // 单调三次插值中的 deltaq > 0.0001
+        static V cubicRising(V dq) { return _mm256_cmp_pd(dq, _mm256_set1_pd(0.0001), _CMP_GT_OQ); }
+    };
+
+    // 单精度：坐标与插值均为 8 路单精度
+    struct LanesF
+    {
+        enum { N = 8 };
+        typedef float T;
+        typedef __m256 V;
+        typedef __m256 F;
+        typedef __m256i I;
+
+        static F loadF(const float* p) { return _mm256_loadu_ps(p); }
+        static F setF(float v) { return _mm256_set1_ps(v); }
+        static F subF(F a, F b) { return _mm256_sub_ps(a, b); }
+        static F mulF(F a, F b) { return _mm256_mul_ps(a, b); }
+        static F divF(F a, F b) { return _mm256_div_ps(a, b); }
+        static F maxF(F a, F b) { return _mm256_max_ps(a, b); }
+        static F minF(F a, F b) { return _mm256_min_ps(a, b); }
+        static I truncF(F a) { return _mm256_cvttps_epi32(a); }
+        static F toF(I a) { return _mm256_cvtepi32_ps(a); }
+
+        static I setI(int v) { return _mm256_set1_epi32(v); }
+        static I addI(I a, I b) { return _mm256_add_epi32(a, b); }
+        static I mulI(I a, I b) { return _mm256_mullo_epi32(a, b); }
+        static I maxI(I a, I b) { return _mm256_max_epi32(a, b); }
+
+        static V widen(F a) { return a; }
+        static V set(T v) { return _mm256_set1_ps(v); }
+        static V add(V a, V b) { return _mm256_add_ps(a, b); }
+        static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+        static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+        static V max(V a, V b) { return _mm256_max_ps(a, b); }
+        static V min(V a, V b) { return _mm256_min_ps(a, b); }
+        static V select(V mask, V a, V b) { return _mm256_blendv_ps(b, a, mask); }
+        static V gather(const T* base, I idx) { return _mm256_i32gather_ps(base, idx, 4); }
+        static void store(T* p, V v) { _mm256_storeu_ps(p, v); }
+
+        // 标量代码中 float 与双精度常数 0.0001 比较，等价于不小于大于 0.0001 的最小单精度数
+        static V cubicRising(V dq)
+        {
+            float threshold = 0.0001f;
+            if ((double)threshold <= 0.0001)
+                threshold = std::nextafter(threshold, 1.0f);
+            return _mm256_cmp_ps(dq, _mm256_set1_ps(threshold), _CMP_GE_OQ);
+        }
+    };
+
+    /**
+     * 世界坐标 -> 所在单元与单元内的相对位置，对应 worldToSelf 与 interpolate 的前半部分
+     * max/min 的参数顺序保证与 Configure.h 中的宏对 NaN 的处理相同
+     */
+    template <class L>
+    static inline void cellCoord(typename L::F p, float shift, float maxPos, float cellSize, typename L::T scale,
+        typename L::I& cell, typename L::V& fract)
+    {
+        typename L::F pos = L::subF(p, L::setF(shift));
+        pos = L::minF(L::maxF(L::setF(0.0f), pos), L::setF(maxPos));
+        cell = L::truncF(L::divF(pos, L::setF(cellSize)));
+        typename L::F rem = L::subF(pos, L::mulF(L::toF(cell), L::setF(cellSize)));
+        fract = L::mul(L::set(scale), L::widen(rem));
+    }
+
+    // LERP(a, b, t) = (1 - t) * a + t * b
+    template <class L>
+    static inline typename L::V lerp(typename L::V a, typename L::V b, typename L::V t)
+    {
+        return L::add(L::mul(L::sub(L::set(1), t), a), L::mul(t, b));
+    }
+
+    // 对应 CubicGrid2d/3d::cubic 的单调三次插值
+    template <class L>
+    static inline typename L::V cubic(typename L::V q1, typename L::V q2, typename L::V q3, typename L::V q4, typename L::V t)
+    {
+        typedef typename L::V V;
+        const V zero = L::set(0);
+        V deltaq = L::sub(q3, q2);
+        V d1 = L::mul(L::sub(q3, q1), L::set(0.5));
+        V d2 = L::mul(L::sub(q4, q2), L::set(0.5));
+
+        V rising = L::cubicRising(deltaq);
+        d1 = L::select(rising, L::max(d1, zero), L::min(d1, zero));
+        d2 = L::select(rising, L::max(d2, zero), L::min(d2, zero));
+
+        V a = L::sub(L::sub(L::mul(L::set(3), deltaq), L::mul(L::set(2), d1)), d2);
+        V b = L::add(L::add(L::mul(L::set(-2), deltaq), d1), d2);
+        V tmp = L::add(q2, L::mul(d1, t));
+        tmp = L::add(tmp, L::mul(L::mul(a, t), t));
+        tmp = L::add(tmp, L::mul(L::mul(L::mul(b, t), t), t));
+        return tmp;
+    }
+
+    // 4 点模板在某一方向上的下标偏移，低侧越界时钳制到自身
+    template <class L>
+    static inline void stencil(typename L::I cell, int stride, typename L::I* o)
+    {
+        typename L::I s = L::setI(stride);
+        o[0] = L::mulI(L::maxI(L::addI(cell, L::setI(-1)), L::setI(0)), s);
+        o[1] = L::mulI(cell, s);
+        o[2] = L::addI(o[1], s);
+        o[3] = L::addI(o[2], s);
+    }
+
+    template <class L>
+    static int bilinear2d(const typename L::T* data, const GridSampleDesc& g, const float* x, const float* y, typename L::T* out, int n)
+    {
+        typedef typename L::T T;
+        typedef typename L::V V;
+        typedef typename L::I I;
+        T scale = 1.0 / g.cellSize;
+        const I one = L::setI(1), strideJ = L::setI(g.stride[0]);
+
+        int s = 0;
+        for (; s + L::N <= n; s += L::N) {
+            I i, j;
+            V fractx, fracty;
+            cellCoord<L>(L::loadF(x + s), g.shift[0], g.maxPos[0], g.cellSize, scale, i, fractx);
+            cellCoord<L>(L::loadF(y + s), g.shift[1], g.maxPos[1], g.cellSize, scale, j, fracty);
+
+            I o00 = L::addI(L::addI(L::setI(g.origin), i), L::mulI(j, strideJ));
+            I o01 = L::addI(o00, strideJ);
+            V tmp1 = L::gather(data, o00);
+            V tmp2 = L::gather(data, o01);
+            V tmp3 = L::gather(data, L::addI(o00, one));
+            V tmp4 = L::gather(data, L::addI(o01, one));
+
+            V tmp12 = lerp<L>(tmp1, tmp2, fracty);
+            V tmp34 = lerp<L>(tmp3, tmp4, fracty);
+            L::store(out + s, lerp<L>(tmp12, tmp34, fractx));
+        }
+        return s;
+    }
+
+    template <class L>
+    static int bicubic2d(const typename L::T* data, const GridSampleDesc& g, const float* x, const float* y, typename L::T* out, int n)
+    {
+        typedef typename L::T T;
+        typedef typename L::V V;
+        typedef typename L::I I;
+        T scale = 1.0 / g.cellSize;
+
+        int s = 0;
+        for (; s + L::N <= n; s += L::N) {
+            I i, j;
+            V fractx, fracty;
+            cellCoord<L>(L::loadF(x + s), g.shift[0], g.maxPos[0], g.cellSize, scale, i, fractx);
+            cellCoord<L>(L::loadF(y + s), g.shift[1], g.maxPos[1], g.cellSize, scale, j, fracty);
+
+            I oi[4], oj[4];
+            stencil<L>(i, 1, oi);
+            stencil<L>(j, g.stride[0], oj);
+
+            V col[4];
+            for (int c = 0; c < 4; c++) {
+                I base = L::addI(L::setI(g.origin), oi[c]);
+                col[c] = cubic<L>(L::gather(data, L::addI(base, oj[0])), L::gather(data, L::addI(base, oj[1])),
+                    L::gather(data, L::addI(base, oj[2])), L::gather(data, L::addI(base, oj[3])), fracty);
+            }
+            L::store(out + s, cubic<L>(col[0], col[1], col[2], col[3], fractx));
+        }
+        return s;
+    }
+
+    template <class L>
+    static int trilinear3d(const typename L::T* data, const GridSampleDesc& g, const float* x, const float* y, const float* z, typename L::T* out, int n)
+    {
+        typedef typename L::T T;
+        typedef typename L::V V;
+        typedef typename L::I I;
+        T scale = 1.0 / g.cellSize;
+        const I one = L::setI(1), strideK = L::setI(g.stride[0]), strideJ = L::setI(g.stride[1]);
+
+        int s = 0;
+        for (; s + L::N <= n; s += L::N) {
+            I i, j, k;
+            V fractx, fracty, fractz;
+            cellCoord<L>(L::loadF(x + s), g.shift[0], g.maxPos[0], g.cellSize, scale, i, fractx);
+            cellCoord<L>(L::loadF(y + s), g.shift[1], g.maxPos[1], g.cellSize, scale, j, fracty);
+            cellCoord<L>(L::loadF(z + s), g.shift[2], g.maxPos[2], g.cellSize, scale, k, fractz);
+
+            I o000 = L::addI(L::addI(L::setI(g.origin), i), L::addI(L::mulI(k, strideK), L::mulI(j, strideJ)));
+            I o010 = L::addI(o000, strideJ);
+            I o001 = L::addI(o000, strideK);
+            I o011 = L::addI(o010, strideK);
+
+            V tmp1 = L::gather(data, o000);
+            V tmp2 = L::gather(data, o010);
+            V tmp3 = L::gather(data, L::addI(o000, one));
+            V tmp4 = L::gather(data, L::addI(o010, one));
+
+            V tmp5 = L::gather(data, o001);
+            V tmp6 = L::gather(data, o011);
+            V tmp7 = L::gather(data, L::addI(o001, one));
+            V tmp8 = L::gather(data, L::addI(o011, one));
+
+            V tmp12 = lerp<L>(tmp1, tmp2, fracty);
+            V tmp34 = lerp<L>(tmp3, tmp4, fracty);
+
+            V tmp56 = lerp<L>(tmp5, tmp6, fracty);
+            V tmp78 = lerp<L>(tmp7, tmp8, fracty);
+
+            V tmp1234 = lerp<L>(tmp12, tmp34, fractx);
+            V tmp5678 = lerp<L>(tmp56, tmp78, fractx);
+
+            L::store(out + s, lerp<L>(tmp1234, tmp5678, fractz));
+        }
+        return s;
+    }
+
+    template <class L>
+    static int tricubic3d(const typename L::T* data, const GridSampleDesc& g, const float* x, const float* y, const float* z, typename L::T* out, int n)
+    {
+        typedef typename L::T T;
+        typedef typename L::V V;
+        typedef typename L::I I;
+        T scale = 1.0 / g.cellSize;
+
+        int s = 0;
+        for (; s + L::N <= n; s += L::N) {
+            I i, j, k;
+            V fractx, fracty, fractz;
+            cellCoord<L>(L::loadF(x + s), g.shift[0], g.maxPos[0], g.cellSize, scale, i, fractx);
+            cellCoord<L>(L::loadF(y + s), g.shift[1], g.maxPos[1], g.cellSize, scale, j, fracty);
+            cellCoord<L>(L::loadF(z + s), g.shift[2], g.maxPos[2], g.cellSize, scale, k, fractz);
+
+            I oi[4], oj[4], ok[4];
+            stencil<L>(i, 1, oi);
+            stencil<L>(j, g.stride[1], oj);
+            stencil<L>(k, g.stride[0], ok);
+
+            V plane[4];
+            for (int c = 0; c < 4; c++) {
+                V col[4];
+                for (int a = 0; a < 4; a++) {
+                    I base = L::addI(L::addI(L::setI(g.origin), oi[a]), ok[c]);
+                    col[a] = cubic<L>(L::gather(data, L::addI(base, oj[0])), L::gather(data, L::addI(base, oj[1])),
+                        L::gather(data, L::addI(base, oj[2])), L::gather(data, L::addI(base, oj[3])), fracty);
+                }
+                plane[c] = cubic<L>(col[0], col[1], col[2], col[3], fractx);
+            }
+            L::store(out + s, cubic<L>(plane[0], plane[1], plane[2], plane[3], fractz));
+        }
+        return s;
+    }
+
+    int bilinearBatchAVX2(const float* data, const GridSampleDesc& g, const float* x, const float* y, float* out, int n)
+    {
+        return bilinear2d<LanesF>(data, g, x, y, out, n);
+    }
+
+    int bilinearBatchAVX2(const double* data, const GridSampleDesc& g, const float* x, const float* y, double* out, int n)
+    {
+        return bilinear2d<LanesD>(data, g, x, y, out, n);
+    }
+
+    int bicubicBatchAVX2(const float* data, const GridSampleDesc& g, const float* x, const float* y, float* out, int n)
+    {
+        return bicubic2d<LanesF>(data, g, x, y, out, n);
+    }
+
+    int bicubicBatchAVX2(const double* data, const GridSampleDesc& g, const float* x, const float* y, double* out, int n)
+    {
+        return bicubic2d<LanesD>(data, g, x, y, out, n);
+    }
+
+    int trilinearBatchAVX2(const float* data, const GridSampleDesc& g, const float* x, const float* y, const float* z, float* out, int n)
+    {
+        return trilinear3d<LanesF>(data, g, x, y, z, out, n);
+    }
+
+    int trilinearBatchAVX2(const double* data, const GridSampleDesc& g, const float* x, const float* y, const float* z, double* out, int n)
+    {
+        return trilinear3d<LanesD>(data, g, x, y, z, out, n);
+    }
+
+    int tricubicBatchAVX2(const float* data, const GridSampleDesc& g, const float* x, const float* y, const float* z, float* out, int n)
+    {
+        return tricubic3d<LanesF>(data, g, x, y, z, out, n);
+    }
+
+    int tricubicBatchAVX2(const double* data, const GridSampleDesc& g, const float* x, const float* y, const float* z, double* out, int n)
+    {
+        return tricubic3d<LanesD>(data, g, x, y, z, out, n);
+    }
+#else
+    int bilinearBatchAVX2(const float*, const GridSampleDesc&, const float*, const float*, float*, int) { return 0; }
+    int bilinearBatchAVX2(const double*, const GridSampleDesc&, const float*, const float*, double*, int) { return 0; }
+    int bicubicBatchAVX2(const float*, const GridSampleDesc&, const float*, const float*, float*, int) { return 0; }
+    int bicubicBatchAVX2(const double*, const GridSampleDesc&, const float*, const float*, double*, int) { return 0; }
+    int trilinearBatchAVX2(const float*, const GridSampleDesc&, const float*, const float*, const float*, float*, int) { return 0; }
+    int trilinearBatchAVX2(const double*, const GridSampleDesc&, const float*, const float*, const float*, double*, int) { return 0; }
+    int tricubicBatchAVX2(const float*, const GridSampleDesc&, const float*, const float*, const float*, float*, int) { return 0; }
+    int tricubicBatchAVX2(const double*, const GridSampleDesc&, const float*, const float*, const float*, double*, int) { return 0; }
+#endif
+}
@@ -0,0 +1,612 @@
+﻿/**
+ * Multigrid.cpp: 几何多重网格泊松求解器实现
+ * 参考 McAdams et al., A parallel multigrid Poisson solver for fluids simulation on large grids, SCA 2010
+ */
+
+#include "Multigrid.h"
+#include "Wavefront.h"
+#include <chrono>
+#include <cmath>
+
+namespace Glb {
+
+	// 粗化到最短边不超过该值为止
+	static const int COARSEST_SIZE = 4;
+	static const int PRE_SMOOTH = 2;
+	static const int POST_SMOOTH = 2;
+	static const int COARSEST_SWEEPS = 32;
+
+	PoissonMultigrid::PoissonMultigrid()
+		: mParallel(true), mSingular(true), mWavefront(false)
+	{
+	}
+
+	void PoissonMultigrid::setParallel(bool parallel)
+	{
+		mParallel = parallel;
+	}
+
+	void PoissonMultigrid::setup(int nx, int ny, int nz, const std::vector<unsigned char>& type)
+	{
+		if (!mLevels.empty() && mLevels[0].nx == nx && mLevels[0].ny == ny && mLevels[0].nz == nz && mLevels[0].type == type) {
+			return;
+		}
+
+		mLevels.clear();
+		mLevels.emplace_back();
+		Level& fine = mLevels[0];
+		fine.nx = nx;
+		fine.ny = ny;
+		fine.nz = nz;
+		fine.type = type;
+		buildLevel(fine);
+
+		mSingular = true;
+		for (size_t c = 0; c < fine.type.size(); c++) {
+			if (fine.type[c] == DIRICHLET) {
+				mSingular = false;
+				break;
+			}
+		}
+
+		// 2D 只在 x、y 方向粗化
+		while (true) {
+			const Level& f = mLevels.back();
+			int shortest = f.nx < f.ny ? f.nx : f.ny;
+			if (f.nz > 1 && f.nz < shortest) {
+				shortest = f.nz;
+			}
+			if (shortest <= COARSEST_SIZE) {
+				break;
+			}
+
+			Level c;
+			c.nx = (f.nx + 1) / 2;
+			c.ny = (f.ny + 1) / 2;
+			c.nz = f.nz > 1 ? (f.nz + 1) / 2 : 1;
+			c.type.assign((size_t)c.nx * c.ny * c.nz, SOLID);
+			int rz = f.nz > 1 ? 2 : 1;
+			for (int k = 0; k < c.nz; k++) {
+				for (int j = 0; j < c.ny; j++) {
+					for (int i = 0; i < c.nx; i++) {
+						unsigned char t = SOLID;
+						for (int dk = 0; dk < rz; dk++) {
+							for (int dj = 0; dj < 2; dj++) {
+								for (int di = 0; di < 2; di++) {
+									int fi = 2 * i + di, fj = 2 * j + dj, fk = rz * k + dk;
+									if (fi >= f.nx || fj >= f.ny || fk >= f.nz) {
+										continue;
+									}
+									unsigned char ft = f.type[fi + fj * f.nx + (size_t)fk * f.nx * f.ny];
+									if (ft == DIRICHLET) {
+										t = DIRICHLET;
+									}
+									else if (ft == FLUID && t == SOLID) {
+										t = FLUID;
+									}
+								}
+							}
+						}
+						c.type[i + j * c.nx + (size_t)k * c.nx * c.ny] = t;
+					}
+				}
+			}
+			buildLevel(c);
+			mLevels.push_back(c);
+		}
+
+		// push_back 之后 fine 可能已失效
+		size_t n = mLevels[0].type.size();
+		mX.assign(n, 0.0f);
+		mR.assign(n, 0.0f);
+		mZ.assign(n, 0.0f);
+		mS.assign(n, 0.0f);
+		mQ.assign(n, 0.0f);
+		tuneWavefront();
+	}
+
+	void PoissonMultigrid::tuneWavefront()
+	{
+		// 只有 3D 最细层可能放不进缓存；此时 x 与 b 都为 0，光滑不改变它们，各计时两轮取较快的一轮
+		mWavefront = false;
+		if (mLevels[0].nz <= 2) {
+			return;
+		}
+		double time[2] = { 0.0, 0.0 };
+		for (int mode = 0; mode < 2; mode++) {
+			mWavefront = mode == 1;
+			for (int round = 0; round < 2; round++) {
+				auto start = std::chrono::steady_clock::now();
+				smooth(mLevels[0], PRE_SMOOTH, false);
+				double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				time[mode] = round == 0 || t < time[mode] ? t : time[mode];
+			}
+		}
+		mWavefront = time[1] < time[0];
+	}
+
+	void PoissonMultigrid::buildLevel(Level& level)
+	{
+		size_t n = (size_t)level.nx * level.ny * level.nz;
+		level.diag.assign(n, 0.0f);
+		level.x.assign(n, 0.0f);
+		level.b.assign(n, 0.0f);
+		level.r.assign(n, 0.0f);
+
+		const int nx = level.nx, ny = level.ny, nz = level.nz;
+		const size_t sx = 1, sy = nx, sz = (size_t)nx * ny;
+		for (int k = 0; k < nz; k++) {
+			for (int j = 0; j < ny; j++) {
+				for (int i = 0; i < nx; i++) {
+					size_t c = i + j * sy + k * sz;
+					if (level.type[c] != FLUID) {
+						continue;
+					}
+					// 网格外视为固体
+					int count = 0;
+					if (i > 0 && level.type[c - sx] != SOLID) count++;
+					if (i < nx - 1 && level.type[c + sx] != SOLID) count++;
+					if (j > 0 && level.type[c - sy] != SOLID) count++;
+					if (j < ny - 1 && level.type[c + sy] != SOLID) count++;
+					if (k > 0 && level.type[c - sz] != SOLID) count++;
+					if (k < nz - 1 && level.type[c + sz] != SOLID) count++;
+					if (count == 0) {
+						// 四周都是固体的孤立单元不参与求解
+						level.type[c] = SOLID;
+						continue;
+					}
+					level.diag[c] = (float)count;
+				}
+			}
+		}
+	}
+
+	// 流体单元上 sum_n x_n，非流体单元的 x 恒为 0，因此不需要再判断邻居类型
+	static inline float neighborSum(const float* x, int i, int j, int k, size_t c, int nx, int ny, int nz, size_t sy, size_t sz)
+	{
+		float s = 0.0f;
+		if (i > 0) s += x[c - 1];
+		if (i < nx - 1) s += x[c + 1];
+		if (j > 0) s += x[c - sy];
+		if (j < ny - 1) s += x[c + sy];
+		if (k > 0) s += x[c - sz];
+		if (k < nz - 1) s += x[c + sz];
+		return s;
+	}
+
+	// 第 k 层第 j 行上颜色为 color 的流体单元做一次 Gauss-Seidel 更新
+	static inline void smoothRow(const unsigned char* type, const float* diag, const float* b, float* x, int j, int k, int color, int nx, int ny, int nz, size_t sy, size_t sz)
+	{
+		size_t base = j * sy + k * sz;
+		for (int i = (j + k + color) & 1; i < nx; i += 2) {
+			size_t c = base + i;
+			if (type[c] != PoissonMultigrid::FLUID) {
+				continue;
+			}
+			x[c] = (b[c] + neighborSum(x, i, j, k, c, nx, ny, nz, sy, sz)) / diag[c];
+		}
+	}
+
+	void PoissonMultigrid::smooth(Level& level, int sweeps, bool reverse)
+	{
+		const int nx = level.nx, ny = level.ny, nz = level.nz;
+		const size_t sy = nx, sz = (size_t)nx * ny;
+		const int rows = ny * nz;
+		const unsigned char* type = level.type.data();
+		const float* diag = level.diag.data();
+		const float* b = level.b.data();
+		float* x = level.x.data();
+
+		// 同一颜色的单元互不依赖，各颜色的扫描合并为沿 z 的波前后结果不变
+		if (mWavefront && &level == &mLevels[0]) {
+			forEachWavefront(0, nz, 2 * sweeps, ny, mParallel, [&](int pass, int k, int j) {
+				int color = reverse ? 1 - (pass & 1) : (pass & 1);
+				smoothRow(type, diag, b, x, j, k, color, nx, ny, nz, sy, sz);
+			});
+			return;
+		}
+
+		for (int s = 0; s < sweeps; s++) {
+			for (int pass = 0; pass < 2; pass++) {
+				int color = reverse ? 1 - pass : pass;
+#pragma omp parallel for if(mParallel)
+				for (int row = 0; row < rows; row++) {
+					smoothRow(type, diag, b, x, row % ny, row / ny, color, nx, ny, nz, sy, sz);
+				}
+			}
+		}
+	}
+
+	double PoissonMultigrid::residual(Level& level)
+	{
+		const int nx = level.nx, ny = level.ny, nz = level.nz;
+		const size_t sy = nx, sz = (size_t)nx * ny;
+		const int rows = ny * nz;
+		const unsigned char* type = level.type.data();
+		const float* diag = level.diag.data();
+		const float* b = level.b.data();
+		const float* x = level.x.data();
+		float* r = level.r.data();
+
+		// OpenMP 2.0 没有 max 归约，先按行记录再串行合并
+		std::vector<double> rowMax(rows, 0.0);
+#pragma omp parallel for if(mParallel)
+		for (int row = 0; row < rows; row++) {
+			int j = row % ny, k = row / ny;
+			size_t base = j * sy + k * sz;
+			double m = 0.0;
+			for (int i = 0; i < nx; i++) {
+				size_t c = base + i;
+				if (type[c] != FLUID) {
+					r[c] = 0.0f;
+					continue;
+				}
+				r[c] = b[c] - (diag[c] * x[c] - neighborSum(x, i, j, k, c, nx, ny, nz, sy, sz));
+				double a = std::fabs((double)r[c]);
+				if (a > m) m = a;
+			}
+			rowMax[row] = m;
+		}
+		double m = 0.0;
+		for (int row = 0; row < rows; row++) {
+			if (rowMax[row] > m) m = rowMax[row];
+		}
+		return m;
+	}
+
+	// 单元中心的一维线性插值：细单元 fi 从父单元 fi / 2 取 3/4，从另一侧的相邻粗单元取 1/4
+	// 相邻粗单元在网格外时由父单元取全部权重，相当于常数外推
+	static inline void prolongWeights(int fi, int nc, int& c0, int& c1, float& w0, float& w1)
+	{
+		c0 = fi >> 1;
+		c1 = (fi & 1) ? c0 + 1 : c0 - 1;
+		if (c1 < 0 || c1 >= nc) {
+			c1 = c0;
+			w0 = 1.0f;
+			w1 = 0.0f;
+		}
+		else {
+			w0 = 0.75f;
+			w1 = 0.25f;
+		}
+	}
+
+	void PoissonMultigrid::restrict(const Level& fine, Level& coarse)
+	{
+		const int fnx = fine.nx, fny = fine.ny, fnz = fine.nz;
+		const int cnx = coarse.nx, cny = coarse.ny, cnz = coarse.nz;
+		const bool coarsenZ = fnz > 1;
+		// 粗网格方程的 h^2 是细网格的 4 倍，P^T 的权重和为 2^d
+		const float scale = coarsenZ ? 0.5f : 1.0f;
+		const int rows = cny * cnz;
+		const float* r = fine.r.data();
+
+		// 对每个粗单元收集 P 中指向它的细单元，窗口为每个方向 [2I - 1, 2I + 2]
+#pragma omp parallel for if(mParallel)
+		for (int row = 0; row < rows; row++) {
+			int J = row % cny, K = row / cny;
+			for (int I = 0; I < cnx; I++) {
+				size_t C = I + J * (size_t)cnx + K * (size_t)cnx * cny;
+				if (coarse.type[C] != FLUID) {
+					coarse.b[C] = 0.0f;
+					continue;
+				}
+				float sum = 0.0f;
+				int kBegin = coarsenZ ? 2 * K - 1 : K, kEnd = coarsenZ ? 2 * K + 2 : K;
+				for (int fk = kBegin; fk <= kEnd; fk++) {
+					if (fk < 0 || fk >= fnz) continue;
+					float wz = 1.0f;
+					if (coarsenZ) {
+						int c0, c1; float w0, w1;
+						prolongWeights(fk, cnz, c0, c1, w0, w1);
+						wz = (c0 == K ? w0 : 0.0f) + (c1 == K ? w1 : 0.0f);
+						if (wz == 0.0f) continue;
+					}
+					for (int fj = 2 * J - 1; fj <= 2 * J + 2; fj++) {
+						if (fj < 0 || fj >= fny) continue;
+						int c0, c1; float w0, w1;
+						prolongWeights(fj, cny, c0, c1, w0, w1);
+						float wy = (c0 == J ? w0 : 0.0f) + (c1 == J ? w1 : 0.0f);
+						if (wy == 0.0f) continue;
+						size_t base = fj * (size_t)fnx + fk * (size_t)fnx * fny;
+						for (int fi = 2 * I - 1; fi <= 2 * I + 2; fi++) {
+							if (fi < 0 || fi >= fnx) continue;
+							prolongWeights(fi, cnx, c0, c1, w0, w1);
+							float wx = (c0 == I ? w0 : 0.0f) + (c1 == I ? w1 : 0.0f);
+							sum += wx * wy * wz * r[base + fi];
+						}
+					}
+				}
+				coarse.b[C] = scale * sum;
+			}
+		}
+	}
+
+	void PoissonMultigrid::prolongate(const Level& coarse, Level& fine, bool add)
+	{
+		const int fnx = fine.nx, fny = fine.ny, fnz = fine.nz;
+		const int cnx = coarse.nx, cny = coarse.ny, cnz = coarse.nz;
+		const bool coarsenZ = fnz > 1;
+		const int rows = fny * fnz;
+		const size_t csy = cnx, csz = (size_t)cnx * cny;
+		const float* xc = coarse.x.data();
+
+#pragma omp parallel for if(mParallel)
+		for (int row = 0; row < rows; row++) {
+			int fj = row % fny, fk = row / fny;
+			int j0, j1, k0, k1; float wj0, wj1, wk0, wk1;
+			prolongWeights(fj, cny, j0, j1, wj0, wj1);
+			if (coarsenZ) {
+				prolongWeights(fk, cnz, k0, k1, wk0, wk1);
+			}
+			else {
+				k0 = k1 = fk; wk0 = 1.0f; wk1 = 0.0f;
+			}
+			size_t base = fj * (size_t)fnx + fk * (size_t)fnx * fny;
+			for (int fi = 0; fi < fnx; fi++) {
+				size_t c = base + fi;
+				if (fine.type[c] != FLUID) {
+					continue;
+				}
+				int i0, i1; float wi0, wi1;
+				prolongWeights(fi, cnx, i0, i1, wi0, wi1);
+				float v =
+					wk0 * (wj0 * (wi0 * xc[i0 + j0 * csy + k0 * csz] + wi1 * xc[i1 + j0 * csy + k0 * csz])
+						 + wj1 * (wi0 * xc[i0 + j1 * csy + k0 * csz] + wi1 * xc[i1 + j1 * csy + k0 * csz]))
+				  + wk1 * (wj0 * (wi0 * xc[i0 + j0 * csy + k1 * csz] + wi1 * xc[i1 + j0 * csy + k1 * csz])
+						 + wj1 * (wi0 * xc[i0 + j1 * csy + k1 * csz] + wi1 * xc[i1 + j1 * csy + k1 * csz]));
+				fine.x[c] = add ? fine.x[c] + v : v;
+			}
+		}
+	}
+
+	void PoissonMultigrid::vcycle(int l)
+	{
+		Level& level = mLevels[l];
+		if (l == (int)mLevels.size() - 1) {
+			// 最粗层：正反交替的红黑迭代，保持对称
+			for (int s = 0; s < COARSEST_SWEEPS / 2; s++) {
+				smooth(level, 1, false);
+				smooth(level, 1, true);
+			}
+			return;
+		}
+
+		smooth(level, PRE_SMOOTH, false);
+		residual(level);
+		Level& coarse = mLevels[l + 1];
+		restrict(level, coarse);
+		coarse.x.assign(coarse.x.size(), 0.0f);
+		vcycle(l + 1);
+		prolongate(coarse, level, true);
+		smooth(level, POST_SMOOTH, true);
+	}
+
+	void PoissonMultigrid::fmg()
+	{
+		// 把右端项逐层限制到粗网格
+		int last = (int)mLevels.size() - 1;
+		for (int l = 0; l < last; l++) {
+			mLevels[l].r = mLevels[l].b;
+			restrict(mLevels[l], mLevels[l + 1]);
+		}
+		mLevels[last].x.assign(mLevels[last].x.size(), 0.0f);
+		vcycle(last);
+		for (int l = last - 1; l >= 0; l--) {
+			prolongate(mLevels[l + 1], mLevels[l], false);
+			vcycle(l);
+		}
+	}
+
+	void PoissonMultigrid::removeMean(std::vector<float>& v)
+	{
+		const Level& fine = mLevels[0];
+		double sum = 0.0;
+		size_t count = 0;
+		for (size_t c = 0; c < v.size(); c++) {
+			if (fine.type[c] == FLUID) {
+				sum += v[c];
+				count++;
+			}
+		}
+		if (count == 0) {
+			return;
+		}
+		float mean = (float)(sum / count);
+		const int n = (int)v.size();
+#pragma omp parallel for if(mParallel)
+		for (int c = 0; c < n; c++) {
+			if (fine.type[c] == FLUID) {
+				v[c] -= mean;
+			}
+		}
+	}
+
+	double PoissonMultigrid::dot(const std::vector<float>& a, const std::vector<float>& b)
+	{
+		// 按行求部分和再串行合并，结果与线程数无关
+		const Level& fine = mLevels[0];
+		const int nx = fine.nx;
+		const int rows = fine.ny * fine.nz;
+		std::vector<double> rowSum(rows, 0.0);
+#pragma omp parallel for if(mParallel)
+		for (int row = 0; row < rows; row++) {
+			size_t base = (size_t)row * nx;
+			double s = 0.0;
+			for (int i = 0; i < nx; i++) {
+				s += (double)a[base + i] * b[base + i];
+			}
+			rowSum[row] = s;
+		}
+		double s = 0.0;
+		for (int row = 0; row < rows; row++) {
+			s += rowSum[row];
+		}
+		return s;
+	}
+
+	void PoissonMultigrid::applyA(const std::vector<float>& x, std::vector<float>& y)
+	{
+		const Level& fine = mLevels[0];
+		const int nx = fine.nx, ny = fine.ny, nz = fine.nz;
+		const size_t sy = nx, sz = (size_t)nx * ny;
+		const int rows = ny * nz;
+		const float* xp = x.data();
+#pragma omp parallel for if(mParallel)
+		for (int row = 0; row < rows; row++) {
+			int j = row % ny, k = row / ny;
+			size_t base = j * sy + k * sz;
+			for (int i = 0; i < nx; i++) {
+				size_t c = base + i;
+				y[c] = fine.type[c] == FLUID ? fine.diag[c] * xp[c] - neighborSum(xp, i, j, k, c, nx, ny, nz, sy, sz) : 0.0f;
+			}
+		}
+	}
+
+	int PoissonMultigrid::solve(const float* b, float* x, double tolerance, int maxIterations, bool useInitialGuess, double& residualNorm)
+	{
+		if (mLevels.empty()) {
+			residualNorm = 0.0;
+			return 0;
+		}
+		Level& fine = mLevels[0];
+		size_t n = fine.type.size();
+		double bmax = 0.0;
+		for (size_t c = 0; c < n; c++) {
+			fine.b[c] = fine.type[c] == FLUID ? b[c] : 0.0f;
+			double a = std::fabs((double)fine.b[c]);
+			if (a > bmax) bmax = a;
+		}
+		double target = tolerance * bmax;
+
+		int iterations = 0;
+		residualNorm = 0.0;
+		if (bmax > 0.0) {
+			if (useInitialGuess) {
+				// 从初值直接做 V-cycle，初值已经足够好时一次也不做
+				for (size_t c = 0; c < n; c++) {
+					fine.x[c] = fine.type[c] == FLUID ? x[c] : 0.0f;
+				}
+			}
+			else {
+				fmg();
+				iterations = 1;
+			}
+			residualNorm = residual(fine);
+			while (residualNorm > target && iterations < maxIterations) {
+				vcycle(0);
+				iterations++;
+				residualNorm = residual(fine);
+			}
+			if (mSingular) {
+				removeMean(fine.x);
+			}
+		}
+		else {
+			fine.x.assign(n, 0.0f);
+		}
+
+		for (size_t c = 0; c < n; c++) {
+			x[c] = fine.x[c];
+		}
+		return iterations;
+	}
+
+	int PoissonMultigrid::solvePCG(const float* b, float* x, double tolerance, int maxIterations, bool multigridPreconditioner, bool useInitialGuess, double& residualNorm)
+	{
+		if (mLevels.empty()) {
+			residualNorm = 0.0;
+			return 0;
+		}
+		Level& fine = mLevels[0];
+		const int n = (int)fine.type.size();
+		// V-cycle 预条件会改写各层的 x、b、r，所以 CG 的解与残差用单独的数组保存
+		std::vector<float>& xs = mX;
+		std::vector<float>& rv = mR;
+		std::vector<float>& q = mQ;
+		double bmax = 0.0;
+		for (int c = 0; c < n; c++) {
+			xs[c] = fine.type[c] == FLUID && useInitialGuess ? x[c] : 0.0f;
+			rv[c] = fine.type[c] == FLUID ? b[c] : 0.0f;
+			double a = std::fabs((double)rv[c]);
+			if (a > bmax) bmax = a;
+		}
+		double target = tolerance * bmax;
+		residualNorm = bmax;
+		if (useInitialGuess) {
+			// r = b - A x0
+			applyA(xs, q);
+			double m = 0.0;
+			for (int c = 0; c < n; c++) {
+				rv[c] -= q[c];
+				double a = std::fabs((double)rv[c]);
+				if (a > m) m = a;
+			}
+			residualNorm = m;
+		}
+
+		int iterations = 0;
+		if (residualNorm > target) {
+			auto precondition = [&]() {
+				if (multigridPreconditioner) {
+					for (int c = 0; c < n; c++) fine.b[c] = rv[c];
+					fine.x.assign(n, 0.0f);
+					vcycle(0);
+					mZ = fine.x;
+					if (mSingular) removeMean(mZ);
+				}
+				else {
+#pragma omp parallel for if(mParallel)
+					for (int c = 0; c < n; c++) {
+						mZ[c] = fine.type[c] == FLUID ? rv[c] / fine.diag[c] : 0.0f;
+					}
+				}
+			};
+
+			precondition();
+			mS = mZ;
+			double sigma = dot(mZ, rv);
+			while (iterations < maxIterations) {
+				applyA(mS, q);
+				double sq = dot(mS, q);
+				if (sq == 0.0) {
+					break;
+				}
+				float alpha = (float)(sigma / sq);
+#pragma omp parallel for if(mParallel)
+				for (int c = 0; c < n; c++) {
+					xs[c] += alpha * mS[c];
+					rv[c] -= alpha * q[c];
+				}
+				iterations++;
+
+				double m = 0.0;
+				for (int c = 0; c < n; c++) {
+					double a = std::fabs((double)rv[c]);
+					if (a > m) m = a;
+				}
+				residualNorm = m;
+				if (residualNorm <= target) {
+					break;
+				}
+
+				precondition();
+				double sigmaNew = dot(mZ, rv);
+				float beta = (float)(sigmaNew / sigma);
+				sigma = sigmaNew;
+#pragma omp parallel for if(mParallel)
+				for (int c = 0; c < n; c++) {
+					mS[c] = mZ[c] + beta * mS[c];
+				}
+			}
+		}
+		if (mSingular) {
+			removeMean(xs);
+		}
+
+		for (int c = 0; c < n; c++) {
+			x[c] = xs[c];
+		}
+		return iterations;
+	}
+}
@@ -0,0 +1,75 @@
+﻿/**
+ * Backend2d.h: 2D欧拉流体求解器的计算后端
+ * 提供按行并行的循环与向量化内核，由 Eulerian2dPara::backend 选择
+ */
+
+#pragma once
+#ifndef __EULERIAN_2D_BACKEND_2D_H__
+#define __EULERIAN_2D_BACKEND_2D_H__
+
+#include <functional>
+#include "Configure.h"
+#include "GridData2d.h"
+
+namespace FluidSimulation
+{
+    namespace Eulerian2d
+    {
+        /**
+         * 后端接口
+         */
+        class Backend2d
+        {
+        public:
+            virtual ~Backend2d() {}
+
+            virtual const char* name() const = 0;
+
+            // 对 [begin, end) 中的每一行 j 执行 body(j)
+            // 调用者需保证不同行之间没有写冲突
+            virtual void forEachRow(int begin, int end, const std::function<void(int)>& body);
+
+            // dst[i] = 2 * dst[i] - src[i]，i 属于 [0, n)，在调用线程上执行
+            virtual void reflectSpan(Glb::Real* dst, const Glb::Real* src, int n);
+
+            // 红黑 SOR 一行中同色单元的松弛，i 属于 [0, n)，在调用线程上执行
+            // p[i] += omega * (invDiag[i] * (b[i] + west[i] + west[i + 1] + down[i] + up[i]) - p[i])
+            // 邻居都属于另一种颜色，east 即 west + 1
+            virtual void relaxSpan(Glb::Real* p, const Glb::Real* b, const Glb::Real* invDiag,
+                const Glb::Real* west, const Glb::Real* down, const Glb::Real* up, int n, Glb::Real omega);
+        };
+
+        // 单线程参考实现
+        class ScalarBackend2d : public Backend2d
+        {
+        public:
+            virtual const char* name() const;
+        };
+
+        // OpenMP 按行并行
+        class ThreadedBackend2d : public Backend2d
+        {
+        public:
+            virtual const char* name() const;
+            virtual void forEachRow(int begin, int end, const std::function<void(int)>& body);
+        };
+
+        // 按行并行 + AVX2 内核
+        class SimdBackend2d : public ThreadedBackend2d
+        {
+        public:
+            virtual const char* name() const;
+            virtual void reflectSpan(Glb::Real* dst, const Glb::Real* src, int n);
+            virtual void relaxSpan(Glb::Real* p, const Glb::Real* b, const Glb::Real* invDiag,
+                const Glb::Real* west, const Glb::Real* down, const Glb::Real* up, int n, Glb::Real omega);
+        };
+
+        /**
+         * 根据 SolverBackend 创建后端
+         * 2D 没有 CUDA 实现，CUDA 与不支持 AVX2 时的 SIMD 回退到多线程后端
+         */
+        Backend2d* createBackend2d(int type);
+    }
+}
+
+#endif // !__EULERIAN_2D_BACKEND_2D_H__
@@ -27,7 +27,10 @@ namespace FluidSimulation
             MACGrid2d();
             ~MACGrid2d();
             MACGrid2d(const MACGrid2d &orig);
+            MACGrid2d(MACGrid2d &&orig) noexcept;
+            // ƸֵеĴ洢·
             MACGrid2d &operator=(const MACGrid2d &orig);
+            MACGrid2d &operator=(MACGrid2d &&orig) noexcept;
 
             void reset();
 
@@ -38,16 +41,34 @@ namespace FluidSimulation
             void initialize();
             void createSolids();
             void updateSources();
+            // ޸ڲٶȺٶȳ鵥Ԫ
+            void fillBoundaries();
+            // ǰ̨̨壬ֻڲ飬
+            void swapVelocityBuffers();
+            void swapScalarBuffers();
 
             // advect
+            // ʹõĻַ Eulerian2dPara::traceIntegrator 
             glm::vec2 semiLagrangian(const glm::vec2 &pt, double dt);
+            // ·ϵĵЧٶȣλΪ pt - traceVelocity(pt, dt) * dt
+            glm::vec2 traceVelocity(const glm::vec2 &pt, double dt);
+            // ݣxy Ϊ n ꣨SoAݺλд outXoutY
+            void semiLagrangian(const float *x, const float *y, float *outX, float *outY, int n, double dt);
 
             // get value
             glm::vec2 getVelocity(const glm::vec2 &pt);
-            double getVelocityX(const glm::vec2 &pt);
-            double getVelocityY(const glm::vec2 &pt);
-            double getTemperature(const glm::vec2 &pt);
-            double getDensity(const glm::vec2 &pt);
+            Glb::Real getVelocityX(const glm::vec2 &pt);
+            Glb::Real getVelocityY(const glm::vec2 &pt);
+            Glb::Real getTemperature(const glm::vec2 &pt);
+            Glb::Real getDensity(const glm::vec2 &pt);
+
+            // ͬ
+            void getVelocity(const float *x, const float *y, Glb::Real *u, Glb::Real *v, int n);
+            void getTemperature(const float *x, const float *y, Glb::Real *out, int n);
+            void getDensity(const float *x, const float *y, Glb::Real *out, int n);
+
+            // ʱÿĲ߿԰ѻջ
+            static const int SAMPLE_BATCH = 64;
 
             enum Direction
             {
@@ -77,16 +98,35 @@ namespace FluidSimulation
             int numSolidCells();
 
             // pressure
-            double getPressureCoeffBetweenCells(int i0, int j0, int i1, int j1);
+            Glb::Real getPressureCoeffBetweenCells(int i0, int j0, int i1, int j1);
+
+            /**
+             * ѹɷ̵ 5 ģ壨ԽǴ״洢 createSolids װֲʱؽ
+             * ÿԪһλ룬ǱԪĸھǷΪǹ壬Ϊ
+             * ǶԽԪڶӦλλʱΪ -1Ϊ 0
+             */
+            enum StencilBit
+            {
+                STENCIL_FLUID = 1,      // (i, j)
+                STENCIL_RIGHT = 2,      // (i + 1, j)
+                STENCIL_LEFT = 4,       // (i - 1, j)
+                STENCIL_TOP = 8,        // (i, j + 1)
+                STENCIL_BOTTOM = 16     // (i, j - 1)
+            };
+            unsigned char getStencilMask(int i, int j) const { return mStencilMask[i + j * dim[0]]; }
+            // ԽԪǹھ嵥ԪΪ 0
+            Glb::Real getStencilDiag(int i, int j) const { return mStencilDiag[i + j * dim[0]]; }
+            // ֲÿıһθ£ݴжϻľԤǷ
+            unsigned int getSolidVersion() const { return mSolidVersion; }
             
             // ɢ
-            double getDivergence(int i, int j);
+            Glb::Real getDivergence(int i, int j);
             // ɢ
-            double checkDivergence(int i, int j);
+            Glb::Real checkDivergence(int i, int j);
             bool checkDivergence();
 
             // Boussinesq Force
-            double getBoussinesqForce(const glm::vec2 &pt);
+            Glb::Real getBoussinesqForce(const glm::vec2 &pt);
 
             float cellSize;             // ԪС
             int dim[2];                 // ά [, ]
@@ -99,6 +139,26 @@ namespace FluidSimulation
             Glb::CubicGridData2d mT;    // ¶ȳ
             Glb::CubicGridData2d mP;    // pressure
             Glb::GridData2d mSolid;     // ǣ1ʾ壬0ʾ壩
+
+            // ̨壬ƽǰ̨ȡд̨ɺ󽻻
+            Glb::GridData2dX mUBack;
+            Glb::GridData2dY mVBack;
+            Glb::CubicGridData2d mDBack;
+            Glb::CubicGridData2d mTBack;
+
+            // BFECC / MacCormack ƽм
+            Glb::GridData2dX mUAux;
+            Glb::GridData2dY mVAux;
+            Glb::CubicGridData2d mDAux;
+            Glb::CubicGridData2d mTAux;
+
+        protected:
+            //  mSolid װѹģ壬ϴͬʱԭеģ汾
+            void buildPressureStencil();
+
+            std::vector<unsigned char> mStencilMask;    // StencilBit ϣ i + j * dim[0] 
+            std::vector<Glb::Real> mStencilDiag;
+            unsigned int mSolidVersion;
         };
 
 /**
@@ -0,0 +1,57 @@
+﻿/**
+ * PCGSolver2d.h: 2D压力泊松方程的预条件共轭梯度求解器
+ * 只在流体单元上求解，系数取自 MACGrid2d 的压力模板，预条件子为 MIC(0)
+ */
+
+#pragma once
+#ifndef __EULERIAN_2D_PCG_SOLVER_2D_H__
+#define __EULERIAN_2D_PCG_SOLVER_2D_H__
+
+#include <vector>
+#include "MACGrid2d.h"
+#include "Backend2d.h"
+
+namespace FluidSimulation
+{
+    namespace Eulerian2d
+    {
+        class PCGSolver2d
+        {
+        public:
+            PCGSolver2d(Backend2d* backend);
+
+            /**
+             * 求解 A p = b，b 与 p 按 i + j * numX 存放，固体单元上的值被忽略，解为 0
+             * 残差的无穷范数不超过 tolerance * max|b| 或达到 maxIterations 时结束
+             * useInitialGuess 为 true 时以 p 的输入为初值，否则从 0 开始
+             * @return 使用的迭代次数，residual 为最终残差的无穷范数
+             */
+            int solve(MACGrid2d& grid, const std::vector<double>& b, std::vector<double>& p, double tolerance, int maxIterations, bool useInitialGuess, double& residual);
+
+        protected:
+            // 根据固体分布组装矩阵并计算 MIC(0) 预条件子，固体分布不变时直接返回
+            void build(MACGrid2d& grid);
+            // y = A x
+            void applyA(const std::vector<double>& x, std::vector<double>& y);
+            // z = M^-1 r，前代与回代都有行间依赖，串行执行
+            void applyPreconditioner(const std::vector<double>& r, std::vector<double>& z);
+            // 按行求部分和后串行合并，结果与线程数无关
+            double dot(const std::vector<double>& a, const std::vector<double>& b);
+            double maxAbs(const std::vector<double>& a);
+
+            Backend2d* mBackend;
+            int mNumX, mNumY;
+            unsigned int mVersion;  // 已组装的矩阵对应的 MACGrid2d::getSolidVersion
+
+            std::vector<double> mDiag;      // A 的对角元，非流体单元为 0
+            std::vector<double> mPlusI;     // (i, j) 与 (i + 1, j) 之间的系数
+            std::vector<double> mPlusJ;     // (i, j) 与 (i, j + 1) 之间的系数
+            std::vector<double> mPrecon;    // MIC(0) 分解的对角元的倒数
+
+            std::vector<double> mR, mZ, mS; // 残差、预条件后的残差、搜索方向
+            std::vector<double> mRowSum;    // 每行的部分和
+        };
+    }
+}
+
+#endif // !__EULERIAN_2D_PCG_SOLVER_2D_H__
@@ -9,32 +9,124 @@
 
 #include "MACGrid2d.h"
 #include "Global.h"
+#include "Backend2d.h"
+#include "PCGSolver2d.h"
+#include "Multigrid.h"
+#include "FastPoisson.h"
+#include "PressureMonitor.h"
 
 namespace FluidSimulation {
     namespace Eulerian2d {
         class Solver {
         public:
             Solver(MACGrid2d& grid);
+            ~Solver();
 
             void solve();
 
         protected:
 
+            // ƽһӲ
+            void step(float dt);
+            // ٶȸֵֵвÿеֵϲ
+            float maxVelocity();
+
             void vel_step(float dt);
             void dens_step(float dt);
 
+            // ƽһ鳡
+            struct Fields
+            {
+                Glb::GridData2dX& u;
+                Glb::GridData2dY& v;
+                Glb::CubicGridData2d& d;
+                Glb::CubicGridData2d& t;
+            };
+
             // 1. advection
             // 2. compute external forces
             // 3. projection
+            // ƽʽ Eulerian2dPara::advectionScheme 
             void advect(float dt);
+            // λû÷ʹáݺд롢ֱӶȡ
+            enum TraceCacheMode { CACHE_NONE, CACHE_STORE, CACHE_LOAD };
+            // һΰƽsrc Ϊʱֻݲ dst ԭֵrange Ϊʱ
+            // ͬһ dt ͬĸλͬ cache Ƿ
+            void advectPass(float dt, Fields* src, Fields& dst, Fields* range, TraceCacheMode cache);
+            // out = a + (b - c) / 2
+            void addHalfDifference(Fields& out, Fields& a, Fields& b, Fields& c);
+            template <typename Grid>
+            void addHalfDifference(Grid& out, Grid& a, Grid& b, Grid& c);
 
             void computeforces(float dt);
 
             void project(float dt);
+            //  100 ԭ Gauss-Seidel  monitor вǰ
+            void solvePressureGaussSeidel(float dt, Glb::PressureMonitor& monitor);
+            // Ԥݶ
+            void solvePressurePCG(float dt, Glb::PressureMonitor& monitor);
+            //  SORͬɫԪ֮ûɰвв
+            void solvePressureRedBlackSOR(float dt, Glb::PressureMonitor& monitor);
+            // ζuseCG Ϊ true ʱΪݶȵԤйʱΪԤ
+            void solvePressureMultigrid(float dt, bool useCG, Glb::PressureMonitor& monitor);
+            // ûйʱ FFT ֱ⣬ MGPCG
+            void solvePressureFFT(float dt, Glb::PressureMonitor& monitor);
+            // ĽmPressure в˫ȣÿõ MGPCG  A e = r  p += e
+            void solvePressureMixed(float dt, Glb::PressureMonitor& monitor);
+            // ֻڹֲıʱؽĲ㼶
+            void setupMultigrid();
+            // Ҷ b = -div * rho * h^2 / dt嵥ԪΪ 0 max|b|
+            double buildPressureRhs(float dt);
+            // װҶʼӣʱ mP еĳֵƵ mPressure max|b|
+            double beginPressureSolve(float dt, Glb::PressureMonitor& monitor);
+            //  mPressure д mP
+            void storePressure();
+            // ǰ mP 嵥ԪϵĲв b + sum(ǹھ p) - s * p rhsNorm Ϊʱͬʱ max|b|
+            double pressureResidual(float dt, double* rhsNorm = nullptr);
+            // mCorrection = mRhs - A mPressureȫ˫ȣ
+            double correctionResidual();
 
             void reflectVelocity();
 
             MACGrid2d& mGrid;
+            Backend2d* mBackend;    // ˣ Eulerian2dPara::backend 
+
+            std::vector<float> mRowMax;     // maxVelocity ÿеֵ
+            std::vector<double> mRowResidual;   // ѹвÿеֵ
+            std::vector<double> mRowRhs;        // Ҷÿеֵ
+
+            // һͶӰѹ mPressureDt / dt Ϊֵproject ʼʱд mP
+            bool mWarmStart;
+            float mPressureDt;      // һͶӰʱ䲽0 ʾûͶӰ
+
+            // ֡Ӳѹʱ
+            int mPressureIterations;
+            double mPressureTime;
+
+            PCGSolver2d mPCG;
+            std::vector<double> mRhs;       // ѹ̵Ҷ i + j * numX 
+            std::vector<double> mPressure;  // PCG Ľ
+
+            Glb::PoissonMultigrid mMultigrid;
+            std::vector<unsigned char> mCellType;   // ĵԪͣ i + j * numX 
+            unsigned int mCellTypeVersion;          // mCellType Ӧ MACGrid2d::getSolidVersion
+            bool mCellTypeHasSolid;                 // mCellType й嵥ԪʱĶ mgpcg
+            bool mMultigridFallbackLogged;
+            std::vector<float> mRhsFloat, mPressureFloat;
+            std::vector<double> mCorrection;        // Ľ˫Ȳв
+
+            Glb::FastPoisson mFastPoisson;  // ȫΪʱ߽缴 Neumann ߽
+            unsigned int mFastPoissonVersion;   // mFastPoissonUsable Ӧ MACGrid2d::getSolidVersion
+            bool mFastPoissonUsable;
+
+            //  SOR ɫֿţ c ɫ j еĵԪ i = 2m + ((j + c) & 1)  (j + 1) * stride + 1 + m
+            // ܸһֵΪ 0 鵥Ԫ嵥Ԫ invDiag Ϊ 0ѹΪ 0
+            std::vector<Glb::Real> mSorP[2], mSorB[2], mSorInvDiag[2];
+            unsigned int mSorVersion;   // mSorInvDiag Ӧ MACGrid2d::getSolidVersion
+
+            // U 桢V 桢ԪĻλã (numX + 1) Ϊп
+            std::vector<float> mTraceX[3];
+            std::vector<float> mTraceY[3];
         };
     }
 }
@@ -0,0 +1,80 @@
+﻿/**
+ * Backend2d.cpp: 2D欧拉流体计算后端实现
+ */
+
+#include "Backend2d.h"
+#include "Global.h"
+#include "Logger.h"
+
+namespace FluidSimulation
+{
+    namespace Eulerian2d
+    {
+        void Backend2d::forEachRow(int begin, int end, const std::function<void(int)>& body)
+        {
+            for (int j = begin; j < end; j++) {
+                body(j);
+            }
+        }
+
+        void Backend2d::reflectSpan(Glb::Real* dst, const Glb::Real* src, int n)
+        {
+            for (int i = 0; i < n; i++) {
+                dst[i] = Glb::Real(2) * dst[i] - src[i];
+            }
+        }
+
+        void Backend2d::relaxSpan(Glb::Real* p, const Glb::Real* b, const Glb::Real* invDiag,
+            const Glb::Real* west, const Glb::Real* down, const Glb::Real* up, int n, Glb::Real omega)
+        {
+            for (int i = 0; i < n; i++) {
+                p[i] += omega * (invDiag[i] * (b[i] + west[i] + west[i + 1] + down[i] + up[i]) - p[i]);
+            }
+        }
+
+        const char* ScalarBackend2d::name() const
+        {
+            return solverBackendNames[BACKEND_SCALAR];
+        }
+
+        const char* ThreadedBackend2d::name() const
+        {
+            return solverBackendNames[BACKEND_THREADED];
+        }
+
+        void ThreadedBackend2d::forEachRow(int begin, int end, const std::function<void(int)>& body)
+        {
+#pragma omp parallel for schedule(static)
+            for (int j = begin; j < end; j++) {
+                body(j);
+            }
+        }
+
+        const char* SimdBackend2d::name() const
+        {
+            return solverBackendNames[BACKEND_SIMD];
+        }
+
+        Backend2d* createBackend2d(int type)
+        {
+            // 只有 SIMD 后端使用 AVX2 批量插值，其余后端保持逐点插值作为参考
+            Glb::setGridSimdEnabled(type == BACKEND_SIMD);
+            switch (type) {
+            case BACKEND_SCALAR:
+                return new ScalarBackend2d();
+            case BACKEND_SIMD:
+                if (Glb::cpuSupportsAVX2()) {
+                    return new SimdBackend2d();
+                }
+                Glb::Logger::getInstance().addLog("AVX2 is not supported on this CPU, fall back to threaded backend.");
+                break;
+            case BACKEND_CUDA:
+                Glb::Logger::getInstance().addLog("2d solver has no CUDA backend, fall back to threaded backend.");
+                break;
+            default:
+                break;
+            }
+            return new ThreadedBackend2d();
+        }
+    }
+}
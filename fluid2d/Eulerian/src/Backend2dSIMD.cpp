@@ -0,0 +1,98 @@
+﻿/**
+ * Backend2dSIMD.cpp: 2D欧拉流体 SIMD 后端的 AVX2 内核
+ * 该文件单独以 AVX2 指令集编译，未以 AVX2 编译时退化为标量循环
+ */
+
+#include "Backend2d.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace FluidSimulation
+{
+    namespace Eulerian2d
+    {
+#if defined(__AVX2__)
+        // 双精度，每次处理 4 个元素
+        static inline int reflectAVX2(double* dst, const double* src, int n)
+        {
+            const __m256d two = _mm256_set1_pd(2.0);
+            int i = 0;
+            for (; i + 4 <= n; i += 4) {
+                __m256d d = _mm256_loadu_pd(dst + i);
+                _mm256_storeu_pd(dst + i, _mm256_fmsub_pd(two, d, _mm256_loadu_pd(src + i)));
+            }
+            return i;
+        }
+
+        // 单精度，每次处理 8 个元素
+        static inline int reflectAVX2(float* dst, const float* src, int n)
+        {
+            const __m256 two = _mm256_set1_ps(2.0f);
+            int i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m256 d = _mm256_loadu_ps(dst + i);
+                _mm256_storeu_ps(dst + i, _mm256_fmsub_ps(two, d, _mm256_loadu_ps(src + i)));
+            }
+            return i;
+        }
+
+        static inline int relaxAVX2(double* p, const double* b, const double* invDiag,
+            const double* west, const double* down, const double* up, int n, double omega)
+        {
+            const __m256d w = _mm256_set1_pd(omega);
+            int i = 0;
+            for (; i + 4 <= n; i += 4) {
+                __m256d sum = _mm256_add_pd(_mm256_loadu_pd(b + i), _mm256_loadu_pd(west + i));
+                sum = _mm256_add_pd(sum, _mm256_loadu_pd(west + i + 1));
+                sum = _mm256_add_pd(sum, _mm256_loadu_pd(down + i));
+                sum = _mm256_add_pd(sum, _mm256_loadu_pd(up + i));
+                __m256d old = _mm256_loadu_pd(p + i);
+                __m256d delta = _mm256_fmsub_pd(_mm256_loadu_pd(invDiag + i), sum, old);
+                _mm256_storeu_pd(p + i, _mm256_fmadd_pd(w, delta, old));
+            }
+            return i;
+        }
+
+        static inline int relaxAVX2(float* p, const float* b, const float* invDiag,
+            const float* west, const float* down, const float* up, int n, float omega)
+        {
+            const __m256 w = _mm256_set1_ps(omega);
+            int i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m256 sum = _mm256_add_ps(_mm256_loadu_ps(b + i), _mm256_loadu_ps(west + i));
+                sum = _mm256_add_ps(sum, _mm256_loadu_ps(west + i + 1));
+                sum = _mm256_add_ps(sum, _mm256_loadu_ps(down + i));
+                sum = _mm256_add_ps(sum, _mm256_loadu_ps(up + i));
+                __m256 old = _mm256_loadu_ps(p + i);
+                __m256 delta = _mm256_fmsub_ps(_mm256_loadu_ps(invDiag + i), sum, old);
+                _mm256_storeu_ps(p + i, _mm256_fmadd_ps(w, delta, old));
+            }
+            return i;
+        }
+#endif
+
+        void SimdBackend2d::relaxSpan(Glb::Real* p, const Glb::Real* b, const Glb::Real* invDiag,
+            const Glb::Real* west, const Glb::Real* down, const Glb::Real* up, int n, Glb::Real omega)
+        {
+            int i = 0;
+#if defined(__AVX2__)
+            i = relaxAVX2(p, b, invDiag, west, down, up, n, omega);
+#endif
+            for (; i < n; i++) {
+                p[i] += omega * (invDiag[i] * (b[i] + west[i] + west[i + 1] + down[i] + up[i]) - p[i]);
+            }
+        }
+
+        void SimdBackend2d::reflectSpan(Glb::Real* dst, const Glb::Real* src, int n)
+        {
+            int i = 0;
+#if defined(__AVX2__)
+            i = reflectAVX2(dst, src, n);
+#endif
+            for (; i < n; i++) {
+                dst[i] = Glb::Real(2) * dst[i] - src[i];
+            }
+        }
+    }
+}
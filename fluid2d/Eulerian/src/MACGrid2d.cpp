@@ -3,13 +3,14 @@
 #include <math.h>
 #include <map>
 #include <stdio.h>
+#include <utility>
 
 namespace FluidSimulation
 {
     namespace Eulerian2d
     {
 
-        MACGrid2d::MACGrid2d()
+        MACGrid2d::MACGrid2d() : mSolidVersion(0)
         {
             cellSize = Eulerian2dPara::theCellSize2d;
             dim[0] = Eulerian2dPara::theDim2d[0];
@@ -18,12 +19,25 @@ namespace FluidSimulation
         }
 
         MACGrid2d::MACGrid2d(const MACGrid2d &orig)
+            : cellSize(orig.cellSize), mU(orig.mU), mU_half(orig.mU_half), mV(orig.mV), mV_half(orig.mV_half),
+              mD(orig.mD), mT(orig.mT), mP(orig.mP), mSolid(orig.mSolid),
+              mUBack(orig.mUBack), mVBack(orig.mVBack), mDBack(orig.mDBack), mTBack(orig.mTBack),
+              mUAux(orig.mUAux), mVAux(orig.mVAux), mDAux(orig.mDAux), mTAux(orig.mTAux),
+              mStencilMask(orig.mStencilMask), mStencilDiag(orig.mStencilDiag), mSolidVersion(orig.mSolidVersion)
         {
-            mU = orig.mU;
-            mV = orig.mV;
-            mD = orig.mD;
-            mT = orig.mT;
-            mSolid = orig.mSolid;
+            dim[0] = orig.dim[0];
+            dim[1] = orig.dim[1];
+        }
+
+        MACGrid2d::MACGrid2d(MACGrid2d &&orig) noexcept
+            : cellSize(orig.cellSize), mU(std::move(orig.mU)), mU_half(std::move(orig.mU_half)), mV(std::move(orig.mV)), mV_half(std::move(orig.mV_half)),
+              mD(std::move(orig.mD)), mT(std::move(orig.mT)), mP(std::move(orig.mP)), mSolid(std::move(orig.mSolid)),
+              mUBack(std::move(orig.mUBack)), mVBack(std::move(orig.mVBack)), mDBack(std::move(orig.mDBack)), mTBack(std::move(orig.mTBack)),
+              mUAux(std::move(orig.mUAux)), mVAux(std::move(orig.mVAux)), mDAux(std::move(orig.mDAux)), mTAux(std::move(orig.mTAux)),
+              mStencilMask(std::move(orig.mStencilMask)), mStencilDiag(std::move(orig.mStencilDiag)), mSolidVersion(orig.mSolidVersion)
+        {
+            dim[0] = orig.dim[0];
+            dim[1] = orig.dim[1];
         }
 
         MACGrid2d &MACGrid2d::operator=(const MACGrid2d &orig)
@@ -32,11 +46,60 @@ namespace FluidSimulation
             {
                 return *this;
             }
-            mU = orig.mU;
-            mV = orig.mV;
-            mD = orig.mD;
-            mT = orig.mT;
-            mSolid = orig.mSolid;
+            cellSize = orig.cellSize;
+            dim[0] = orig.dim[0];
+            dim[1] = orig.dim[1];
+            mU.copyFrom(orig.mU);
+            mU_half.copyFrom(orig.mU_half);
+            mV.copyFrom(orig.mV);
+            mV_half.copyFrom(orig.mV_half);
+            mD.copyFrom(orig.mD);
+            mT.copyFrom(orig.mT);
+            mP.copyFrom(orig.mP);
+            mSolid.copyFrom(orig.mSolid);
+            mUBack.copyFrom(orig.mUBack);
+            mVBack.copyFrom(orig.mVBack);
+            mDBack.copyFrom(orig.mDBack);
+            mTBack.copyFrom(orig.mTBack);
+            mUAux.copyFrom(orig.mUAux);
+            mVAux.copyFrom(orig.mVAux);
+            mDAux.copyFrom(orig.mDAux);
+            mTAux.copyFrom(orig.mTAux);
+            mStencilMask = orig.mStencilMask;
+            mStencilDiag = orig.mStencilDiag;
+            mSolidVersion = orig.mSolidVersion;
+
+            return *this;
+        }
+
+        MACGrid2d &MACGrid2d::operator=(MACGrid2d &&orig) noexcept
+        {
+            if (&orig == this)
+            {
+                return *this;
+            }
+            cellSize = orig.cellSize;
+            dim[0] = orig.dim[0];
+            dim[1] = orig.dim[1];
+            mU = std::move(orig.mU);
+            mU_half = std::move(orig.mU_half);
+            mV = std::move(orig.mV);
+            mV_half = std::move(orig.mV_half);
+            mD = std::move(orig.mD);
+            mT = std::move(orig.mT);
+            mP = std::move(orig.mP);
+            mSolid = std::move(orig.mSolid);
+            mUBack = std::move(orig.mUBack);
+            mVBack = std::move(orig.mVBack);
+            mDBack = std::move(orig.mDBack);
+            mTBack = std::move(orig.mTBack);
+            mUAux = std::move(orig.mUAux);
+            mVAux = std::move(orig.mVAux);
+            mDAux = std::move(orig.mDAux);
+            mTAux = std::move(orig.mTAux);
+            mStencilMask = std::move(orig.mStencilMask);
+            mStencilDiag = std::move(orig.mStencilDiag);
+            mSolidVersion = orig.mSolidVersion;
 
             return *this;
         }
@@ -49,8 +112,21 @@ namespace FluidSimulation
         {
             mU.initialize(0.0);
             mV.initialize(0.0);
+            mU_half.initialize(0.0);
+            mV_half.initialize(0.0);
             mD.initialize(0.0);
             mT.initialize(Eulerian2dPara::ambientTemp);
+            mP.initialize(0.0);
+
+            // ̨鵥ԪĬֵǰ̨һ
+            mUBack.initialize(0.0);
+            mVBack.initialize(0.0);
+            mDBack.initialize(0.0);
+            mTBack.initialize(Eulerian2dPara::ambientTemp);
+            mUAux.initialize(0.0);
+            mVAux.initialize(0.0);
+            mDAux.initialize(0.0);
+            mTAux.initialize(Eulerian2dPara::ambientTemp);
         }
 
         void MACGrid2d::createSolids()
@@ -62,6 +138,38 @@ namespace FluidSimulation
                     mSolid(i, j) = 1;
                 }
             }
+            buildPressureStencil();
+        }
+
+        void MACGrid2d::buildPressureStencil()
+        {
+            int n = dim[0] * dim[1];
+            std::vector<unsigned char> mask(n);
+            for (int j = 0; j < dim[1]; j++) {
+                for (int i = 0; i < dim[0]; i++) {
+                    unsigned char m = 0;
+                    m |= isSolidCell(i, j) ? 0 : STENCIL_FLUID;
+                    m |= isSolidCell(i + 1, j) ? 0 : STENCIL_RIGHT;
+                    m |= isSolidCell(i - 1, j) ? 0 : STENCIL_LEFT;
+                    m |= isSolidCell(i, j + 1) ? 0 : STENCIL_TOP;
+                    m |= isSolidCell(i, j - 1) ? 0 : STENCIL_BOTTOM;
+                    mask[i + j * dim[0]] = m;
+                }
+            }
+            if (mask == mStencilMask)
+                return;
+
+            mStencilMask.swap(mask);
+            mStencilDiag.assign(n, 0.0);
+            for (int k = 0; k < n; k++) {
+                unsigned char m = mStencilMask[k];
+                if (!(m & STENCIL_FLUID))
+                    continue;
+                mStencilDiag[k] = (Glb::Real)(((m & STENCIL_RIGHT) != 0) + ((m & STENCIL_LEFT) != 0) + ((m & STENCIL_TOP) != 0) + ((m & STENCIL_BOTTOM) != 0));
+            }
+            // 汾֮ΨһƵԭ汾
+            static unsigned int nextVersion = 0;
+            mSolidVersion = ++nextVersion;
         }
 
         void MACGrid2d::updateSources()
@@ -69,11 +177,32 @@ namespace FluidSimulation
             for (int i = 0; i < Eulerian2dPara::source.size(); i++) {
                 int x = Eulerian2dPara::source[i].position.x;
                 int y = Eulerian2dPara::source[i].position.y;
+                if (x < 0 || x > dim[0] - 1 || y < 0 || y > dim[1] - 1)
+                    continue;
                 mT(x, y) = Eulerian2dPara::source[i].temp;
                 mD(x, y) = Eulerian2dPara::source[i].density;
                 mU(x, y) = Eulerian2dPara::source[i].velocity.x;
                 mV(x, y) = Eulerian2dPara::source[i].velocity.y;
             }
+            fillBoundaries();
+        }
+
+        void MACGrid2d::fillBoundaries()
+        {
+            mU.fillBoundary();
+            mV.fillBoundary();
+        }
+
+        void MACGrid2d::swapVelocityBuffers()
+        {
+            mU.swap(mUBack);
+            mV.swap(mVBack);
+        }
+
+        void MACGrid2d::swapScalarBuffers()
+        {
+            mD.swap(mDBack);
+            mT.swap(mTBack);
         }
 
         void MACGrid2d::initialize()
@@ -84,12 +213,12 @@ namespace FluidSimulation
         }
 
         // Boussinesq Force
-        double MACGrid2d::getBoussinesqForce(const glm::vec2 &pos)
+        Glb::Real MACGrid2d::getBoussinesqForce(const glm::vec2 &pos)
         {
-            double temperature = getTemperature(pos);
-            double smokeDensity = getDensity(pos);
+            Glb::Real temperature = getTemperature(pos);
+            Glb::Real smokeDensity = getDensity(pos);
 
-            double yforce = -Eulerian2dPara::boussinesqAlpha * smokeDensity +
+            Glb::Real yforce = -Eulerian2dPara::boussinesqAlpha * smokeDensity +
                             Eulerian2dPara::boussinesqBeta * (temperature - Eulerian2dPara::ambientTemp);
 
             return yforce;
@@ -97,31 +226,32 @@ namespace FluidSimulation
 
 
         // ɢ
-        double MACGrid2d::getDivergence(int i, int j)
+        Glb::Real MACGrid2d::getDivergence(int i, int j)
         {
+            // ھһٶΪ 0
+            unsigned char m = getStencilMask(i, j);
+            Glb::Real x1 = (m & STENCIL_RIGHT) ? mU(i + 1, j) : 0.0;
+            Glb::Real x0 = (m & STENCIL_LEFT) ? mU(i, j) : 0.0;
 
-            double x1 = isSolidCell(i + 1, j) ? 0.0 : mU(i + 1, j);
-            double x0 = isSolidCell(i - 1, j) ? 0.0 : mU(i, j);
-
-            double y1 = isSolidCell(i, j + 1) ? 0.0 : mV(i, j + 1);
-            double y0 = isSolidCell(i, j - 1) ? 0.0 : mV(i, j);
+            Glb::Real y1 = (m & STENCIL_TOP) ? mV(i, j + 1) : 0.0;
+            Glb::Real y0 = (m & STENCIL_BOTTOM) ? mV(i, j) : 0.0;
 
-            double xdiv = x1 - x0;
-            double ydiv = y1 - y0;
-            double div = (xdiv + ydiv) / cellSize;
+            Glb::Real xdiv = x1 - x0;
+            Glb::Real ydiv = y1 - y0;
+            Glb::Real div = (xdiv + ydiv) / cellSize;
 
             return div;
         }
 
-        double MACGrid2d::checkDivergence(int i, int j)
+        Glb::Real MACGrid2d::checkDivergence(int i, int j)
         {
-            double x1 = mU(i + 1, j);
-            double x0 = mU(i, j);
-            double y1 = mV(i, j + 1);
-            double y0 = mV(i, j);
-            double xdiv = x1 - x0;
-            double ydiv = y1 - y0;
-            double div = (xdiv + ydiv) / cellSize;
+            Glb::Real x1 = mU(i + 1, j);
+            Glb::Real x0 = mU(i, j);
+            Glb::Real y1 = mV(i, j + 1);
+            Glb::Real y0 = mV(i, j);
+            Glb::Real xdiv = x1 - x0;
+            Glb::Real ydiv = y1 - y0;
+            Glb::Real div = (xdiv + ydiv) / cellSize;
             return div;
         }
 
@@ -129,7 +259,7 @@ namespace FluidSimulation
         {
             FOR_EACH_CELL
             {
-                double div = checkDivergence(i, j);
+                Glb::Real div = checkDivergence(i, j);
                 if (fabs(div) > 0.01)
                 {
                     return false;
@@ -138,9 +268,30 @@ namespace FluidSimulation
             return true;
         }
 
+        glm::vec2 MACGrid2d::traceVelocity(const glm::vec2 &pt, double dt)
+        {
+            float h = (float)dt;
+            glm::vec2 k1 = getVelocity(pt);
+            switch (Eulerian2dPara::traceIntegrator)
+            {
+            case TRACE_RK2:
+                // е㷨
+                return getVelocity(pt - 0.5f * h * k1);
+            case TRACE_RK3:
+            {
+                // Ralston RK3: k2  1/2 k3  3/4 Ȩ 2/93/94/9
+                glm::vec2 k2 = getVelocity(pt - 0.5f * h * k1);
+                glm::vec2 k3 = getVelocity(pt - 0.75f * h * k2);
+                return (2.0f / 9.0f) * k1 + (3.0f / 9.0f) * k2 + (4.0f / 9.0f) * k3;
+            }
+            default:
+                return k1;
+            }
+        }
+
         glm::vec2 MACGrid2d::semiLagrangian(const glm::vec2 &pt, double dt)
         {
-            glm::vec2 vel = getVelocity(pt);
+            glm::vec2 vel = traceVelocity(pt, dt);
             glm::vec2 pos = pt - vel * (float)dt;
 
             pos[0] = max(0.0, min((dim[0] - 1) * cellSize, pos[0]));
@@ -162,6 +313,74 @@ namespace FluidSimulation
             return pos;
         }
 
+        void MACGrid2d::semiLagrangian(const float *x, const float *y, float *outX, float *outY, int n, double dt)
+        {
+            float maxX = (dim[0] - 1) * cellSize;
+            float maxY = (dim[1] - 1) * cellSize;
+            float h = (float)dt;
+            int integrator = Eulerian2dPara::traceIntegrator;
+            Glb::Real u[SAMPLE_BATCH], v[SAMPLE_BATCH];
+            Glb::Real u2[SAMPLE_BATCH], v2[SAMPLE_BATCH];
+            float sx[SAMPLE_BATCH], sy[SAMPLE_BATCH];
+            for (int b = 0; b < n; b += SAMPLE_BATCH)
+            {
+                int m = n - b < SAMPLE_BATCH ? n - b : SAMPLE_BATCH;
+                getVelocity(x + b, y + b, u, v, m);
+
+                // ߽׻ֵÿһȡһٶȣڹڵĲٶΪ 0汾 traceVelocity һ
+                if (integrator == TRACE_RK2 || integrator == TRACE_RK3)
+                {
+                    for (int s = 0; s < m; s++)
+                    {
+                        sx[s] = x[b + s] - 0.5f * h * (float)u[s];
+                        sy[s] = y[b + s] - 0.5f * h * (float)v[s];
+                    }
+                    getVelocity(sx, sy, u2, v2, m);
+                    if (integrator == TRACE_RK2)
+                    {
+                        for (int s = 0; s < m; s++)
+                        {
+                            u[s] = u2[s];
+                            v[s] = v2[s];
+                        }
+                    }
+                    else
+                    {
+                        for (int s = 0; s < m; s++)
+                        {
+                            sx[s] = x[b + s] - 0.75f * h * (float)u2[s];
+                            sy[s] = y[b + s] - 0.75f * h * (float)v2[s];
+                        }
+                        Glb::Real u3[SAMPLE_BATCH], v3[SAMPLE_BATCH];
+                        getVelocity(sx, sy, u3, v3, m);
+                        for (int s = 0; s < m; s++)
+                        {
+                            glm::vec2 k = (2.0f / 9.0f) * glm::vec2(u[s], v[s]) + (3.0f / 9.0f) * glm::vec2(u2[s], v2[s]) + (4.0f / 9.0f) * glm::vec2(u3[s], v3[s]);
+                            u[s] = k[0];
+                            v[s] = k[1];
+                        }
+                    }
+                }
+
+                for (int s = 0; s < m; s++)
+                {
+                    glm::vec2 pt(x[b + s], y[b + s]);
+                    // ڹʱٶΪ 0 Ҫ󽻣汾
+                    if (inSolid(pt))
+                    {
+                        glm::vec2 pos = semiLagrangian(pt, dt);
+                        outX[b + s] = pos[0];
+                        outY[b + s] = pos[1];
+                        continue;
+                    }
+                    glm::vec2 vel(u[s], v[s]);
+                    glm::vec2 pos = pt - vel * (float)dt;
+                    outX[b + s] = max(0.0, min(maxX, pos[0]));
+                    outY[b + s] = max(0.0, min(maxY, pos[1]));
+                }
+            }
+        }
+
         // ȡཻľʱ
         bool MACGrid2d::intersects(const glm::vec2 &wPos, const glm::vec2 &wDir, int i, int j, double &time)
         {
@@ -275,22 +494,46 @@ namespace FluidSimulation
             return vel;
         }
 
-        double MACGrid2d::getVelocityX(const glm::vec2 &pt)
+        void MACGrid2d::getVelocity(const float *x, const float *y, Glb::Real *u, Glb::Real *v, int n)
+        {
+            mU.interpolate(x, y, u, n);
+            mV.interpolate(x, y, v, n);
+            for (int s = 0; s < n; s++)
+            {
+                if (inSolid(glm::vec2(x[s], y[s])))
+                {
+                    u[s] = 0;
+                    v[s] = 0;
+                }
+            }
+        }
+
+        void MACGrid2d::getTemperature(const float *x, const float *y, Glb::Real *out, int n)
+        {
+            mT.interpolate(x, y, out, n);
+        }
+
+        void MACGrid2d::getDensity(const float *x, const float *y, Glb::Real *out, int n)
+        {
+            mD.interpolate(x, y, out, n);
+        }
+
+        Glb::Real MACGrid2d::getVelocityX(const glm::vec2 &pt)
         {
             return mU.interpolate(pt);
         }
 
-        double MACGrid2d::getVelocityY(const glm::vec2 &pt)
+        Glb::Real MACGrid2d::getVelocityY(const glm::vec2 &pt)
         {
             return mV.interpolate(pt);
         }
 
-        double MACGrid2d::getTemperature(const glm::vec2 &pt)
+        Glb::Real MACGrid2d::getTemperature(const glm::vec2 &pt)
         {
             return mT.interpolate(pt);
         }
 
-        double MACGrid2d::getDensity(const glm::vec2 &pt)
+        Glb::Real MACGrid2d::getDensity(const glm::vec2 &pt)
         {
             return mD.interpolate(pt);
         }
@@ -351,7 +594,7 @@ namespace FluidSimulation
         }
 
 
-        double MACGrid2d::getPressureCoeffBetweenCells(
+        Glb::Real MACGrid2d::getPressureCoeffBetweenCells(
             int i, int j, int pi, int pj)
         {
             // ͬһcell
@@ -374,14 +617,14 @@ namespace FluidSimulation
 
         glm::vec4 MACGrid2d::getRenderColor(int i, int j)
         {
-            double value = mD(i, j);
+            Glb::Real value = mD(i, j);
             return glm::vec4(1.0, 1.0, 1.0, value);
         }
 
 
         glm::vec4 MACGrid2d::getRenderColor(const glm::vec2 &pt)
         {
-            double value = getDensity(pt);
+            Glb::Real value = getDensity(pt);
             return glm::vec4(value, value, value, value);
         }
 
@@ -0,0 +1,221 @@
+﻿/**
+ * PCGSolver2d.cpp: 2D压力泊松方程的预条件共轭梯度求解器实现
+ * 参考 Bridson, Fluid Simulation for Computer Graphics, 第 5 章
+ */
+
+#include "PCGSolver2d.h"
+#include <cmath>
+
+namespace FluidSimulation
+{
+    namespace Eulerian2d
+    {
+        // MIC(0) 的修正系数与安全阈值
+        static const double MIC_TAU = 0.97;
+        static const double MIC_SIGMA = 0.25;
+
+        PCGSolver2d::PCGSolver2d(Backend2d* backend) : mBackend(backend), mNumX(0), mNumY(0), mVersion(0)
+        {
+        }
+
+        void PCGSolver2d::build(MACGrid2d& grid)
+        {
+            if (mVersion == grid.getSolidVersion() && mNumX == grid.dim[MACGrid2d::X] && mNumY == grid.dim[MACGrid2d::Y])
+                return;
+            mVersion = grid.getSolidVersion();
+            mNumX = grid.dim[MACGrid2d::X];
+            mNumY = grid.dim[MACGrid2d::Y];
+            int n = mNumX * mNumY;
+            mDiag.assign(n, 0.0);
+            mPlusI.assign(n, 0.0);
+            mPlusJ.assign(n, 0.0);
+            mPrecon.assign(n, 0.0);
+
+            // 没有流体邻居的孤立单元对角元为 0，不参与求解
+            mBackend->forEachRow(0, mNumY, [&](int j) {
+                for (int i = 0; i < mNumX; i++) {
+                    int k = i + j * mNumX;
+                    mDiag[k] = grid.getStencilDiag(i, j);
+                    if (mDiag[k] == 0.0)
+                        continue;
+                    unsigned char mask = grid.getStencilMask(i, j);
+                    mPlusI[k] = (mask & MACGrid2d::STENCIL_RIGHT) ? -1.0 : 0.0;
+                    mPlusJ[k] = (mask & MACGrid2d::STENCIL_TOP) ? -1.0 : 0.0;
+                }
+            });
+
+            // 不完全 Cholesky 分解，按行优先顺序依赖左侧与下方的单元
+            for (int j = 0; j < mNumY; j++) {
+                for (int i = 0; i < mNumX; i++) {
+                    int k = i + j * mNumX;
+                    if (mDiag[k] == 0.0)
+                        continue;
+                    double e = mDiag[k];
+                    if (i > 0) {
+                        double a = mPlusI[k - 1] * mPrecon[k - 1];
+                        e -= a * a + MIC_TAU * mPlusI[k - 1] * mPlusJ[k - 1] * mPrecon[k - 1] * mPrecon[k - 1];
+                    }
+                    if (j > 0) {
+                        double a = mPlusJ[k - mNumX] * mPrecon[k - mNumX];
+                        e -= a * a + MIC_TAU * mPlusJ[k - mNumX] * mPlusI[k - mNumX] * mPrecon[k - mNumX] * mPrecon[k - mNumX];
+                    }
+                    if (e < MIC_SIGMA * mDiag[k])
+                        e = mDiag[k];
+                    mPrecon[k] = 1.0 / sqrt(e);
+                }
+            }
+        }
+
+        void PCGSolver2d::applyA(const std::vector<double>& x, std::vector<double>& y)
+        {
+            mBackend->forEachRow(0, mNumY, [&](int j) {
+                for (int i = 0; i < mNumX; i++) {
+                    int k = i + j * mNumX;
+                    if (mDiag[k] == 0.0) {
+                        y[k] = 0.0;
+                        continue;
+                    }
+                    double v = mDiag[k] * x[k];
+                    if (i > 0)
+                        v += mPlusI[k - 1] * x[k - 1];
+                    if (i < mNumX - 1)
+                        v += mPlusI[k] * x[k + 1];
+                    if (j > 0)
+                        v += mPlusJ[k - mNumX] * x[k - mNumX];
+                    if (j < mNumY - 1)
+                        v += mPlusJ[k] * x[k + mNumX];
+                    y[k] = v;
+                }
+            });
+        }
+
+        void PCGSolver2d::applyPreconditioner(const std::vector<double>& r, std::vector<double>& z)
+        {
+            // 前代 L q = r，q 暂存于 z
+            for (int j = 0; j < mNumY; j++) {
+                for (int i = 0; i < mNumX; i++) {
+                    int k = i + j * mNumX;
+                    if (mDiag[k] == 0.0) {
+                        z[k] = 0.0;
+                        continue;
+                    }
+                    double t = r[k];
+                    if (i > 0)
+                        t -= mPlusI[k - 1] * mPrecon[k - 1] * z[k - 1];
+                    if (j > 0)
+                        t -= mPlusJ[k - mNumX] * mPrecon[k - mNumX] * z[k - mNumX];
+                    z[k] = t * mPrecon[k];
+                }
+            }
+
+            // 回代 L^T z = q
+            for (int j = mNumY - 1; j >= 0; j--) {
+                for (int i = mNumX - 1; i >= 0; i--) {
+                    int k = i + j * mNumX;
+                    if (mDiag[k] == 0.0)
+                        continue;
+                    double t = z[k];
+                    if (i < mNumX - 1)
+                        t -= mPlusI[k] * mPrecon[k] * z[k + 1];
+                    if (j < mNumY - 1)
+                        t -= mPlusJ[k] * mPrecon[k] * z[k + mNumX];
+                    z[k] = t * mPrecon[k];
+                }
+            }
+        }
+
+        double PCGSolver2d::dot(const std::vector<double>& a, const std::vector<double>& b)
+        {
+            mRowSum.assign(mNumY, 0.0);
+            mBackend->forEachRow(0, mNumY, [&](int j) {
+                double s = 0.0;
+                for (int k = j * mNumX; k < (j + 1) * mNumX; k++)
+                    s += a[k] * b[k];
+                mRowSum[j] = s;
+            });
+            double sum = 0.0;
+            for (double s : mRowSum)
+                sum += s;
+            return sum;
+        }
+
+        double PCGSolver2d::maxAbs(const std::vector<double>& a)
+        {
+            mRowSum.assign(mNumY, 0.0);
+            mBackend->forEachRow(0, mNumY, [&](int j) {
+                double m = 0.0;
+                for (int k = j * mNumX; k < (j + 1) * mNumX; k++)
+                    m = fabs(a[k]) > m ? fabs(a[k]) : m;
+                mRowSum[j] = m;
+            });
+            double m = 0.0;
+            for (double s : mRowSum)
+                m = s > m ? s : m;
+            return m;
+        }
+
+        int PCGSolver2d::solve(MACGrid2d& grid, const std::vector<double>& b, std::vector<double>& p, double tolerance, int maxIterations, bool useInitialGuess, double& residual)
+        {
+            build(grid);
+            int n = mNumX * mNumY;
+            if (!useInitialGuess || (int)p.size() != n)
+                p.assign(n, 0.0);
+            mR.assign(n, 0.0);
+            mZ.assign(n, 0.0);
+            mS.assign(n, 0.0);
+
+            // 固体单元不参与求解
+            for (int k = 0; k < n; k++) {
+                mR[k] = mDiag[k] == 0.0 ? 0.0 : b[k];
+                if (mDiag[k] == 0.0)
+                    p[k] = 0.0;
+            }
+
+            residual = maxAbs(mR);
+            if (residual == 0.0) {
+                p.assign(n, 0.0);
+                return 0;
+            }
+            double target = tolerance * residual;
+
+            if (useInitialGuess) {
+                // r = b - A p0
+                applyA(p, mZ);
+                for (int k = 0; k < n; k++)
+                    mR[k] -= mZ[k];
+                residual = maxAbs(mR);
+                if (residual <= target)
+                    return 0;
+            }
+
+            applyPreconditioner(mR, mZ);
+            mS = mZ;
+            double sigma = dot(mZ, mR);
+
+            for (int iteration = 1; iteration <= maxIterations; iteration++) {
+                applyA(mS, mZ);
+                double alpha = sigma / dot(mZ, mS);
+                mBackend->forEachRow(0, mNumY, [&](int j) {
+                    for (int k = j * mNumX; k < (j + 1) * mNumX; k++) {
+                        p[k] += alpha * mS[k];
+                        mR[k] -= alpha * mZ[k];
+                    }
+                });
+
+                residual = maxAbs(mR);
+                if (residual <= target)
+                    return iteration;
+
+                applyPreconditioner(mR, mZ);
+                double sigmaNew = dot(mZ, mR);
+                double beta = sigmaNew / sigma;
+                mBackend->forEachRow(0, mNumY, [&](int j) {
+                    for (int k = j * mNumX; k < (j + 1) * mNumX; k++)
+                        mS[k] = mZ[k] + beta * mS[k];
+                });
+                sigma = sigmaNew;
+            }
+            return maxIterations;
+        }
+    }
+}
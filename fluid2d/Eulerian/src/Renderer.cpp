@@ -112,15 +112,25 @@ namespace FluidSimulation
 			if (Eulerian2dPara::drawModel == 0)
 			{
 				std::vector<float> imageData;
+				imageData.reserve(3 * imageWidth * imageHeight);
+
+				// ÿصĲλܶȣܶȰֵ
+				std::vector<float> rowX(imageWidth), rowY(imageWidth);
+				std::vector<Glb::Real> rowDensity(imageWidth);
 
 				// ÿ
 				for (int j = 1; j <= imageHeight; j++)
 				{
 					for (int i = 1; i <= imageWidth; i++)
 					{
-						float pt_x = i * mGrid.mD.mMax[0] / (imageWidth);
-						float pt_y = j * mGrid.mD.mMax[1] / (imageHeight);
-						glm::vec2 pt(pt_x, pt_y);
+						rowX[i - 1] = i * mGrid.mD.mMax[0] / (imageWidth);
+						rowY[i - 1] = j * mGrid.mD.mMax[1] / (imageHeight);
+					}
+					mGrid.getDensity(rowX.data(), rowY.data(), rowDensity.data(), imageWidth);
+
+					for (int i = 1; i <= imageWidth; i++)
+					{
+						glm::vec2 pt(rowX[i - 1], rowY[i - 1]);
 						
 						// ǹ,Ϊɫ
 						if (mGrid.inSolid(pt)) {
@@ -129,8 +139,9 @@ namespace FluidSimulation
 							imageData.push_back(0);
 						}
 						else {
-							// ܶɫ
-							glm::vec4 color = mGrid.getRenderColor(pt);
+							// ܶɫ getRenderColor(pt) ͬ
+							float value = rowDensity[i - 1];
+							glm::vec4 color(value, value, value, value);
 							imageData.push_back(color.x * Eulerian2dPara::contrast);
 							imageData.push_back(color.y * Eulerian2dPara::contrast);
 							imageData.push_back(color.z * Eulerian2dPara::contrast);
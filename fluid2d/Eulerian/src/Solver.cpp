@@ -1,6 +1,8 @@
 ﻿#include "fluid2d/Eulerian/include/Solver.h"
 #include "Configure.h"
-#include <omp.h>
+#include "Logger.h"
+#include "CflController.h"
+#include <cstdio>
 
 /*
 namespace FluidSimulation
@@ -30,14 +32,125 @@ namespace FluidSimulation
 {
     namespace Eulerian2d
     {
-        Solver::Solver(MACGrid2d& grid) : mGrid(grid)
+        /**
+         * 对一行采样点 i 属于 [begin, end) 做批量半拉格朗日回溯
+         * solid(i) 为真的采样由 solid 自行处理，其余采样每凑满一批调用一次 sample(m, idx, x, y)
+         * idx 为这一批采样的 i，x、y 为回溯后的位置
+         * cacheX、cacheY 不为空时指向该行的回溯位置缓存，load 为真时直接读取，否则回溯后写入
+         */
+        template <typename Solid, typename Pos, typename Sample>
+        static void traceRow(MACGrid2d& grid, int begin, int end, double dt, float* cacheX, float* cacheY, bool load, Solid solid, Pos pos, Sample sample)
+        {
+            const int B = MACGrid2d::SAMPLE_BATCH;
+            int idx[B];
+            float px[B], py[B], bx[B], by[B];
+            int m = 0;
+            auto flush = [&]() {
+                if (load)
+                {
+                    for (int s = 0; s < m; s++)
+                    {
+                        bx[s] = cacheX[idx[s]];
+                        by[s] = cacheY[idx[s]];
+                    }
+                }
+                else
+                {
+                    grid.semiLagrangian(px, py, bx, by, m, dt);
+                    if (cacheX)
+                    {
+                        for (int s = 0; s < m; s++)
+                        {
+                            cacheX[idx[s]] = bx[s];
+                            cacheY[idx[s]] = by[s];
+                        }
+                    }
+                }
+                sample(m, idx, bx, by);
+                m = 0;
+            };
+            for (int i = begin; i < end; i++)
+            {
+                if (solid(i))
+                    continue;
+                idx[m] = i;
+                if (!load)
+                {
+                    glm::vec2 p = pos(i);
+                    px[m] = p[0];
+                    py[m] = p[1];
+                }
+                if (++m == B)
+                    flush();
+            }
+            if (m > 0)
+                flush();
+        }
+
+        Solver::Solver(MACGrid2d& grid) : mGrid(grid), mBackend(createBackend2d(Eulerian2dPara::backend)),
+            mWarmStart(false), mPressureDt(0.0f), mPressureIterations(0), mPressureTime(0.0), mPCG(mBackend),
+            mCellTypeVersion(0), mCellTypeHasSolid(false), mMultigridFallbackLogged(false), mFastPoissonVersion(0), mFastPoissonUsable(false), mSorVersion(0)
         {
             mGrid.reset();
+
+            Glb::Logger::getInstance().addLog(std::string("2d solver backend: ") + mBackend->name());
+        }
+
+        Solver::~Solver()
+        {
+            delete mBackend;
+            mBackend = NULL;
         }
 
         void Solver::solve()
         {
-            float dt = Eulerian2dPara::dt;
+            // 自适应时 Eulerian2dPara::dt 为一帧推进的时间，按 CFL 条件分成若干子步
+            Glb::CflController stepper(Eulerian2dPara::dt, Eulerian2dPara::cflNumber, Eulerian2dPara::maxSubsteps);
+            mPressureIterations = 0;
+            mPressureTime = 0.0;
+            while (!stepper.done())
+            {
+                float vmax = Eulerian2dPara::adaptiveDt ? maxVelocity() : 0.0f;
+                step(stepper.next(vmax, mGrid.cellSize));
+            }
+            stepper.report();
+
+            char text[32];
+            snprintf(text, sizeof(text), "%.2f ms", mPressureTime);
+            Glb::Timer::getInstance().recordValue("pressure iterations", std::to_string(mPressureIterations));
+            Glb::Timer::getInstance().recordValue("pressure time", text);
+        }
+
+        float Solver::maxVelocity()
+        {
+            int numX = mGrid.dim[0];
+            int numY = mGrid.dim[1];
+
+            // 第 j 行包括 U 的第 j 行（j < numY）与 V 的第 j 行
+            mRowMax.assign(numY + 1, 0.0f);
+            mBackend->forEachRow(0, numY + 1, [&](int j) {
+                float m = 0.0f;
+                if (j < numY) {
+                    for (int i = 0; i <= numX; i++) {
+                        float a = fabs((float)mGrid.mU(i, j));
+                        m = a > m ? a : m;
+                    }
+                }
+                for (int i = 0; i < numX; i++) {
+                    float a = fabs((float)mGrid.mV(i, j));
+                    m = a > m ? a : m;
+                }
+                mRowMax[j] = m;
+            });
+
+            float vmax = 0.0f;
+            for (float m : mRowMax)
+                vmax = m > vmax ? m : vmax;
+            return vmax;
+        }
+
+        void Solver::step(float dt)
+        {
             float halfDt = 0.5f * dt;
             //// 第一步: 对流
             //advect(dt);
@@ -48,8 +161,9 @@ namespace FluidSimulation
             //// 第三步: 投影
             //project(dt);
 
-            mGrid.mU_half = mGrid.mU;
-            mGrid.mV_half = mGrid.mV;
+            // 尺寸不变，复用已有的存储
+            mGrid.mU_half.copyFrom(mGrid.mU);
+            mGrid.mV_half.copyFrom(mGrid.mV);
             advect(halfDt);
             computeforces(halfDt);
             project(halfDt);
@@ -65,123 +179,287 @@ namespace FluidSimulation
             int numY = Eulerian2dPara::theDim2d[MACGrid2d::Y];
 
             // u½reflect = 2*u½ - u½tilde
-            for (int j = 0; j < numY; ++j)
-                for (int i = 1; i < numX; ++i)
-                    mGrid.mU(i, j) = 2.0f * mGrid.mU(i, j) - mGrid.mU_half(i, j);
+            // U 每行连续存放 numX + 1 个面，只处理内部面 i = 1..numX-1
+            mBackend->forEachRow(0, numY, [&](int j) {
+                mBackend->reflectSpan(&mGrid.mU(1, j), &mGrid.mU_half(1, j), numX - 1);
+            });
+
+            // V 每行连续存放 numX 个面，只处理内部行 j = 1..numY-1
+            mBackend->forEachRow(1, numY, [&](int j) {
+                mBackend->reflectSpan(&mGrid.mV(0, j), &mGrid.mV_half(0, j), numX);
+            });
 
-            for (int i = 0; i < numX; ++i)
-                for (int j = 1; j < numY; ++j)
-                    mGrid.mV(i, j) = 2.0f * mGrid.mV(i, j) - mGrid.mV_half(i, j);
+            mGrid.fillBoundaries();
         }
         void Solver::advect(float dt)
         {
             // 对流步骤更新P
-            // 使用半拉格朗日方法
-            Glb::GridData2dX newU = mGrid.mU;
-            Glb::GridData2dY newV = mGrid.mV;
-            Glb::CubicGridData2d newD = mGrid.mD;
-            Glb::CubicGridData2d newT = mGrid.mT;
+            // 从前台缓冲读取，写入后台缓冲，完成后交换
+            Fields front = { mGrid.mU, mGrid.mV, mGrid.mD, mGrid.mT };
+            Fields back = { mGrid.mUBack, mGrid.mVBack, mGrid.mDBack, mGrid.mTBack };
+            Fields aux = { mGrid.mUAux, mGrid.mVAux, mGrid.mDAux, mGrid.mTAux };
 
-            int numX = Eulerian2dPara::theDim2d[MACGrid2d::X];
-            int numY = Eulerian2dPara::theDim2d[MACGrid2d::Y];
+            int scheme = Eulerian2dPara::advectionScheme;
+            bool corrected = scheme == ADVECT_BFECC || scheme == ADVECT_MACCORMACK;
 
-            // 对于速度
-            
-            // 1. 更新 U (左-face, i=1..numX-1, j=0..numY-1)
-            for (int j = 0; j < numY; ++j)
-                for (int i = 1; i < numX; ++i)
+            // phi^ = A(phi)，需要再次正向平流时记下回溯位置
+            advectPass(dt, &front, back, NULL, corrected ? CACHE_STORE : CACHE_NONE);
+
+            if (corrected)
+            {
+                // 反向平流估计误差: phi_bar = A^R(phi^)
+                advectPass(-dt, &back, aux, NULL, CACHE_NONE);
+                if (scheme == ADVECT_BFECC)
                 {
-                    if (mGrid.isSolidFace(i, j, MACGrid2d::Direction::X))
-                    {
-                        newU(i, j) = 0.0f;          // 或者继续保留原值
-                        continue;
-                    }
-                    glm::vec2 pos = mGrid.getLeft(i, j);   // 采样位置
-                    glm::vec2 vel = mGrid.semiLagrangian(pos, dt);
-                    newU(i, j) = mGrid.getVelocityX(vel);
+                    // phi~ = phi + (phi - phi_bar) / 2，再正向平流一次
+                    addHalfDifference(aux, front, front, aux);
+                    advectPass(dt, &aux, back, &front, CACHE_LOAD);
                 }
+                else
+                {
+                    // phi^{n+1} = phi^ + (phi - phi_bar) / 2，只需再回溯一次用于限制
+                    addHalfDifference(back, back, front, aux);
+                    advectPass(dt, NULL, back, &front, CACHE_LOAD);
+                }
+            }
 
-            // 2. 更新 V (下-face, i=0..numX-1, j=1..numY-1)
-            for (int i = 0; i < numX; ++i)
-                for (int j = 1; j < numY; ++j)
+            // 边界条件
+
+            mGrid.swapVelocityBuffers();
+            mGrid.swapScalarBuffers();
+            mGrid.fillBoundaries();
+        }
+
+        /**
+         * 在回溯点上对 src 插值写入 dst 的 m 个采样；src 为空时保留 dst 原值
+         * range 不为空时把结果限制在 range 于回溯点处 2x2 单元的最小/最大值之间
+         */
+        template <typename Grid>
+        static void resample(Grid* src, Grid& dst, Grid* range, int j, int m, const int* idx, const float* x, const float* y)
+        {
+            Glb::Real value[MACGrid2d::SAMPLE_BATCH];
+            if (src)
+                src->interpolate(x, y, value, m);
+            else
+                for (int s = 0; s < m; s++)
+                    value[s] = dst(idx[s], j);
+
+            if (range)
+            {
+                for (int s = 0; s < m; s++)
                 {
-                    if (mGrid.isSolidFace(i, j, MACGrid2d::Direction::Y))
-                    {
-                        newV(i, j) = 0.0f;
-                        continue;
-                    }
-                    glm::vec2 pos = mGrid.getBottom(i, j);
-                    glm::vec2 vel = mGrid.semiLagrangian(pos, dt);
-                    newV(i, j) = mGrid.getVelocityY(vel);
+                    Glb::Real lo, hi;
+                    range->getRange(glm::vec2(x[s], y[s]), lo, hi);
+                    value[s] = value[s] < lo ? lo : (value[s] > hi ? hi : value[s]);
                 }
-            
+            }
 
-            // 对于属性
-            FOR_EACH_CELL
+            for (int s = 0; s < m; s++)
+                dst(idx[s], j) = value[s];
+        }
+
+        void Solver::advectPass(float dt, Fields* src, Fields& dst, Fields* range, TraceCacheMode cache)
+        {
+            // 使用半拉格朗日方法，回溯总是使用前台速度
+            // 每个采样只读 src、只写自己在 dst 中的位置，按行并行的结果与线程数无关
+            // 每行的采样点先回溯、再成批插值，SIMD 后端下由 AVX2 gather 完成
+            Glb::GridData2dX& newU = dst.u;
+            Glb::GridData2dY& newV = dst.v;
+            Glb::CubicGridData2d& newD = dst.d;
+            Glb::CubicGridData2d& newT = dst.t;
+
+            int numX = Eulerian2dPara::theDim2d[MACGrid2d::X];
+            int numY = Eulerian2dPara::theDim2d[MACGrid2d::Y];
+
+            // 回溯位置只依赖前台速度与 dt，每个采样点回溯一次，密度与温度共用单元中心的回溯位置
+            int stride = numX + 1;
+            bool load = cache == CACHE_LOAD;
+            if (cache != CACHE_NONE)
             {
-                // 判断是固体或者边界
-                if (mGrid.isSolidCell(i, j)) {
-                    continue;
+                for (int c = 0; c < 3; c++)
+                {
+                    mTraceX[c].resize(stride * (numY + 1));
+                    mTraceY[c].resize(stride * (numY + 1));
                 }
-                glm::vec2 pos_p = mGrid.getCenter(i, j);
-                glm::vec2 new_vel_p = mGrid.semiLagrangian(pos_p, dt);
-                // glm::vec2 new_vel_p = mGrid.RK2(pos_p, dt);
-                
-                newD(i, j) = mGrid.getDensity(new_vel_p);
-                newT(i, j) = mGrid.getTemperature(new_vel_p);
             }
+            auto rowX = [&](int c, int j) { return cache == CACHE_NONE ? NULL : mTraceX[c].data() + j * stride; };
+            auto rowY = [&](int c, int j) { return cache == CACHE_NONE ? NULL : mTraceY[c].data() + j * stride; };
+
+            // 对于速度
+            
+            // 1. 更新 U (左-face, i=1..numX-1, j=0..numY-1)，两侧的边界面保持不变
+            mBackend->forEachRow(0, numY, [&](int j) {
+                if (src) {
+                    newU(0, j) = src->u(0, j);
+                    newU(numX, j) = src->u(numX, j);
+                }
+                traceRow(mGrid, 1, numX, dt, rowX(0, j), rowY(0, j), load,
+                    [&](int i) {
+                        if (!mGrid.isSolidFace(i, j, MACGrid2d::Direction::X))
+                            return false;
+                        newU(i, j) = 0.0f;          // 或者继续保留原值
+                        return true;
+                    },
+                    [&](int i) { return mGrid.getLeft(i, j); },   // 采样位置
+                    [&](int m, const int* idx, const float* x, const float* y) {
+                        resample(src ? &src->u : NULL, newU, range ? &range->u : NULL, j, m, idx, x, y);
+                    });
+            });
+
+            // 2. 更新 V (下-face, i=0..numX-1, j=1..numY-1)，上下的边界面保持不变
+            if (src) {
+                for (int i = 0; i < numX; ++i)
+                {
+                    newV(i, 0) = src->v(i, 0);
+                    newV(i, numY) = src->v(i, numY);
+                }
+            }
+            // V 按行存放，改为行外层循环以便按行并行
+            mBackend->forEachRow(1, numY, [&](int j) {
+                traceRow(mGrid, 0, numX, dt, rowX(1, j), rowY(1, j), load,
+                    [&](int i) {
+                        if (!mGrid.isSolidFace(i, j, MACGrid2d::Direction::Y))
+                            return false;
+                        newV(i, j) = 0.0f;
+                        return true;
+                    },
+                    [&](int i) { return mGrid.getBottom(i, j); },
+                    [&](int m, const int* idx, const float* x, const float* y) {
+                        resample(src ? &src->v : NULL, newV, range ? &range->v : NULL, j, m, idx, x, y);
+                    });
+            });
 
-            // 边界条件
 
-            mGrid.mU = newU;
-            mGrid.mV = newV;
-            mGrid.mD = newD;
-            mGrid.mT = newT;
+            // 对于属性
+            mBackend->forEachRow(0, numY, [&](int j) {
+                traceRow(mGrid, 0, numX, dt, rowX(2, j), rowY(2, j), load,
+                    [&](int i) {
+                        // 判断是固体或者边界，保持原值
+                        if (!mGrid.isSolidCell(i, j))
+                            return false;
+                        if (src) {
+                            newD(i, j) = src->d(i, j);
+                            newT(i, j) = src->t(i, j);
+                        }
+                        return true;
+                    },
+                    [&](int i) { return mGrid.getCenter(i, j); },
+                    [&](int m, const int* idx, const float* x, const float* y) {
+                        resample(src ? &src->d : NULL, newD, range ? &range->d : NULL, j, m, idx, x, y);
+                        resample(src ? &src->t : NULL, newT, range ? &range->t : NULL, j, m, idx, x, y);
+                    });
+            });
+
+            // dst 可能在下一遍中被插值，需要有效的幽灵单元
+            newU.fillBoundary();
+            newV.fillBoundary();
+        }
+
+        template <typename Grid>
+        void Solver::addHalfDifference(Grid& out, Grid& a, Grid& b, Grid& c)
+        {
+            // 逐元素计算（包括幽灵单元），每次处理一行
+            std::vector<Glb::Real>& o = out.data();
+            const std::vector<Glb::Real>& va = a.data();
+            const std::vector<Glb::Real>& vb = b.data();
+            const std::vector<Glb::Real>& vc = c.data();
+            int stride = out.mStride;
+            mBackend->forEachRow(0, (int)o.size() / stride, [&](int r) {
+                for (int k = r * stride; k < (r + 1) * stride; k++)
+                    o[k] = va[k] + Glb::Real(0.5) * (vb[k] - vc[k]);
+            });
+        }
+
+        void Solver::addHalfDifference(Fields& out, Fields& a, Fields& b, Fields& c)
+        {
+            addHalfDifference(out.u, a.u, b.u, c.u);
+            addHalfDifference(out.v, a.v, b.v, c.v);
+            addHalfDifference(out.d, a.d, b.d, c.d);
+            addHalfDifference(out.t, a.t, b.t, c.t);
         }
 
         void Solver::computeforces(float dt)
         {
             int numX = mGrid.dim[0];
             int numY = mGrid.dim[1];
-            // 浮力
-            Glb::GridData2dY newV = mGrid.mV;
-            FOR_EACH_CELL
-            {
-                if (mGrid.isSolidCell(i, j) || mGrid.isSolidCell(i, j - 1) || mGrid.isSolidCell(i, j + 1)) {
-                    continue;
-                }
-                
-                glm::vec2 pos1 = mGrid.getCenter(i, j);
-                glm::vec2 pos0 = mGrid.getCenter(i, j - 1);
-                // 向上的作用力
-                float bforce1 = mGrid.getBoussinesqForce(pos1);
-                float bforce0 = mGrid.getBoussinesqForce(pos0);
+            // 浮力只读取密度与温度，可直接修改 V
+            Glb::GridData2dY& newV = mGrid.mV;
+            // 每行只写入 newV 的第 j 行，可按行并行
+            mBackend->forEachRow(0, numY, [&](int j) {
+                for (int i = 0; i < numX; i++) {
+                    if (mGrid.isSolidCell(i, j) || mGrid.isSolidCell(i, j - 1) || mGrid.isSolidCell(i, j + 1)) {
+                        continue;
+                    }
 
-                float v = (bforce1 + bforce0) * 0.5 * dt;
-                // 更新 v 分量
-                newV(i, j) += v;
-            }
+                    glm::vec2 pos1 = mGrid.getCenter(i, j);
+                    glm::vec2 pos0 = mGrid.getCenter(i, j - 1);
+                    // 向上的作用力
+                    float bforce1 = mGrid.getBoussinesqForce(pos1);
+                    float bforce0 = mGrid.getBoussinesqForce(pos0);
 
-            mGrid.mV = newV;
+                    float v = (bforce1 + bforce0) * 0.5 * dt;
+                    // 更新 v 分量
+                    newV(i, j) += v;
+                }
+            });
 
+            mGrid.fillBoundaries();
         }
 
-        void Solver::project(float dt)
+        double Solver::pressureResidual(float dt, double* rhsNorm)
         {
             int numX = mGrid.dim[0];
             int numY = mGrid.dim[1];
-            Glb::CubicGridData2d newP = mGrid.mP;
-            newP.initialize(0.0);
-            Glb::GridData2dY newV = mGrid.mV;
-            Glb::GridData2dX newU = mGrid.mU;
+            Glb::CubicGridData2d& p = mGrid.mP;
+            Glb::Real scale = -Eulerian2dPara::airDensity * mGrid.cellSize * mGrid.cellSize / dt;
+
+            mRowResidual.assign(numY, 0.0);
+            mRowRhs.assign(numY, 0.0);
+            mBackend->forEachRow(0, numY, [&](int j) {
+                double m = 0.0, mb = 0.0;
+                for (int i = 0; i < numX; i++) {
+                    unsigned char mask = mGrid.getStencilMask(i, j);
+                    if (!(mask & MACGrid2d::STENCIL_FLUID))
+                        continue;
+                    Glb::Real sum = ((mask & MACGrid2d::STENCIL_RIGHT) ? p(i + 1, j) : 0.0) + ((mask & MACGrid2d::STENCIL_LEFT) ? p(i - 1, j) : 0.0)
+                        + ((mask & MACGrid2d::STENCIL_TOP) ? p(i, j + 1) : 0.0) + ((mask & MACGrid2d::STENCIL_BOTTOM) ? p(i, j - 1) : 0.0);
+                    Glb::Real b = scale * mGrid.getDivergence(i, j);
+                    double r = fabs((double)(b + sum - mGrid.getStencilDiag(i, j) * p(i, j)));
+                    m = r > m ? r : m;
+                    mb = fabs((double)b) > mb ? fabs((double)b) : mb;
+                }
+                mRowResidual[j] = m;
+                mRowRhs[j] = mb;
+            });
+
+            double m = 0.0, mb = 0.0;
+            for (int j = 0; j < numY; j++) {
+                m = mRowResidual[j] > m ? mRowResidual[j] : m;
+                mb = mRowRhs[j] > mb ? mRowRhs[j] : mb;
+            }
+            if (rhsNorm)
+                *rhsNorm = mb;
+            return m;
+        }
+
+        void Solver::solvePressureGaussSeidel(float dt, Glb::PressureMonitor& monitor)
+        {
+            // 压力从 0 或热启动的初值开始迭代；速度只在迭代结束后修改，散度读到的仍是投影前的值，可原地更新
+            Glb::CubicGridData2d& newP = mGrid.mP;
+            if (!mWarmStart)
+                newP.initialize(0.0);
+            double rhsNorm = 0.0;
+            double initial = pressureResidual(dt, &rhsNorm);
+            monitor.begin(initial, rhsNorm);
 
             float aird = Eulerian2dPara::airDensity;
 
             float cellSize = mGrid.cellSize;
 
-            for (int iteration = 100; iteration > 0; iteration--) {
+            for (int iteration = 100; iteration > 0 && !monitor.converged(); iteration--) {
                 FOR_EACH_CELL{
-                    if (mGrid.isSolidCell(i, j)) {
+                    unsigned char mask = mGrid.getStencilMask(i, j);
+                    if (!(mask & MACGrid2d::STENCIL_FLUID)) {
                         continue;
                     }
                     /*
@@ -192,46 +470,443 @@ namespace FluidSimulation
                         newP(i, j - 1) = newP(i, j) - cellSize * aird * newV(i, j + 1) / dt;
                     }
                     */ 
-                    double px1 = mGrid.isSolidCell(i + 1, j) ? 0.0 : newP(i + 1, j);
-                    double px0 = mGrid.isSolidCell(i - 1, j) ? 0.0 : newP(i - 1, j);
+                    Glb::Real px1 = (mask & MACGrid2d::STENCIL_RIGHT) ? newP(i + 1, j) : 0.0;
+                    Glb::Real px0 = (mask & MACGrid2d::STENCIL_LEFT) ? newP(i - 1, j) : 0.0;
 
-                    double py1 = mGrid.isSolidCell(i, j + 1) ? 0.0 : newP(i, j + 1);
-                    double py0 = mGrid.isSolidCell(i, j - 1) ? 0.0 : newP(i, j - 1);
+                    Glb::Real py1 = (mask & MACGrid2d::STENCIL_TOP) ? newP(i, j + 1) : 0.0;
+                    Glb::Real py0 = (mask & MACGrid2d::STENCIL_BOTTOM) ? newP(i, j - 1) : 0.0;
                     
 
-                    double div = mGrid.getDivergence(i, j);
+                    Glb::Real div = mGrid.getDivergence(i, j);
 
                     // b
                     // double b = -1 * (newU(i + 1, j) - newU(i, j) + newV(i, j + 1) - newV(i, j)) * (aird) * cellSize / (dt);
-                    double b = -1 * (div) * (aird) * cellSize * cellSize / (dt);
+                    Glb::Real b = -1 * (div) * (aird) * cellSize * cellSize / (dt);
                     // sum
-                    double sum = (px1 + px0 + py1 + py0);
-                    double s = mGrid.getPressureCoeffBetweenCells(i, j, i, j);
+                    Glb::Real sum = (px1 + px0 + py1 + py0);
+                    Glb::Real s = mGrid.getStencilDiag(i, j);
                     newP(i, j) = (b + sum) / s;
                 };
+                if (monitor.step())
+                    monitor.update(pressureResidual(dt));
             }
-           
-            FOR_EACH_CELL{
-                newU(i + 1,j) -= dt * (newP(i + 1,j) - newP(i,j)) / (cellSize * aird);
-                newV(i, j + 1) -= dt * (newP(i, j + 1) - newP(i, j)) / (cellSize * aird);
+            if (!monitor.upToDate())
+                monitor.update(pressureResidual(dt));
+        }
+
+        void Solver::solvePressureRedBlackSOR(float dt, Glb::PressureMonitor& monitor)
+        {
+            int numX = mGrid.dim[0];
+            int numY = mGrid.dim[1];
+            Glb::CubicGridData2d& newP = mGrid.mP;
+            Glb::Real scale = -Eulerian2dPara::airDensity * mGrid.cellSize * mGrid.cellSize / dt;
+            Glb::Real omega = Eulerian2dPara::sorOmega;
+
+            int stride = (numX + 1) / 2 + 2;
+            size_t size = (size_t)stride * (numY + 2);
+            for (int c = 0; c < 2; c++)
+                mSorP[c].assign(size, 0.0);
+
+            // 对角元只与固体分布有关，固体不变时复用上次的 invDiag，固体单元上的 b 一直为 0
+            if (mSorVersion != mGrid.getSolidVersion() || mSorInvDiag[0].size() != size) {
+                for (int c = 0; c < 2; c++) {
+                    mSorB[c].assign(size, 0.0);
+                    mSorInvDiag[c].assign(size, 0.0);
+                }
+                mBackend->forEachRow(0, numY, [&](int j) {
+                    for (int i = 0; i < numX; i++) {
+                        Glb::Real s = mGrid.getStencilDiag(i, j);
+                        mSorInvDiag[(i + j) & 1][(j + 1) * stride + 1 + (i >> 1)] = s > 0 ? 1 / s : 0;
+                    }
+                });
+                mSorVersion = mGrid.getSolidVersion();
             }
 
-            // 边界处理
-            FOR_EACH_LINE
-            {
-                // 对U
-                if (mGrid.isSolidFace(i, j, MACGrid2d::Direction::X)) {
-                    newU(i, j) = 0;
+            // 方程与 Gauss-Seidel 相同: s * p - sum(非固体邻居 p) = -div * rho * h^2 / dt
+            mRowRhs.assign(numY, 0.0);
+            mBackend->forEachRow(0, numY, [&](int j) {
+                double mb = 0.0;
+                for (int i = 0; i < numX; i++) {
+                    if (!(mGrid.getStencilMask(i, j) & MACGrid2d::STENCIL_FLUID))
+                        continue;
+                    int c = (i + j) & 1;
+                    size_t idx = (j + 1) * stride + 1 + (i >> 1);
+                    mSorB[c][idx] = scale * mGrid.getDivergence(i, j);
+                    if (mWarmStart)
+                        mSorP[c][idx] = newP(i, j);
+                    mb = fabs((double)mSorB[c][idx]) > mb ? fabs((double)mSorB[c][idx]) : mb;
+                }
+                mRowRhs[j] = mb;
+            });
+            double rhsNorm = 0.0;
+            for (int j = 0; j < numY; j++)
+                rhsNorm = mRowRhs[j] > rhsNorm ? mRowRhs[j] : rhsNorm;
+
+            // 残差 b + sum(邻居 p) - s * p，与 Gauss-Seidel 的 pressureResidual 相同
+            auto residual = [&]() {
+                mRowResidual.assign(numY, 0.0);
+                mBackend->forEachRow(0, numY, [&](int j) {
+                    double m = 0.0;
+                    for (int c = 0; c < 2; c++) {
+                        int o = (j + c) & 1;
+                        int base = (j + 1) * stride + 1;
+                        const Glb::Real* p = mSorP[c].data() + base;
+                        const Glb::Real* b = mSorB[c].data() + base;
+                        const Glb::Real* invDiag = mSorInvDiag[c].data() + base;
+                        const Glb::Real* west = mSorP[1 - c].data() + base - 1 + o;
+                        const Glb::Real* down = mSorP[1 - c].data() + base - stride;
+                        const Glb::Real* up = mSorP[1 - c].data() + base + stride;
+                        for (int s = 0; s < (numX - o + 1) / 2; s++) {
+                            if (invDiag[s] == 0)
+                                continue;
+                            double r = fabs((double)(b[s] + west[s] + west[s + 1] + down[s] + up[s] - p[s] / invDiag[s]));
+                            m = r > m ? r : m;
+                        }
+                    }
+                    mRowResidual[j] = m;
+                });
+                double m = 0.0;
+                for (int j = 0; j < numY; j++)
+                    m = mRowResidual[j] > m ? mRowResidual[j] : m;
+                return m;
+            };
+            monitor.begin(residual(), rhsNorm);
+
+            // 先更新颜色 0 (i + j 为偶数)，再更新颜色 1；同一种颜色的单元只读取另一种颜色
+            for (int iteration = 100; iteration > 0 && !monitor.converged(); iteration--) {
+                for (int c = 0; c < 2; c++) {
+                    Glb::Real* p = mSorP[c].data();
+                    const Glb::Real* other = mSorP[1 - c].data();
+                    const Glb::Real* b = mSorB[c].data();
+                    const Glb::Real* invDiag = mSorInvDiag[c].data();
+                    mBackend->forEachRow(0, numY, [&](int j) {
+                        int o = (j + c) & 1;
+                        int base = (j + 1) * stride + 1;
+                        mBackend->relaxSpan(p + base, b + base, invDiag + base,
+                            other + base - 1 + o, other + base - stride, other + base + stride, (numX - o + 1) / 2, omega);
+                    });
+                }
+                if (monitor.step())
+                    monitor.update(residual());
+            }
+            if (!monitor.upToDate())
+                monitor.update(residual());
+
+            mBackend->forEachRow(0, numY, [&](int j) {
+                for (int i = 0; i < numX; i++)
+                    newP(i, j) = mSorP[(i + j) & 1][(j + 1) * stride + 1 + (i >> 1)];
+            });
+        }
+
+        double Solver::buildPressureRhs(float dt)
+        {
+            int numX = mGrid.dim[0];
+            int numY = mGrid.dim[1];
+            double scale = -Eulerian2dPara::airDensity * mGrid.cellSize * mGrid.cellSize / dt;
+
+            // 右端项与 Gauss-Seidel 相同: b = -div * rho * h^2 / dt
+            mRhs.assign(numX * numY, 0.0);
+            mBackend->forEachRow(0, numY, [&](int j) {
+                for (int i = 0; i < numX; i++) {
+                    if (mGrid.getStencilMask(i, j) & MACGrid2d::STENCIL_FLUID)
+                        mRhs[i + j * numX] = scale * mGrid.getDivergence(i, j);
+                }
+            });
+
+            double m = 0.0;
+            for (size_t c = 0; c < mRhs.size(); c++)
+                m = fabs(mRhs[c]) > m ? fabs(mRhs[c]) : m;
+            return m;
+        }
+
+        double Solver::beginPressureSolve(float dt, Glb::PressureMonitor& monitor)
+        {
+            double rhsNorm = buildPressureRhs(dt);
+            if (!mWarmStart) {
+                monitor.begin(rhsNorm);
+                return rhsNorm;
+            }
+
+            // 初值取自 mP
+            int numX = mGrid.dim[0];
+            int numY = mGrid.dim[1];
+            mPressure.resize(numX * numY);
+            mBackend->forEachRow(0, numY, [&](int j) {
+                for (int i = 0; i < numX; i++)
+                    mPressure[i + j * numX] = mGrid.mP(i, j);
+            });
+            monitor.begin(pressureResidual(dt), rhsNorm);
+            return rhsNorm;
+        }
+
+        void Solver::solvePressurePCG(float dt, Glb::PressureMonitor& monitor)
+        {
+            beginPressureSolve(dt, monitor);
+            double residual = 0.0;
+            int iterations = mPCG.solve(mGrid, mRhs, mPressure, Eulerian2dPara::pressureTolerance, Eulerian2dPara::pressureMaxIterations, mWarmStart, residual);
+            monitor.finish(iterations, residual);
+            storePressure();
+        }
+
+        void Solver::setupMultigrid()
+        {
+            int numX = mGrid.dim[0];
+            int numY = mGrid.dim[1];
+            int n = numX * numY;
+
+            // 容器边界外视为固体，与压力模板一致
+            mMultigrid.setParallel(Eulerian2dPara::backend != BACKEND_SCALAR);
+            if (mCellTypeVersion != mGrid.getSolidVersion() || (int)mCellType.size() != n) {
+                mCellType.resize(n);
+                mCellTypeHasSolid = false;
+                for (int j = 0; j < numY; j++)
+                    for (int i = 0; i < numX; i++) {
+                        bool solid = !(mGrid.getStencilMask(i, j) & MACGrid2d::STENCIL_FLUID);
+                        mCellTypeHasSolid = mCellTypeHasSolid || solid;
+                        mCellType[i + j * numX] = solid ? Glb::PoissonMultigrid::SOLID : Glb::PoissonMultigrid::FLUID;
+                    }
+                mMultigrid.setup(numX, numY, 1, mCellType);
+                mCellTypeVersion = mGrid.getSolidVersion();
+            }
+        }
+
+        void Solver::solvePressureMultigrid(float dt, bool useCG, Glb::PressureMonitor& monitor)
+        {
+            int numX = mGrid.dim[0];
+            int numY = mGrid.dim[1];
+            int n = numX * numY;
+
+            setupMultigrid();
+            // 粗化会抹去一个单元厚的固体墙，粗网格算子与细网格不再一致，独立的多重网格几乎不收敛
+            if (!useCG && mCellTypeHasSolid) {
+                if (!mMultigridFallbackLogged)
+                    Glb::Logger::getInstance().addLog("multigrid pressure solver stalls on thin solid walls, fall back to mgpcg.");
+                mMultigridFallbackLogged = true;
+                useCG = true;
+            }
+
+            beginPressureSolve(dt, monitor);
+            mRhsFloat.resize(n);
+            mPressureFloat.resize(n);
+            for (int c = 0; c < n; c++) {
+                mRhsFloat[c] = (float)mRhs[c];
+                mPressureFloat[c] = mWarmStart ? (float)mPressure[c] : 0.0f;
+            }
+
+            double residual = 0.0;
+            int iterations = useCG
+                ? mMultigrid.solvePCG(mRhsFloat.data(), mPressureFloat.data(), Eulerian2dPara::pressureTolerance, Eulerian2dPara::pressureMaxIterations, true, mWarmStart, residual)
+                : mMultigrid.solve(mRhsFloat.data(), mPressureFloat.data(), Eulerian2dPara::pressureTolerance, Eulerian2dPara::pressureMaxIterations, mWarmStart, residual);
+
+            mPressure.resize(n);
+            for (int c = 0; c < n; c++)
+                mPressure[c] = mPressureFloat[c];
+            monitor.finish(iterations, residual);
+            storePressure();
+        }
+
+        double Solver::correctionResidual()
+        {
+            int numX = mGrid.dim[0];
+            int numY = mGrid.dim[1];
+            const double* p = mPressure.data();
+
+            mCorrection.resize(numX * numY);
+            mRowResidual.assign(numY, 0.0);
+            mBackend->forEachRow(0, numY, [&](int j) {
+                double m = 0.0;
+                for (int i = 0; i < numX; i++) {
+                    int c = i + j * numX;
+                    unsigned char mask = mGrid.getStencilMask(i, j);
+                    if (!(mask & MACGrid2d::STENCIL_FLUID)) {
+                        mCorrection[c] = 0.0;
+                        continue;
+                    }
+                    double sum = ((mask & MACGrid2d::STENCIL_RIGHT) ? p[c + 1] : 0.0) + ((mask & MACGrid2d::STENCIL_LEFT) ? p[c - 1] : 0.0)
+                        + ((mask & MACGrid2d::STENCIL_TOP) ? p[c + numX] : 0.0) + ((mask & MACGrid2d::STENCIL_BOTTOM) ? p[c - numX] : 0.0);
+                    mCorrection[c] = mRhs[c] + sum - (double)mGrid.getStencilDiag(i, j) * p[c];
+                    m = fabs(mCorrection[c]) > m ? fabs(mCorrection[c]) : m;
                 }
-                // 对V
-                if (mGrid.isSolidFace(i, j, MACGrid2d::Direction::Y)) {
-                    newV(i, j) = 0;
+                mRowResidual[j] = m;
+            });
+
+            double m = 0.0;
+            for (int j = 0; j < numY; j++)
+                m = mRowResidual[j] > m ? mRowResidual[j] : m;
+            return m;
+        }
+
+        // 单精度内层每轮只把残差缩小到这一比例，更小时会受到单精度舍入误差的限制
+        static const double MIXED_INNER_TOLERANCE = 1e-3;
+
+        void Solver::solvePressureMixed(float dt, Glb::PressureMonitor& monitor)
+        {
+            int numX = mGrid.dim[0];
+            int numY = mGrid.dim[1];
+            int n = numX * numY;
+
+            setupMultigrid();
+            double tolerance = Eulerian2dPara::pressureTolerance * beginPressureSolve(dt, monitor);
+            if (!mWarmStart)
+                mPressure.assign(n, 0.0);
+            mRhsFloat.resize(n);
+            mPressureFloat.resize(n);
+
+            int iterations = 0, refinements = 0, rejected = 0;
+            double residual = correctionResidual();
+            while (residual > tolerance && iterations < Eulerian2dPara::pressureMaxIterations) {
+                double innerTolerance = tolerance / residual;
+                innerTolerance = innerTolerance > MIXED_INNER_TOLERANCE ? innerTolerance : MIXED_INNER_TOLERANCE;
+                for (int c = 0; c < n; c++)
+                    mRhsFloat[c] = (float)mCorrection[c];
+
+                double innerResidual = 0.0;
+                iterations += mMultigrid.solvePCG(mRhsFloat.data(), mPressureFloat.data(), innerTolerance, Eulerian2dPara::pressureMaxIterations - iterations, true, false, innerResidual);
+                for (int c = 0; c < n; c++)
+                    mPressure[c] += mPressureFloat[c];
+
+                // 残差不再明显下降时停止，例如全 Neumann 时右端项中不相容的部分无法消去
+                // 残差反而变大时撤销这次修正，结果不比上一轮差
+                double previous = residual;
+                residual = correctionResidual();
+                if (residual > previous) {
+                    for (int c = 0; c < n; c++)
+                        mPressure[c] -= mPressureFloat[c];
+                    residual = previous;
+                    rejected++;
+                    break;
                 }
+                refinements++;
+                if (residual > 0.5 * previous)
+                    break;
             }
+
+            monitor.finish(iterations, residual);
+            Glb::Timer::getInstance().recordValue("pressure refinements", std::to_string(refinements));
+            Glb::Timer::getInstance().recordValue("pressure rejected refinements", std::to_string(rejected));
+            storePressure();
+        }
+
+        void Solver::solvePressureFFT(float dt, Glb::PressureMonitor& monitor)
+        {
+            int numX = mGrid.dim[0];
+            int numY = mGrid.dim[1];
+
+            // 只在固体分布改变时重新检查是否所有单元都是流体
+            if (mFastPoissonVersion != mGrid.getSolidVersion()) {
+                mFastPoissonUsable = true;
+                for (int j = 0; j < numY && mFastPoissonUsable; j++)
+                    for (int i = 0; i < numX; i++)
+                        if (!(mGrid.getStencilMask(i, j) & MACGrid2d::STENCIL_FLUID)) {
+                            mFastPoissonUsable = false;
+                            break;
+                        }
+                mFastPoissonVersion = mGrid.getSolidVersion();
+                if (!mFastPoissonUsable)
+                    Glb::Logger::getInstance().addLog("fft pressure solver requires a domain without solids, fall back to mgpcg.");
+            }
+            if (!mFastPoissonUsable) {
+                solvePressureMultigrid(dt, true, monitor);
+                return;
+            }
+
+            beginPressureSolve(dt, monitor);
+            mPressure.resize(numX * numY);
+            mFastPoisson.setParallel(Eulerian2dPara::backend != BACKEND_SCALAR);
+            mFastPoisson.setup(numX, numY, 1, Glb::FastPoisson::NEUMANN);
+            mFastPoisson.solve(mRhs.data(), mPressure.data());
+            storePressure();
+            monitor.finish(0, pressureResidual(dt));
+        }
+
+        void Solver::storePressure()
+        {
+            int numX = mGrid.dim[0];
+            int numY = mGrid.dim[1];
+            Glb::CubicGridData2d& newP = mGrid.mP;
+
+            newP.initialize(0.0);
+            mBackend->forEachRow(0, numY, [&](int j) {
+                for (int i = 0; i < numX; i++)
+                    newP(i, j) = (Glb::Real)mPressure[i + j * numX];
+            });
+        }
+
+        void Solver::project(float dt)
+        {
+            int numX = mGrid.dim[0];
+            int numY = mGrid.dim[1];
+            Glb::CubicGridData2d& newP = mGrid.mP;
+            Glb::GridData2dY& newV = mGrid.mV;
+            Glb::GridData2dX& newU = mGrid.mU;
+
+            float aird = Eulerian2dPara::airDensity;
+
+            float cellSize = mGrid.cellSize;
+
+            // 热启动：压力与 1/dt 成正比，上一次的压力按时间步长之比缩放后作为初值
+            mWarmStart = Eulerian2dPara::warmStartPressure && mPressureDt > 0.0f;
+            if (mWarmStart) {
+                Glb::Real guessScale = mPressureDt / dt;
+                mBackend->forEachRow(0, numY, [&](int j) {
+                    for (int i = 0; i < numX; i++)
+                        newP(i, j) *= guessScale;
+                });
+            }
+
+            Glb::PressureMonitor monitor(Eulerian2dPara::pressureTolerance, Eulerian2dPara::pressureCheckInterval);
+            switch (Eulerian2dPara::pressureSolver) {
+            case PRESSURE_PCG:
+                solvePressurePCG(dt, monitor);
+                break;
+            case PRESSURE_MULTIGRID:
+                solvePressureMultigrid(dt, false, monitor);
+                break;
+            case PRESSURE_MGPCG:
+                solvePressureMultigrid(dt, true, monitor);
+                break;
+            case PRESSURE_RED_BLACK_SOR:
+                solvePressureRedBlackSOR(dt, monitor);
+                break;
+            case PRESSURE_FFT:
+                solvePressureFFT(dt, monitor);
+                break;
+            case PRESSURE_MIXED_PRECISION:
+                solvePressureMixed(dt, monitor);
+                break;
+            default:
+                // Jacobi 只用于 3D，2D 使用 Gauss-Seidel
+                solvePressureGaussSeidel(dt, monitor);
+                break;
+            }
+            monitor.report();
+            mPressureIterations += monitor.iterations();
+            mPressureTime += monitor.elapsed();
+            mPressureDt = dt;
+           
+            // 第 j 行只写入 newU 的第 j 行与 newV 的第 j + 1 行
+            mBackend->forEachRow(0, numY, [&](int j) {
+                for (int i = 0; i < numX; i++) {
+                    newU(i + 1, j) -= dt * (newP(i + 1, j) - newP(i, j)) / (cellSize * aird);
+                    newV(i, j + 1) -= dt * (newP(i, j + 1) - newP(i, j)) / (cellSize * aird);
+                }
+            });
+
+            // 边界处理，只写入内部面，幽灵单元由 fillBoundaries 统一填充
+            mBackend->forEachRow(0, numY + 1, [&](int j) {
+                for (int i = 0; i < numX + 1; i++) {
+                    // 对U
+                    if (j < numY && mGrid.isSolidFace(i, j, MACGrid2d::Direction::X)) {
+                        newU(i, j) = 0;
+                    }
+                    // 对V
+                    if (i < numX && mGrid.isSolidFace(i, j, MACGrid2d::Direction::Y)) {
+                        newV(i, j) = 0;
+                    }
+                }
+            });
             
-            mGrid.mU = newU;
-            mGrid.mV = newV;
-            mGrid.mP = newP;
+            mGrid.fillBoundaries();
 
 
         }
@@ -56,70 +56,73 @@ __device__ float3 sample_velocity_trilinear(float3* vel, float3 pos, int3 dim)
 //  Kernels
 // =========================================================
 
-// ƽ (Semi-Lagrangian)
-__global__ void advect_density_kernel(
-    cudaSurfaceObject_t outputSurf, cudaTextureObject_t inputTex,
-    float3* velocity, float dt, int width, int height, int depth)
-{
-    int x = blockIdx.x * blockDim.x + threadIdx.x;
-    int y = blockIdx.y * blockDim.y + threadIdx.y;
-    int z = blockIdx.z * blockDim.z + threadIdx.z;
-    if (x >= width || y >= height || z >= depth) return;
-
-    // ת
-    int idx = x + y * width + z * width * height;
-    float3 pos = make_float3(x + 0.5f, y + 0.5f, z + 0.5f);
+// ݻַ Configure.h е TraceIntegrator һ
+#define TRACE_EULER 0
+#define TRACE_RK2   1
+#define TRACE_RK3   2
 
-    // 
-    float3 vel = velocity[idx];
-    float3 prevPos = pos - vel * dt;
-
-    // д
-    float result = tex3D<float>(inputTex, prevPos.x, prevPos.y, prevPos.z);
-    result = fmaxf(0.0f, result);
-    surf3Dwrite(result, outputSurf, x * sizeof(float), y, z);
+//  pos  dt λãk1 Ϊ pos ٶ
+__device__ float3 trace_back(float3* vel, float3 pos, float3 k1, float dt, int3 dim, int integrator)
+{
+    if (integrator == TRACE_RK2) {
+        // е㷨
+        float3 k2 = sample_velocity_trilinear(vel, pos - k1 * (0.5f * dt), dim);
+        return pos - k2 * dt;
+    }
+    if (integrator == TRACE_RK3) {
+        // Ralston RK3
+        float3 k2 = sample_velocity_trilinear(vel, pos - k1 * (0.5f * dt), dim);
+        float3 k3 = sample_velocity_trilinear(vel, pos - k2 * (0.75f * dt), dim);
+        return pos - ((2.0f / 9.0f) * k1 + (3.0f / 9.0f) * k2 + (4.0f / 9.0f) * k3) * dt;
+    }
+    return pos - k1 * dt;
 }
 
-// BFECC ƽ (Back and Forth Error Compensation and Correction)
-// ֵܹɢϸ
-__global__ void advect_density_BFECC_kernel(
-    cudaSurfaceObject_t outputSurf, cudaTextureObject_t inputTex,
-    float3* velocity, float dt, int width, int height, int depth)
+// ƽ (Semi-Lagrangian)ѡ BFECC (Back and Forth Error Compensation and Correction)
+// BFECC ֵܹɢϸ
+// ܶ¶ȹÿԪĻλ
+__global__ void advect_scalars_kernel(
+    cudaSurfaceObject_t outputSurfA, cudaTextureObject_t inputTexA,
+    cudaSurfaceObject_t outputSurfB, cudaTextureObject_t inputTexB,
+    float3* velocity, float dt, int width, int height, int depth,
+    bool useBFECC, int integrator)
 {
     int x = blockIdx.x * blockDim.x + threadIdx.x;
     int y = blockIdx.y * blockDim.y + threadIdx.y;
     int z = blockIdx.z * blockDim.z + threadIdx.z;
     if (x >= width || y >= height || z >= depth) return;
 
+    // ת
     int3 dim = make_int3(width, height, depth);
-    float3 pos = make_float3(x + 0.5f, y + 0.5f, z + 0.5f);
     int idx = x + y * width + z * width * height;
+    float3 pos = make_float3(x + 0.5f, y + 0.5f, z + 0.5f);
 
-    // --- BFECC  ---
     // 1. Backward: ҵǰһʱλ (Standard Semi-Lagrangian)
-    float3 vel1 = velocity[idx]; 
-    float3 pos_back = pos - vel1 * dt;
-
-    // 2. Forward: ǰһλ׷ٻصǰʱ
-    //     pos_back Ǹ꣬ҪԲֵٶ
-    float3 vel2 = sample_velocity_trilinear(velocity, pos_back, dim);
-    float3 pos_forward = pos_back + vel2 * dt;
+    float3 pos_back = trace_back(velocity, pos, velocity[idx], dt, dim, integrator);
 
-    // 3. Correction: 
-    //    pos_forward Ӧõ posƫΪ error
-    //    Ϊ˵ڲʱ෴ƫ
-    float3 error = pos_forward - pos;
-    float3 pos_final = pos_back - error * 0.5f;
+    if (useBFECC) {
+        // 2. Forward: ǰһλ׷ٻصǰʱ
+        //     pos_back Ǹ꣬ҪԲֵٶ
+        float3 vel2 = sample_velocity_trilinear(velocity, pos_back, dim);
+        float3 pos_forward = trace_back(velocity, pos_back, vel2, -dt, dim, integrator);
+
+        // 3. Correction: 
+        //    pos_forward Ӧõ posƫΪ error
+        //    Ϊ˵ڲʱ෴ƫ
+        float3 error = pos_forward - pos;
+        pos_back = pos_back - error * 0.5f;
+    }
 
     // 4. Sample & Write
-    float result = tex3D<float>(inputTex, pos_final.x, pos_final.y, pos_final.z);
-    result = fmaxf(0.0f, result);
-    surf3Dwrite(result, outputSurf, x * sizeof(float), y, z);
+    float resultA = fmaxf(0.0f, tex3D<float>(inputTexA, pos_back.x, pos_back.y, pos_back.z));
+    float resultB = fmaxf(0.0f, tex3D<float>(inputTexB, pos_back.x, pos_back.y, pos_back.z));
+    surf3Dwrite(resultA, outputSurfA, x * sizeof(float), y, z);
+    surf3Dwrite(resultB, outputSurfB, x * sizeof(float), y, z);
 }
 
 __global__ void advect_velocity_kernel(
     float3* new_vel, float3* old_vel, 
-    float dt, int width, int height, int depth)
+    float dt, int width, int height, int depth, int integrator)
 {
     int x = blockIdx.x * blockDim.x + threadIdx.x;
     int y = blockIdx.y * blockDim.y + threadIdx.y;
@@ -134,7 +137,7 @@ __global__ void advect_velocity_kernel(
     float3 u = old_vel[idx];
 
     // ·
-    float3 prevPos = pos - u * dt;
+    float3 prevPos = trace_back(old_vel, pos, u, dt, dim, integrator);
 
     // ھλòֵٶȣдλ
     new_vel[idx] = sample_velocity_trilinear(old_vel, prevPos, dim);
@@ -223,6 +226,25 @@ __global__ void jacobi_pressure_kernel(
     p_next[idx] = (pl + pr + pd + pu + pb + pf - div) / 6.0f;
 }
 
+// Chebyshev ٵ Jacobi: p_next һεѹд p_prev + omega * (J(p_curr) - p_prev)
+__global__ void chebyshev_jacobi_kernel(
+    float* p_next, float* p_curr, float* divergence,
+    int width, int height, int depth, float omega)
+{
+    int x = blockIdx.x * blockDim.x + threadIdx.x;
+    int y = blockIdx.y * blockDim.y + threadIdx.y;
+    int z = blockIdx.z * blockDim.z + threadIdx.z;
+
+    if (x < 1 || x >= width - 1 || y < 1 || y >= height - 1 || z < 1 || z >= depth - 1) return;
+
+    int slice = width * height;
+    int idx = x + y * width + z * slice;
+    float sum = p_curr[idx - 1] + p_curr[idx + 1] + p_curr[idx - width] + p_curr[idx + width] + p_curr[idx - slice] + p_curr[idx + slice];
+    float jacobi = (sum - divergence[idx]) / 6.0f;
+    float prev = p_next[idx];
+    p_next[idx] = prev + omega * (jacobi - prev);
+}
+
 // Project C: Subtract Gradient
 __global__ void subtract_gradient_kernel(
     float3* velocity, float* pressure,
@@ -311,29 +333,115 @@ __global__ void dissipate_kernel(cudaSurfaceObject_t densitySurf, int width, int
     surf3Dwrite(val, densitySurf, x * sizeof(float), y, z);
 }
 
+// ٶȸֵֵ
+// ÿ߳̿ڹڴйԼ atomicMax ϲǸ int Ƚ밴 float Ƚһ
+__global__ void max_velocity_kernel(float3* vel, int size, float* result)
+{
+    __shared__ float smax[256];
+    int tid = threadIdx.x;
+
+    float m = 0.0f;
+    for (int i = blockIdx.x * blockDim.x + tid; i < size; i += blockDim.x * gridDim.x) {
+        float3 v = vel[i];
+        m = fmaxf(m, fmaxf(fabsf(v.x), fmaxf(fabsf(v.y), fabsf(v.z))));
+    }
+    smax[tid] = m;
+    __syncthreads();
+
+    for (int s = blockDim.x / 2; s > 0; s >>= 1) {
+        if (tid < s) smax[tid] = fmaxf(smax[tid], smax[tid + s]);
+        __syncthreads();
+    }
+    if (tid == 0) atomicMax((int*)result, __float_as_int(smax[0]));
+}
+
+// ڲԪ 6 p - sum(p_n) = -divergence Ĳвֵ jacobi_pressure_kernel ķһ
+// p Ϊʱ p = 0 㣬ɢȵֵ
+__global__ void pressure_residual_kernel(float* p, float* divergence, int width, int height, int depth, float* result)
+{
+    __shared__ float smax[256];
+    int tid = threadIdx.x;
+    int slice = width * height;
+    int size = slice * depth;
+
+    float m = 0.0f;
+    for (int idx = blockIdx.x * blockDim.x + tid; idx < size; idx += blockDim.x * gridDim.x) {
+        int x = idx % width;
+        int y = (idx / width) % height;
+        int z = idx / slice;
+        if (x < 1 || x >= width - 1 || y < 1 || y >= height - 1 || z < 1 || z >= depth - 1) continue;
+        if (!p) {
+            m = fmaxf(m, fabsf(divergence[idx]));
+            continue;
+        }
+        float sum = p[idx - 1] + p[idx + 1] + p[idx - width] + p[idx + width] + p[idx - slice] + p[idx + slice];
+        m = fmaxf(m, fabsf(sum - divergence[idx] - 6.0f * p[idx]));
+    }
+    smax[tid] = m;
+    __syncthreads();
+
+    for (int s = blockDim.x / 2; s > 0; s >>= 1) {
+        if (tid < s) smax[tid] = fmaxf(smax[tid], smax[tid + s]);
+        __syncthreads();
+    }
+    if (tid == 0) atomicMax((int*)result, __float_as_int(smax[0]));
+}
+
+// ѹʱ䲽֮һѹ
+__global__ void scale_pressure_kernel(float* p, int size, float s) {
+    int idx = blockIdx.x * blockDim.x + threadIdx.x;
+    if (idx >= size) return;
+    p[idx] *= s;
+}
+
 // =========================================================
 // Wrappers ( C++ )
 // =========================================================
 
-extern "C" void LaunchAdvect(
-    cudaSurfaceObject_t targetSurf, cudaTextureObject_t sourceTex, 
+extern "C" void LaunchAdvectScalars(
+    cudaSurfaceObject_t targetSurfA, cudaTextureObject_t sourceTexA,
+    cudaSurfaceObject_t targetSurfB, cudaTextureObject_t sourceTexB,
     float3* d_velocity, float dt, int w, int h, int d,
-    bool useBFECC)
+    bool useBFECC, int integrator)
 {
     dim3 blockSize(8, 8, 8);
     dim3 gridSize((w + 7) / 8, (h + 7) / 8, (d + 7) / 8);
-    
-    if (useBFECC) {
-        advect_density_BFECC_kernel<<<gridSize, blockSize>>>(targetSurf, sourceTex, d_velocity, dt, w, h, d);
-    } else {
-        advect_density_kernel<<<gridSize, blockSize>>>(targetSurf, sourceTex, d_velocity, dt, w, h, d);
-    }
+    advect_scalars_kernel<<<gridSize, blockSize>>>(targetSurfA, sourceTexA, targetSurfB, sourceTexB, d_velocity, dt, w, h, d, useBFECC, integrator);
 }
 
-extern "C" void LaunchAdvectVelocity(float3* new_vel, float3* old_vel, float dt, int w, int h, int d) {
+extern "C" void LaunchAdvectVelocity(float3* new_vel, float3* old_vel, float dt, int w, int h, int d, int integrator) {
     dim3 blockSize(8, 8, 8);
     dim3 gridSize((w + 7) / 8, (h + 7) / 8, (d + 7) / 8);
-    advect_velocity_kernel<<<gridSize, blockSize>>>(new_vel, old_vel, dt, w, h, d);
+    advect_velocity_kernel<<<gridSize, blockSize>>>(new_vel, old_vel, dt, w, h, d, integrator);
+}
+
+extern "C" float LaunchMaxVelocity(float3* d_vel, int size, float* d_result) {
+    int blockSize = 256;
+    int gridSize = min((size + blockSize - 1) / blockSize, 1024);
+    cudaMemset(d_result, 0, sizeof(float));
+    max_velocity_kernel<<<gridSize, blockSize>>>(d_vel, size, d_result);
+
+    float result = 0.0f;
+    cudaMemcpy(&result, d_result, sizeof(float), cudaMemcpyDeviceToHost);
+    return result;
+}
+
+extern "C" float LaunchPressureResidual(float* d_p, float* d_div, int w, int h, int d, float* d_result) {
+    int size = w * h * d;
+    int blockSize = 256;
+    int gridSize = min((size + blockSize - 1) / blockSize, 1024);
+    cudaMemset(d_result, 0, sizeof(float));
+    pressure_residual_kernel<<<gridSize, blockSize>>>(d_p, d_div, w, h, d, d_result);
+
+    float result = 0.0f;
+    cudaMemcpy(&result, d_result, sizeof(float), cudaMemcpyDeviceToHost);
+    return result;
+}
+
+extern "C" void LaunchScalePressure(float* d_p, int size, float s) {
+    int blockSize = 256;
+    int numBlocks = (size + 255) / blockSize;
+    scale_pressure_kernel<<<numBlocks, blockSize>>>(d_p, size, s);
 }
 
 extern "C" void LaunchApplyBuoyancy(float3* d_velocity, cudaTextureObject_t densityTex, cudaTextureObject_t tempTex, float dt, float alpha, float beta, float ambientTemp, int w, int h, int d) {
@@ -354,6 +462,12 @@ extern "C" void LaunchJacobiPressure(float* p_next, float* p_curr, float* d_div,
     jacobi_pressure_kernel<<<gridSize, blockSize>>>(p_next, p_curr, d_div, w, h, d);
 }
 
+extern "C" void LaunchChebyshevJacobi(float* p_next, float* p_curr, float* d_div, int w, int h, int d, float omega) {
+    dim3 blockSize(8, 8, 8);
+    dim3 gridSize((w + 7) / 8, (h + 7) / 8, (d + 7) / 8);
+    chebyshev_jacobi_kernel<<<gridSize, blockSize>>>(p_next, p_curr, d_div, w, h, d, omega);
+}
+
 extern "C" void LaunchSubtractGradient(float3* d_vel, float* d_p, int w, int h, int d, float halfrdx, float airDensity) {
     dim3 blockSize(8, 8, 8);
     dim3 gridSize((w + 7) / 8, (h + 7) / 8, (d + 7) / 8);
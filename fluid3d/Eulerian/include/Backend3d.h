@@ -0,0 +1,213 @@
+﻿/**
+ * Backend3d.h: 3D欧拉流体求解器的计算后端
+ * Solver 只负责组织求解流程，具体的数据存放位置与计算内核由后端决定
+ * 后端在组件初始化时根据 Eulerian3dPara::backend 创建，切换后需要 Rerun
+ */
+
+#pragma once
+#ifndef __EULERIAN_3D_BACKEND_3D_H__
+#define __EULERIAN_3D_BACKEND_3D_H__
+
+#include "MACGrid3d.h"
+#include "SparseBlocks3d.h"
+#include "Multigrid.h"
+#include "FastPoisson.h"
+#include "Configure.h"
+
+namespace FluidSimulation
+{
+	namespace Eulerian3d
+	{
+		/**
+		 * 后端接口
+		 * 每个函数对应求解流程中的一个阶段，语义与 cuda/Solver.cu 中的 Launch* 一致
+		 */
+		class Backend3d
+		{
+		public:
+			Backend3d(MACGrid3d& grid) : mGrid(grid) {}
+			virtual ~Backend3d() {}
+
+			virtual const char* name() const = 0;
+
+			// 分配后端所需的缓冲
+			virtual void init() = 0;
+			// 一帧开始/结束：映射或上传渲染用的纹理
+			virtual void beginStep() {}
+			virtual void endStep() {}
+			// 等待之前提交的计算完成
+			virtual void synchronize() {}
+
+			// 速度各分量绝对值的最大值（单元/秒），用于 CFL 时间步控制
+			virtual float maxVelocity() = 0;
+
+			// 保存当前密度/温度作为平流的读副本
+			virtual void copyScalarsToTemp() = 0;
+			// 保存当前速度到 backup
+			virtual void saveVelocity() = 0;
+			// 速度自平流：从 backup 读取，写入当前速度，integrator 为 TraceIntegrator
+			virtual void advectVelocity(float dt, int integrator) = 0;
+			// 密度与温度平流：从读副本读取，两者共用每个单元的回溯位置
+			virtual void advectScalars(float dt, bool useBFECC, int integrator) = 0;
+			// Boussinesq 浮力，使用读副本中的上一帧密度与温度
+			virtual void applyBuoyancy(float dt, float alpha, float beta, float ambientTemp) = 0;
+
+			// 投影
+			virtual void computeDivergence(float scale) = 0;
+			virtual void clearPressure() = 0;
+			// 当前压力乘以 s，用作热启动的初值
+			virtual void scalePressure(float s) = 0;
+			// 一次 Jacobi 迭代，结束后交换 Ping-Pong 缓冲
+			virtual void jacobiIteration() = 0;
+			// 一次 Chebyshev 加速的 Jacobi 迭代: p = p_old + omega * (J(p) - p_old)，p_old 为上一次迭代前的压力
+			// 即 Ping-Pong 的另一块缓冲，因此第一次迭代必须是 jacobiIteration；结束后交换缓冲
+			virtual void chebyshevIteration(float omega) = 0;
+			// 连续 count 次迭代，第 t 次的权重为 omega[t]，为 1 时即 jacobiIteration；CPU 后端合并为波前推进
+			virtual void pressureSweeps(int count, const float* omega);
+			// 当前压力在内部单元上的残差的无穷范数，用于提前结束 Jacobi 迭代
+			virtual float pressureResidual() = 0;
+			// 内部单元上散度的无穷范数，即压力为 0 时的残差
+			virtual float pressureRhsNorm() = 0;
+			// 用 PressureSolver 指定的迭代求解器解压力，结果写入当前压力；useInitialGuess 为 true 时以当前压力为初值
+			// 不支持该求解器时返回 false，由 Solver 改用固定次数的 Jacobi 迭代
+			virtual bool solvePressure(int solver, float tolerance, int maxIterations, bool useInitialGuess, int& iterations, double& residual);
+			virtual void subtractGradient(float halfrdx, float scale) = 0;
+
+			// 半步反射: U_reflect = 2 * U_curr - U_backup
+			virtual void reflectVelocity() = 0;
+			// 添加烟雾源与密度耗散
+			virtual void addSource(const Eulerian3dPara::SourceSmoke& src, float radius) = 0;
+			virtual void dissipate(float rate) = 0;
+
+		protected:
+			MACGrid3d& mGrid;
+		};
+
+		/**
+		 * CPU 后端，使用 SolverCPU 中的内核
+		 * threaded 为 false 时以单线程运行，作为参考实现
+		 * Eulerian3dPara::sparseScalars 为 true 时，密度/温度的平流与耗散只处理活跃块
+		 */
+		class CpuBackend3d : public Backend3d
+		{
+		public:
+			CpuBackend3d(MACGrid3d& grid, bool threaded);
+
+			virtual const char* name() const;
+			virtual void init();
+			virtual void beginStep();
+			virtual void endStep();
+			virtual float maxVelocity();
+			virtual void copyScalarsToTemp();
+			virtual void saveVelocity();
+			virtual void advectVelocity(float dt, int integrator);
+			virtual void advectScalars(float dt, bool useBFECC, int integrator);
+			virtual void applyBuoyancy(float dt, float alpha, float beta, float ambientTemp);
+			virtual void computeDivergence(float scale);
+			virtual void clearPressure();
+			virtual void scalePressure(float s);
+			virtual void jacobiIteration();
+			virtual void chebyshevIteration(float omega);
+			virtual void pressureSweeps(int count, const float* omega);
+			virtual float pressureResidual();
+			virtual float pressureRhsNorm();
+			virtual bool solvePressure(int solver, float tolerance, int maxIterations, bool useInitialGuess, int& iterations, double& residual);
+			virtual void subtractGradient(float halfrdx, float scale);
+			virtual void reflectVelocity();
+			virtual void addSource(const Eulerian3dPara::SourceSmoke& src, float radius);
+			virtual void dissipate(float rate);
+
+		protected:
+			// 多重网格类求解器第一次使用时才建立层级，默认的 Jacobi 不需要它
+			void setupMultigrid();
+			// PRESSURE_FFT: 在内部单元上做 DST 直接求解
+			bool solvePressureFFT(int& iterations, double& residual);
+			// pressureSweeps 使用的内核，depth 为每次波前推进合并的迭代次数
+			virtual void jacobiSweeps(float* p_curr, float* p_next, const float* divergence, int count, const float* omega, int depth);
+			// 在临时缓冲上为各候选深度计时，返回最快的一个；网格能放进缓存时通常为 1，即逐次扫描
+			int tuneWavefrontDepth();
+
+			bool mThreaded;
+			bool mSparse;               // 创建时的 Eulerian3dPara::sparseScalars
+			SparseBlocks3d mBlocks;     // 密度/温度的活跃块
+			std::vector<float> mBlockVelocity;  // 每个块的最大速度分量
+			std::vector<int> mBlockHalo;        // 每个块的回溯距离
+			Glb::PoissonMultigrid mMultigrid;   // 体积边界一层为 p = 0 的 Dirichlet 单元，其余为流体
+			bool mMultigridReady;               // mMultigrid 已按当前网格尺寸建立层级
+			std::vector<float> mPressureRhs;    // -divergence
+			Glb::FastPoisson mFastPoisson;      // 内部单元构成的长方体，外面一层为 Dirichlet 边界
+			std::vector<float> mSliceResidual;  // pressureResidual 中每层的最大值
+			int mWavefrontDepth;                // Jacobi 波前合并的迭代次数，0 表示还没有调优
+		};
+
+		/**
+		 * SIMD 后端，在多线程 CPU 后端的基础上
+		 * 用 AVX2 内核替换访存密集的 Jacobi、反射与耗散
+		 */
+		class SimdBackend3d : public CpuBackend3d
+		{
+		public:
+			SimdBackend3d(MACGrid3d& grid);
+
+			virtual const char* name() const;
+			virtual void jacobiIteration();
+			virtual void chebyshevIteration(float omega);
+			virtual void reflectVelocity();
+			virtual void dissipate(float rate);
+
+		protected:
+			virtual void jacobiSweeps(float* p_curr, float* p_next, const float* divergence, int count, const float* omega, int depth);
+		};
+
+#ifdef FLUID_USE_CUDA
+		/**
+		 * CUDA 后端，数据常驻显存，密度/温度直接写入 OpenGL 纹理
+		 */
+		class CudaBackend3d : public Backend3d
+		{
+		public:
+			CudaBackend3d(MACGrid3d& grid);
+			virtual ~CudaBackend3d();
+
+			virtual const char* name() const;
+			virtual void init();
+			virtual void beginStep();
+			virtual void endStep();
+			virtual void synchronize();
+			virtual float maxVelocity();
+			virtual void copyScalarsToTemp();
+			virtual void saveVelocity();
+			virtual void advectVelocity(float dt, int integrator);
+			virtual void advectScalars(float dt, bool useBFECC, int integrator);
+			virtual void applyBuoyancy(float dt, float alpha, float beta, float ambientTemp);
+			virtual void computeDivergence(float scale);
+			virtual void clearPressure();
+			virtual void scalePressure(float s);
+			virtual void jacobiIteration();
+			virtual void chebyshevIteration(float omega);
+			virtual float pressureResidual();
+			virtual float pressureRhsNorm();
+			virtual void subtractGradient(float halfrdx, float scale);
+			virtual void reflectVelocity();
+			virtual void addSource(const Eulerian3dPara::SourceSmoke& src, float radius);
+			virtual void dissipate(float rate);
+
+		protected:
+			// beginStep 中映射的 OpenGL 纹理
+			cudaArray* mDensityArrayGL = nullptr;
+			cudaArray* mTempArrayGL = nullptr;
+			cudaSurfaceObject_t mDensitySurf = 0;
+			cudaSurfaceObject_t mTempSurf = 0;
+			float* mMaxVelocity = nullptr;  // maxVelocity 与 pressureResidual 的归约结果，位于显存
+		};
+#endif
+
+		/**
+		 * 根据 SolverBackend 创建后端
+		 * 请求的后端不可用时（未编译 CUDA 或 CPU 不支持 AVX2）回退到多线程 CPU 后端
+		 */
+		Backend3d* createBackend3d(int type, MACGrid3d& grid);
+	}
+}
+
+#endif // !__EULERIAN_3D_BACKEND_3D_H__
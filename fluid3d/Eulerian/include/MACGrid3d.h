@@ -11,8 +11,11 @@
 #include <glm/glm.hpp>
 #include "GridData3d.h"
 #include <Logger.h>
+#include <vector>
+#ifdef FLUID_USE_CUDA
 #include <cuda_runtime.h>
 #include <cuda_gl_interop.h>
+#endif
 
 namespace FluidSimulation
 {
@@ -42,13 +45,16 @@ namespace FluidSimulation
             void initialize();
             void createSolids();
 
+            // ʹõĻַ Eulerian3dPara::traceIntegrator 
             glm::vec3 semiLagrangian(const glm::vec3 &pt, double dt);
+            // ·ϵĵЧٶȣλΪ pt - traceVelocity(pt, dt) * dt
+            glm::vec3 traceVelocity(const glm::vec3 &pt, double dt);
             glm::vec3 getVelocity(const glm::vec3 &pt);
-            double getVelocityX(const glm::vec3 &pt);
-            double getVelocityY(const glm::vec3 &pt);
-            double getVelocityZ(const glm::vec3 &pt);
-            double getTemperature(const glm::vec3 &pt);
-            double getDensity(const glm::vec3 &pt);
+            Glb::Real getVelocityX(const glm::vec3 &pt);
+            Glb::Real getVelocityY(const glm::vec3 &pt);
+            Glb::Real getVelocityZ(const glm::vec3 &pt);
+            Glb::Real getTemperature(const glm::vec3 &pt);
+            Glb::Real getDensity(const glm::vec3 &pt);
 
             enum Direction
             {
@@ -76,18 +82,24 @@ namespace FluidSimulation
             bool intersects(const glm::vec3 &pt, const glm::vec3 &dir, int i, int j, int k, double &time);
             int numSolidCells();
 
-            double getPressureCoeffBetweenCells(int i0, int j0, int k0, int i1, int j1, int k1);
-            double getDivergence(int i, int j, int k);
-            double checkDivergence(int i, int j, int k);
+            Glb::Real getPressureCoeffBetweenCells(int i0, int j0, int k0, int i1, int j1, int k1);
+            Glb::Real getDivergence(int i, int j, int k);
+            Glb::Real checkDivergence(int i, int j, int k);
             bool checkDivergence();
 
-            double getBoussinesqForce(const glm::vec3 &pt);
+            Glb::Real getBoussinesqForce(const glm::vec3 &pt);
 
             float cellSize;             // ԪС
             int dim[3];                 // ά [, , ]
 
+            void InitTextures();
+            void CleanupTextures();
+            void InitHost();
+            void UploadTextures();          // CPU ˣܶ/¶ϴ OpenGL 
+#ifdef FLUID_USE_CUDA
             void InitCUDA();
             void CleanupCUDA();
+#endif
 
         public:
             Glb::GridData3dX mU;        // Xٶȷ
@@ -99,14 +111,27 @@ namespace FluidSimulation
 
             // ܶȳ (Ⱦ) - OpenGL 
             unsigned int densityTexID = 0;
+            // ¶ȳ
+            unsigned int temperatureTexID = 0;
+
+            // CPU ˵˻壬ڴ沼 CUDA һ: idx = x + y * w + z * w * h
+            std::vector<float> h_density;           // ܶȳ
+            std::vector<float> h_densityTemp;       // ܶȳĶ (Ӧ d_densityArrayTemp)
+            std::vector<float> h_temperature;       // ¶ȳ
+            std::vector<float> h_temperatureTemp;   // ¶ȳĶ
+            std::vector<glm::vec3> h_velocity;      // ٶȳ (u, v, w)λڵԪ
+            std::vector<glm::vec3> h_velocity_backup;
+            std::vector<float> h_pressure;          // ѹ P
+            std::vector<float> h_pressure_temp;     // Jacobi  Ping-Pong 
+            std::vector<float> h_divergence;        // ٶɢ div(u)
+
+#ifdef FLUID_USE_CUDA
             cudaGraphicsResource* cuda_density_res = nullptr; // CUDA ӳ
             // ܶȳ (ڼʱ) - CUDA Array
             // Ϊʵ Ping-Pong д룬Advection ҪӾ״̬д״̬
             cudaArray* d_densityArrayTemp = nullptr;
             cudaTextureObject_t densityTexObjRead = 0; // ڶȡ (֧Բֵ)
 
-            // ¶ȳ
-            unsigned int temperatureTexID = 0;
             cudaGraphicsResource* cuda_temperature_res = nullptr;
             // ¶ȳ (ڼʱ)
             cudaArray* d_temperatureArrayTemp = nullptr;
@@ -118,6 +143,7 @@ namespace FluidSimulation
             float* d_pressure_temp = nullptr; //  Jacobi  Ping-Pong 
             float* d_divergence = nullptr;    // ٶɢ div(u)
             dim3 gpuDim;   // άȵ CUDA 
+#endif
         };
 
 /**
@@ -9,8 +9,7 @@
 
 #include "MACGrid3d.h"
 #include "Configure.h"
-#include <cuda_runtime.h>
-#include <cuda_gl_interop.h>
+#include "Backend3d.h"
 
 namespace FluidSimulation
 {
@@ -28,8 +27,10 @@ namespace FluidSimulation
 			 * @param grid MAC
 			 */
 			Solver(MACGrid3d &grid);
+			~Solver();
 
-			void solveOneStep(cudaSurfaceObject_t densitySurf, cudaArray* densityArrayGL, cudaSurfaceObject_t tempSurf, cudaArray* tempArrayGL, float dt);
+			// ⣺ƽͶӰ
+			void solveOneStep(float dt);
 
 			/**
 			 * ִһ
@@ -39,6 +40,17 @@ namespace FluidSimulation
 
 		protected:
 			MACGrid3d &mGrid;  // MAC
+			Backend3d *mBackend;  // ˣ Eulerian3dPara::backend 
+
+			// ֡Ӳѹʱ
+			int mPressureIterations;
+			double mPressureTime;
+			// һͶӰʱ䲽ʱѹ mPressureDt / dt ţ0 ʾûͶӰ
+			float mPressureDt;
+			// Chebyshev ʹõ Jacobi װ뾶ƣ0 ʾûйƹ
+			float mJacobiRadius;
+			// Jacobi εȨأͨ Jacobi ȫΪ 1
+			std::vector<float> mSweepOmega;
 		};
 	}
 }
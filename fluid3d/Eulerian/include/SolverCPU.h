@@ -0,0 +1,56 @@
+﻿/**
+ * SolverCPU.h: 3D欧拉流体求解器的 CPU 内核
+ * 与 cuda/Solver.cu 中的 Launch* 包装函数一一对应，使用 OpenMP 多线程实现
+ * 所有缓冲的内存布局与 CUDA 端一致: idx = x + y * w + z * w * h
+ */
+
+#pragma once
+#ifndef __EULERIAN_3D_SOLVER_CPU_H__
+#define __EULERIAN_3D_SOLVER_CPU_H__
+
+#include <glm/glm.hpp>
+
+namespace FluidSimulation
+{
+	namespace Eulerian3d
+	{
+		// 是否使用 OpenMP 多线程，scalar 后端会将其关闭
+		void CpuSetParallel(bool parallel);
+
+		// 两个单元中心标量场的平流 (Semi-Lagrangian / BFECC)，从 source 读取，写入 target
+		// 每个单元只回溯一次，两个场共用回溯位置；integrator 为 TraceIntegrator
+		void CpuAdvectScalars(float* targetA, const float* sourceA, float* targetB, const float* sourceB, const glm::vec3* velocity, float dt, int w, int h, int d, bool useBFECC, int integrator);
+		// 只处理 blocks 中列出的 8x8x8 块，块编号 b = bx + by * nbx + bz * nbx * nby
+		void CpuAdvectScalarsBlocks(float* targetA, const float* sourceA, float* targetB, const float* sourceB, const glm::vec3* velocity, float dt, int w, int h, int d, bool useBFECC, int integrator, const int* blocks, int numBlocks);
+		// 每个块内速度各分量绝对值的最大值，用于估计平流的回溯距离
+		void CpuBlockMaxVelocity(float* blockMax, const glm::vec3* velocity, int w, int h, int d);
+		// 速度场自平流，从 old_vel 读取，写入 new_vel
+		void CpuAdvectVelocity(glm::vec3* new_vel, const glm::vec3* old_vel, float dt, int w, int h, int d, int integrator);
+		// Boussinesq 浮力
+		void CpuApplyBuoyancy(glm::vec3* velocity, const float* density, const float* temperature, float dt, float alpha, float beta, float ambientTemp, int w, int h, int d);
+		// 投影：散度、Jacobi 迭代、减去压力梯度
+		void CpuComputeDivergence(float* divergence, const glm::vec3* velocity, int w, int h, int d, float halfrdx);
+		void CpuJacobiPressure(float* p_next, const float* p_curr, const float* divergence, int w, int h, int d);
+		// Chebyshev 加速的 Jacobi: p_next += omega * (J(p_curr) - p_next)，调用前 p_next 为上一次迭代的压力
+		// omega 为 1 时与 CpuJacobiPressure 相同
+		void CpuChebyshevJacobi(float* p_next, const float* p_curr, const float* divergence, int w, int h, int d, float omega);
+		// 从 p_curr 开始连续 sweeps 次迭代，第 t 次的权重为 omega[t] (为空时全为 1)，两块缓冲交替读写
+		// 每 depth 次迭代合并为一次沿 z 的波前推进，结果与逐次调用 CpuChebyshevJacobi 完全相同；sweeps 为奇数时结果在 p_next
+		void CpuJacobiPressureSweeps(float* p_curr, float* p_next, const float* divergence, int w, int h, int d, int sweeps, const float* omega, int depth);
+		// Lanczos 迭代估计 Jacobi 迭代矩阵的谱半径，从下方逼近；只与网格尺寸有关
+		float CpuEstimateJacobiRadius(int w, int h, int d, int iterations);
+		// 内部单元上 Jacobi 方程 6 p - sum(p_n) = -divergence 的残差，sliceMax[z] 为第 z 层的最大绝对值
+		// pressure 为空时按 p = 0 计算，即散度的最大绝对值
+		void CpuPressureResidual(float* sliceMax, const float* pressure, const float* divergence, int w, int h, int d);
+		void CpuSubtractGradient(glm::vec3* velocity, const float* pressure, int w, int h, int d, float halfrdx, float airDensity);
+		// 半步反射: U_reflect = 2 * U_curr - U_old
+		void CpuReflectVelocity(glm::vec3* vel_curr, const glm::vec3* vel_old, int size);
+		// 添加源项与耗散
+		void CpuAddSource(float* field, int x, int y, int z, float radius, float amount, int w, int h, int d);
+		void CpuAddSourceVelocity(glm::vec3* velocity, int x, int y, int z, float radius, glm::vec3 amount, int w, int h, int d);
+		void CpuDissipate(float* field, int w, int h, int d, float rate);
+		void CpuDissipateBlocks(float* field, int w, int h, int d, float rate, const int* blocks, int numBlocks);
+	}
+}
+
+#endif // !__EULERIAN_3D_SOLVER_CPU_H__
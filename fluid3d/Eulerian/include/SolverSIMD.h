@@ -0,0 +1,28 @@
+﻿/**
+ * SolverSIMD.h: 3D欧拉流体求解器的 AVX2 内核
+ * 只覆盖访存密集、无分支的内核，其余阶段仍使用 SolverCPU
+ * 该文件对应的 SolverSIMD.cpp 单独以 AVX2 指令集编译，调用前需确认 Glb::cpuSupportsAVX2()
+ */
+
+#pragma once
+#ifndef __EULERIAN_3D_SOLVER_SIMD_H__
+#define __EULERIAN_3D_SOLVER_SIMD_H__
+
+namespace FluidSimulation
+{
+	namespace Eulerian3d
+	{
+		// 与 CpuJacobiPressure 等价，每次处理一行中的 8 个单元
+		void SimdJacobiPressure(float* p_next, const float* p_curr, const float* divergence, int w, int h, int d);
+		// 与 CpuChebyshevJacobi 等价
+		void SimdChebyshevJacobi(float* p_next, const float* p_curr, const float* divergence, int w, int h, int d, float omega);
+		// 与 CpuJacobiPressureSweeps 等价
+		void SimdJacobiPressureSweeps(float* p_curr, float* p_next, const float* divergence, int w, int h, int d, int sweeps, const float* omega, int depth);
+		// curr = 2 * curr - old，按 float 分量处理，n 为 float 个数
+		void SimdReflect(float* curr, const float* old, int n);
+		// field *= rate
+		void SimdDissipate(float* field, int n, float rate);
+	}
+}
+
+#endif // !__EULERIAN_3D_SOLVER_SIMD_H__
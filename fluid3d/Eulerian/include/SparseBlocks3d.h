@@ -0,0 +1,60 @@
+﻿/**
+ * SparseBlocks3d.h: 密度/温度场的稀疏块索引
+ * 将网格划分为 8x8x8 的块，只记录与背景值不同的块（类似 OpenVDB 的叶节点）
+ * 数据仍存放在稠密数组中（体渲染需要上传整块纹理），平流与耗散只遍历活跃块及其膨胀区域
+ */
+
+#pragma once
+#ifndef __EULERIAN_3D_SPARSE_BLOCKS_3D_H__
+#define __EULERIAN_3D_SPARSE_BLOCKS_3D_H__
+
+#include <vector>
+#include "GridData3d.h"
+
+namespace FluidSimulation
+{
+	namespace Eulerian3d
+	{
+		/**
+		 * 稀疏块索引
+		 * 块编号 b = bx + by * nbx + bz * nbx * nby，与主机缓冲的 x、y、z 顺序一致
+		 * 不变式: 非活跃块中的所有单元都等于背景值
+		 */
+		class SparseBlocks3d
+		{
+		public:
+			// 按网格维度划分块，所有块初始为非活跃；parallel 为 false 时 prune 单线程执行
+			void init(int w, int h, int d, bool parallel);
+
+			// 将包围盒 [x0, x1] x [y0, y1] x [z0, z1] 覆盖的块标记为活跃，在写入源项之前调用
+			void activate(int x0, int y0, int z0, int x1, int y1, int z1);
+
+			// 膨胀活跃块，得到本步需要计算的块
+			// halo[b] 为块 b 中单元的最大回溯距离（单元数），距活跃块更远的块平流后仍为背景值
+			void dilate(const std::vector<int>& halo);
+
+			// 扫描膨胀后的块，与背景值相差均不超过 tolerance 的块写回背景值并置为非活跃
+			void prune(float* density, float* temperature, float tolerance);
+
+			const std::vector<int>& activeBlocks() const { return mActiveList; }
+			const std::vector<int>& dilatedBlocks() const { return mDilatedList; }
+			int numBlocks() const { return mBlocks[0] * mBlocks[1] * mBlocks[2]; }
+
+			static constexpr float densityBackground = 0.0f;       // 与 InitHost 的初始值一致
+			static constexpr float temperatureBackground = 0.0f;
+
+		private:
+			void rebuildActiveList();
+
+			bool mParallel = true;
+			int mDim[3] = { 0, 0, 0 };
+			int mBlocks[3] = { 0, 0, 0 };
+			std::vector<unsigned char> mActive;     // 每个块是否活跃
+			std::vector<int> mActiveList;           // 活跃块的编号
+			std::vector<int> mDilatedList;          // dilate 得到的块编号
+			std::vector<int> mDistance;             // 到最近活跃块的距离（块数，26 邻域）
+		};
+	}
+}
+
+#endif // !__EULERIAN_3D_SPARSE_BLOCKS_3D_H__
@@ -0,0 +1,393 @@
+﻿/**
+ * Backend3d.cpp: 3D欧拉流体 CPU / SIMD 后端实现与后端工厂
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "Backend3d.h"
+#include "SolverCPU.h"
+#include "SolverSIMD.h"
+#include "Global.h"
+
+namespace FluidSimulation
+{
+    namespace Eulerian3d
+    {
+        // 低于该值的密度/温度视为背景值，与 CpuApplyBuoyancy 的阈值一致
+        static const float SPARSE_TOLERANCE = 0.0001f;
+
+        void Backend3d::pressureSweeps(int count, const float* omega)
+        {
+            for (int t = 0; t < count; t++) {
+                if (omega[t] == 1.0f)
+                    jacobiIteration();
+                else
+                    chebyshevIteration(omega[t]);
+            }
+        }
+
+        bool Backend3d::solvePressure(int, float, int, bool, int&, double&)
+        {
+            return false;
+        }
+
+        CpuBackend3d::CpuBackend3d(MACGrid3d& grid, bool threaded) : Backend3d(grid), mThreaded(threaded), mSparse(Eulerian3dPara::sparseScalars), mMultigridReady(false), mWavefrontDepth(0)
+        {
+        }
+
+        const char* CpuBackend3d::name() const
+        {
+            return mThreaded ? solverBackendNames[BACKEND_THREADED] : solverBackendNames[BACKEND_SCALAR];
+        }
+
+        void CpuBackend3d::init()
+        {
+            mGrid.InitHost();
+            mBlocks.init(mGrid.dim[0], mGrid.dim[1], mGrid.dim[2], mThreaded);
+            mBlockVelocity.assign(mBlocks.numBlocks(), 0.0f);
+            mBlockHalo.assign(mBlocks.numBlocks(), 0);
+
+            int w = mGrid.dim[0], h = mGrid.dim[1], d = mGrid.dim[2];
+            mMultigridReady = false;
+            mPressureRhs.assign((size_t)w * h * d, 0.0f);
+            mSliceResidual.assign(d, 0.0f);
+        }
+
+        void CpuBackend3d::setupMultigrid()
+        {
+            if (mMultigridReady)
+                return;
+
+            // 与 Jacobi 迭代一致：体积边界上的压力保持为 0
+            int w = mGrid.dim[0], h = mGrid.dim[1], d = mGrid.dim[2];
+            std::vector<unsigned char> type((size_t)w * h * d, Glb::PoissonMultigrid::FLUID);
+            for (int z = 0; z < d; z++)
+                for (int y = 0; y < h; y++)
+                    for (int x = 0; x < w; x++)
+                        if (x == 0 || y == 0 || z == 0 || x == w - 1 || y == h - 1 || z == d - 1)
+                            type[x + y * w + (size_t)z * w * h] = Glb::PoissonMultigrid::DIRICHLET;
+            mMultigrid.setParallel(mThreaded);
+            mMultigrid.setup(w, h, d, type);
+            mMultigridReady = true;
+        }
+
+        void CpuBackend3d::beginStep()
+        {
+            CpuSetParallel(mThreaded);
+        }
+
+        void CpuBackend3d::endStep()
+        {
+            // 将结果上传至 OpenGL 纹理供体渲染使用
+            mGrid.UploadTextures();
+        }
+
+        float CpuBackend3d::maxVelocity()
+        {
+            // 各块的最大值并行求出，再串行合并
+            CpuBlockMaxVelocity(mBlockVelocity.data(), mGrid.h_velocity.data(), mGrid.dim[0], mGrid.dim[1], mGrid.dim[2]);
+            float vmax = 0.0f;
+            for (float v : mBlockVelocity)
+                vmax = fmaxf(vmax, v);
+            return vmax;
+        }
+
+        void CpuBackend3d::copyScalarsToTemp()
+        {
+            std::copy(mGrid.h_density.begin(), mGrid.h_density.end(), mGrid.h_densityTemp.begin());
+            std::copy(mGrid.h_temperature.begin(), mGrid.h_temperature.end(), mGrid.h_temperatureTemp.begin());
+        }
+
+        void CpuBackend3d::saveVelocity()
+        {
+            std::copy(mGrid.h_velocity.begin(), mGrid.h_velocity.end(), mGrid.h_velocity_backup.begin());
+        }
+
+        void CpuBackend3d::advectVelocity(float dt, int integrator)
+        {
+            CpuAdvectVelocity(mGrid.h_velocity.data(), mGrid.h_velocity_backup.data(), dt, mGrid.dim[0], mGrid.dim[1], mGrid.dim[2], integrator);
+        }
+
+        void CpuBackend3d::advectScalars(float dt, bool useBFECC, int integrator)
+        {
+            int w = mGrid.dim[0], h = mGrid.dim[1], d = mGrid.dim[2];
+            if (!mSparse) {
+                CpuAdvectScalars(mGrid.h_density.data(), mGrid.h_densityTemp.data(), mGrid.h_temperature.data(), mGrid.h_temperatureTemp.data(),
+                    mGrid.h_velocity.data(), dt, w, h, d, useBFECC, integrator);
+                return;
+            }
+
+            // 半拉格朗日的回溯距离不超过块内最大速度 * dt，再加上三线性插值的一个单元
+            // BFECC 的修正位置为 pos - (v0 + v1) * dt / 2，v1 在回溯点采样，用全局最大速度估计
+            // RK2/RK3 的等效速度来自块外的采样点，同样用全局最大速度估计
+            CpuBlockMaxVelocity(mBlockVelocity.data(), mGrid.h_velocity.data(), w, h, d);
+            float vglobal = 0.0f;
+            for (float v : mBlockVelocity)
+                vglobal = fmaxf(vglobal, v);
+            for (size_t b = 0; b < mBlockVelocity.size(); b++) {
+                float v = integrator != TRACE_EULER ? vglobal : (useBFECC ? 0.5f * (mBlockVelocity[b] + vglobal) : mBlockVelocity[b]);
+                mBlockHalo[b] = (int)ceilf(v * fabsf(dt)) + 1;
+            }
+            mBlocks.dilate(mBlockHalo);
+
+            const std::vector<int>& blocks = mBlocks.dilatedBlocks();
+            CpuAdvectScalarsBlocks(mGrid.h_density.data(), mGrid.h_densityTemp.data(), mGrid.h_temperature.data(), mGrid.h_temperatureTemp.data(),
+                mGrid.h_velocity.data(), dt, w, h, d, useBFECC, integrator, blocks.data(), (int)blocks.size());
+            mBlocks.prune(mGrid.h_density.data(), mGrid.h_temperature.data(), SPARSE_TOLERANCE);
+        }
+
+        void CpuBackend3d::applyBuoyancy(float dt, float alpha, float beta, float ambientTemp)
+        {
+            CpuApplyBuoyancy(mGrid.h_velocity.data(), mGrid.h_densityTemp.data(), mGrid.h_temperatureTemp.data(),
+                dt, alpha, beta, ambientTemp, mGrid.dim[0], mGrid.dim[1], mGrid.dim[2]);
+        }
+
+        void CpuBackend3d::computeDivergence(float scale)
+        {
+            CpuComputeDivergence(mGrid.h_divergence.data(), mGrid.h_velocity.data(), mGrid.dim[0], mGrid.dim[1], mGrid.dim[2], scale);
+        }
+
+        void CpuBackend3d::clearPressure()
+        {
+            std::fill(mGrid.h_pressure.begin(), mGrid.h_pressure.end(), 0.0f);
+            std::fill(mGrid.h_pressure_temp.begin(), mGrid.h_pressure_temp.end(), 0.0f);
+        }
+
+        void CpuBackend3d::scalePressure(float s)
+        {
+            float* p = mGrid.h_pressure.data();
+            int n = (int)mGrid.h_pressure.size();
+#pragma omp parallel for if(mThreaded)
+            for (int i = 0; i < n; i++)
+                p[i] *= s;
+        }
+
+        void CpuBackend3d::jacobiIteration()
+        {
+            CpuJacobiPressure(mGrid.h_pressure_temp.data(), mGrid.h_pressure.data(), mGrid.h_divergence.data(), mGrid.dim[0], mGrid.dim[1], mGrid.dim[2]);
+            std::swap(mGrid.h_pressure, mGrid.h_pressure_temp);
+        }
+
+        void CpuBackend3d::chebyshevIteration(float omega)
+        {
+            CpuChebyshevJacobi(mGrid.h_pressure_temp.data(), mGrid.h_pressure.data(), mGrid.h_divergence.data(), mGrid.dim[0], mGrid.dim[1], mGrid.dim[2], omega);
+            std::swap(mGrid.h_pressure, mGrid.h_pressure_temp);
+        }
+
+        void CpuBackend3d::pressureSweeps(int count, const float* omega)
+        {
+            if (mWavefrontDepth == 0) {
+                mWavefrontDepth = tuneWavefrontDepth();
+                Glb::Logger::getInstance().addLog("3d jacobi wavefront depth: " + std::to_string(mWavefrontDepth));
+            }
+            jacobiSweeps(mGrid.h_pressure.data(), mGrid.h_pressure_temp.data(), mGrid.h_divergence.data(), count, omega, mWavefrontDepth);
+            if (count & 1)
+                std::swap(mGrid.h_pressure, mGrid.h_pressure_temp);
+        }
+
+        void CpuBackend3d::jacobiSweeps(float* p_curr, float* p_next, const float* divergence, int count, const float* omega, int depth)
+        {
+            CpuJacobiPressureSweeps(p_curr, p_next, divergence, mGrid.dim[0], mGrid.dim[1], mGrid.dim[2], count, omega, depth);
+        }
+
+        int CpuBackend3d::tuneWavefrontDepth()
+        {
+            // 每个候选深度做两轮 12 次迭代，取较快的一轮；数据全为 0，不会出现非规格化数
+            static const int candidates[] = { 1, 2, 3, 4, 6 };
+            const int sweeps = 12;
+            size_t n = mGrid.h_pressure.size();
+            std::vector<float> a(n, 0.0f), b(n, 0.0f), div(n, 0.0f);
+            int best = 1;
+            double bestTime = 0.0;
+            for (int c = 0; c < (int)(sizeof(candidates) / sizeof(candidates[0])); c++) {
+                double time = 0.0;
+                for (int round = 0; round < 2; round++) {
+                    auto start = std::chrono::steady_clock::now();
+                    jacobiSweeps(a.data(), b.data(), div.data(), sweeps, nullptr, candidates[c]);
+                    double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                    time = round == 0 || t < time ? t : time;
+                }
+                if (c == 0 || time < bestTime) {
+                    best = candidates[c];
+                    bestTime = time;
+                }
+            }
+            return best;
+        }
+
+        float CpuBackend3d::pressureResidual()
+        {
+            CpuPressureResidual(mSliceResidual.data(), mGrid.h_pressure.data(), mGrid.h_divergence.data(), mGrid.dim[0], mGrid.dim[1], mGrid.dim[2]);
+            float m = 0.0f;
+            for (float r : mSliceResidual)
+                m = fmaxf(m, r);
+            return m;
+        }
+
+        float CpuBackend3d::pressureRhsNorm()
+        {
+            CpuPressureResidual(mSliceResidual.data(), nullptr, mGrid.h_divergence.data(), mGrid.dim[0], mGrid.dim[1], mGrid.dim[2]);
+            float m = 0.0f;
+            for (float r : mSliceResidual)
+                m = fmaxf(m, r);
+            return m;
+        }
+
+        bool CpuBackend3d::solvePressure(int solver, float tolerance, int maxIterations, bool useInitialGuess, int& iterations, double& residual)
+        {
+            if (solver == PRESSURE_FFT)
+                return solvePressureFFT(iterations, residual);
+            if (solver != PRESSURE_PCG && solver != PRESSURE_MULTIGRID && solver != PRESSURE_MGPCG)
+                return false;
+
+            // Jacobi 迭代求解的是 6 p - sum(p_n) = -divergence
+            const float* div = mGrid.h_divergence.data();
+            float* rhs = mPressureRhs.data();
+            int n = (int)mPressureRhs.size();
+#pragma omp parallel for if(mThreaded)
+            for (int i = 0; i < n; i++)
+                rhs[i] = -div[i];
+
+            setupMultigrid();
+            mMultigrid.setParallel(mThreaded);
+            if (solver == PRESSURE_MULTIGRID)
+                iterations = mMultigrid.solve(rhs, mGrid.h_pressure.data(), tolerance, maxIterations, useInitialGuess, residual);
+            else
+                iterations = mMultigrid.solvePCG(rhs, mGrid.h_pressure.data(), tolerance, maxIterations, solver == PRESSURE_MGPCG, useInitialGuess, residual);
+            return true;
+        }
+
+        bool CpuBackend3d::solvePressureFFT(int& iterations, double& residual)
+        {
+            // 内核不区分固体，除去边界一层后总是无障碍的长方体，压力的边界值固定为 0
+            int w = mGrid.dim[0], h = mGrid.dim[1], d = mGrid.dim[2];
+            int nx = w - 2, ny = h - 2, nz = d - 2;
+            if (nx < 1 || ny < 1 || nz < 1)
+                return false;
+
+            const float* div = mGrid.h_divergence.data();
+            float* p = mGrid.h_pressure.data();
+            float* inner = mPressureRhs.data();
+#pragma omp parallel for if(mThreaded)
+            for (int k = 0; k < nz; k++)
+                for (int j = 0; j < ny; j++)
+                    for (int i = 0; i < nx; i++)
+                        inner[i + j * nx + k * nx * ny] = -div[(i + 1) + (j + 1) * w + (k + 1) * w * h];
+
+            mFastPoisson.setParallel(mThreaded);
+            mFastPoisson.setup(nx, ny, nz, Glb::FastPoisson::DIRICHLET);
+            mFastPoisson.solve(inner, inner);
+
+            std::fill(mGrid.h_pressure.begin(), mGrid.h_pressure.end(), 0.0f);
+#pragma omp parallel for if(mThreaded)
+            for (int k = 0; k < nz; k++)
+                for (int j = 0; j < ny; j++)
+                    for (int i = 0; i < nx; i++)
+                        p[(i + 1) + (j + 1) * w + (k + 1) * w * h] = inner[i + j * nx + k * nx * ny];
+
+            iterations = 0;
+            residual = pressureResidual();
+            return true;
+        }
+
+        void CpuBackend3d::subtractGradient(float halfrdx, float scale)
+        {
+            CpuSubtractGradient(mGrid.h_velocity.data(), mGrid.h_pressure.data(), mGrid.dim[0], mGrid.dim[1], mGrid.dim[2], halfrdx, scale);
+        }
+
+        void CpuBackend3d::reflectVelocity()
+        {
+            CpuReflectVelocity(mGrid.h_velocity.data(), mGrid.h_velocity_backup.data(), (int)mGrid.h_velocity.size());
+        }
+
+        void CpuBackend3d::addSource(const Eulerian3dPara::SourceSmoke& src, float radius)
+        {
+            int w = mGrid.dim[0], h = mGrid.dim[1], d = mGrid.dim[2];
+            if (mSparse) {
+                int r = (int)ceilf(radius);
+                mBlocks.activate(src.position.x - r, src.position.y - r, src.position.z - r,
+                    src.position.x + r, src.position.y + r, src.position.z + r);
+            }
+            CpuAddSource(mGrid.h_density.data(), src.position.x, src.position.y, src.position.z, radius, src.density, w, h, d);
+            CpuAddSource(mGrid.h_temperature.data(), src.position.x, src.position.y, src.position.z, radius, src.temp, w, h, d);
+            CpuAddSourceVelocity(mGrid.h_velocity.data(), src.position.x, src.position.y, src.position.z, radius, src.velocity, w, h, d);
+        }
+
+        void CpuBackend3d::dissipate(float rate)
+        {
+            if (mSparse) {
+                // 非活跃块的密度为 0，耗散后不变
+                const std::vector<int>& blocks = mBlocks.activeBlocks();
+                CpuDissipateBlocks(mGrid.h_density.data(), mGrid.dim[0], mGrid.dim[1], mGrid.dim[2], rate, blocks.data(), (int)blocks.size());
+                return;
+            }
+            CpuDissipate(mGrid.h_density.data(), mGrid.dim[0], mGrid.dim[1], mGrid.dim[2], rate);
+        }
+
+        SimdBackend3d::SimdBackend3d(MACGrid3d& grid) : CpuBackend3d(grid, true)
+        {
+        }
+
+        const char* SimdBackend3d::name() const
+        {
+            return solverBackendNames[BACKEND_SIMD];
+        }
+
+        void SimdBackend3d::jacobiIteration()
+        {
+            SimdJacobiPressure(mGrid.h_pressure_temp.data(), mGrid.h_pressure.data(), mGrid.h_divergence.data(), mGrid.dim[0], mGrid.dim[1], mGrid.dim[2]);
+            std::swap(mGrid.h_pressure, mGrid.h_pressure_temp);
+        }
+
+        void SimdBackend3d::chebyshevIteration(float omega)
+        {
+            SimdChebyshevJacobi(mGrid.h_pressure_temp.data(), mGrid.h_pressure.data(), mGrid.h_divergence.data(), mGrid.dim[0], mGrid.dim[1], mGrid.dim[2], omega);
+            std::swap(mGrid.h_pressure, mGrid.h_pressure_temp);
+        }
+
+        void SimdBackend3d::jacobiSweeps(float* p_curr, float* p_next, const float* divergence, int count, const float* omega, int depth)
+        {
+            SimdJacobiPressureSweeps(p_curr, p_next, divergence, mGrid.dim[0], mGrid.dim[1], mGrid.dim[2], count, omega, depth);
+        }
+
+        void SimdBackend3d::reflectVelocity()
+        {
+            // glm::vec3 为 3 个连续的 float，可按 float 数组处理
+            SimdReflect(&mGrid.h_velocity[0].x, &mGrid.h_velocity_backup[0].x, (int)mGrid.h_velocity.size() * 3);
+        }
+
+        void SimdBackend3d::dissipate(float rate)
+        {
+            if (mSparse) {
+                CpuBackend3d::dissipate(rate);
+                return;
+            }
+            SimdDissipate(mGrid.h_density.data(), (int)mGrid.h_density.size(), rate);
+        }
+
+        Backend3d* createBackend3d(int type, MACGrid3d& grid)
+        {
+            switch (type) {
+            case BACKEND_SCALAR:
+                return new CpuBackend3d(grid, false);
+            case BACKEND_SIMD:
+                if (Glb::cpuSupportsAVX2()) {
+                    return new SimdBackend3d(grid);
+                }
+                Glb::Logger::getInstance().addLog("AVX2 is not supported on this CPU, fall back to threaded backend.");
+                break;
+            case BACKEND_CUDA:
+#ifdef FLUID_USE_CUDA
+                return new CudaBackend3d(grid);
+#else
+                Glb::Logger::getInstance().addLog("Built without CUDA, fall back to threaded backend.");
+                break;
+#endif
+            default:
+                break;
+            }
+            return new CpuBackend3d(grid, true);
+        }
+    }
+}
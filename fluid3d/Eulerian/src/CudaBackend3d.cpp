@@ -0,0 +1,203 @@
+﻿/**
+ * CudaBackend3d.cpp: 3D欧拉流体 CUDA 后端实现
+ * 对 cuda/Solver.cu 中 Launch* 包装函数的封装
+ */
+
+#ifdef FLUID_USE_CUDA
+
+#include <algorithm>
+#include "Backend3d.h"
+
+// Declare CUDA kernel launchers
+extern "C" void LaunchAdvectScalars(cudaSurfaceObject_t targetSurfA, cudaTextureObject_t sourceTexA, cudaSurfaceObject_t targetSurfB, cudaTextureObject_t sourceTexB, float3* d_velocity, float dt, int w, int h, int d, bool useBFECC, int integrator);
+extern "C" void LaunchAdvectVelocity(float3* new_vel, float3* old_vel, float dt, int w, int h, int d, int integrator);
+extern "C" void LaunchApplyBuoyancy(float3* d_velocity, cudaTextureObject_t densityTex, cudaTextureObject_t tempTex, float dt, float alpha, float beta, float ambientTemp, int w, int h, int d);
+extern "C" void LaunchSubtractGradient(float3* d_vel, float* d_p, int w, int h, int d, float halfrdx, float airDensity);
+extern "C" void LaunchComputeDivergence(float* d_div, float3* d_vel, int w, int h, int d, float halfrdx);
+extern "C" void LaunchJacobiPressure(float* p_next, float* p_curr, float* d_div, int w, int h, int d);
+extern "C" void LaunchChebyshevJacobi(float* p_next, float* p_curr, float* d_div, int w, int h, int d, float omega);
+extern "C" void LaunchReflectVelocity(float3* d_vel_curr, float3* d_vel_old, int size);
+extern "C" void LaunchAddSource(cudaSurfaceObject_t destSurf, int x, int y, int z, float radius, float amount, int w, int h, int d);
+extern "C" void LaunchAddSourceVelocity(float3* velocity, int x, int y, int z, float radius, float3 amount, int w, int h, int d);
+extern "C" void LaunchDissipate(cudaSurfaceObject_t densitySurf, int w, int h, int d, float rate);
+extern "C" float LaunchMaxVelocity(float3* d_vel, int size, float* d_result);
+extern "C" float LaunchPressureResidual(float* d_p, float* d_div, int w, int h, int d, float* d_result);
+extern "C" void LaunchScalePressure(float* d_p, int size, float s);
+
+namespace FluidSimulation
+{
+    namespace Eulerian3d
+    {
+        CudaBackend3d::CudaBackend3d(MACGrid3d& grid) : Backend3d(grid)
+        {
+        }
+
+        CudaBackend3d::~CudaBackend3d()
+        {
+            if (mMaxVelocity) {
+                cudaFree(mMaxVelocity);
+                mMaxVelocity = nullptr;
+            }
+        }
+
+        const char* CudaBackend3d::name() const
+        {
+            return solverBackendNames[BACKEND_CUDA];
+        }
+
+        void CudaBackend3d::init()
+        {
+            mGrid.InitCUDA();
+            cudaMalloc(&mMaxVelocity, sizeof(float));
+        }
+
+        void CudaBackend3d::beginStep()
+        {
+            // Map OpenGL 3D texture to CUDA
+            cudaGraphicsMapResources(1, &mGrid.cuda_density_res, 0);
+            cudaGraphicsSubResourceGetMappedArray(&mDensityArrayGL, mGrid.cuda_density_res, 0, 0);
+            cudaGraphicsMapResources(1, &mGrid.cuda_temperature_res, 0);
+            cudaGraphicsSubResourceGetMappedArray(&mTempArrayGL, mGrid.cuda_temperature_res, 0, 0);
+
+            // Create Surface Object (用于写入 OpenGL 纹理)
+            cudaResourceDesc surfResDesc;
+            memset(&surfResDesc, 0, sizeof(surfResDesc));
+            surfResDesc.resType = cudaResourceTypeArray;
+            surfResDesc.res.array.array = mDensityArrayGL;
+            cudaCreateSurfaceObject(&mDensitySurf, &surfResDesc);
+            surfResDesc.res.array.array = mTempArrayGL;
+            cudaCreateSurfaceObject(&mTempSurf, &surfResDesc);
+        }
+
+        void CudaBackend3d::endStep()
+        {
+            // Cleanup
+            cudaDestroySurfaceObject(mDensitySurf);
+            cudaDestroySurfaceObject(mTempSurf);
+            cudaGraphicsUnmapResources(1, &mGrid.cuda_density_res, 0);
+            cudaGraphicsUnmapResources(1, &mGrid.cuda_temperature_res, 0);
+            mDensitySurf = 0;
+            mTempSurf = 0;
+        }
+
+        void CudaBackend3d::synchronize()
+        {
+            cudaDeviceSynchronize();
+        }
+
+        float CudaBackend3d::maxVelocity()
+        {
+            return LaunchMaxVelocity(mGrid.d_velocity, mGrid.dim[0] * mGrid.dim[1] * mGrid.dim[2], mMaxVelocity);
+        }
+
+        void CudaBackend3d::copyScalarsToTemp()
+        {
+            // Copy: OpenGL -> Temp
+            cudaMemcpy3DParms copyParams = { 0 };
+            copyParams.extent = make_cudaExtent(mGrid.dim[0], mGrid.dim[1], mGrid.dim[2]);
+            copyParams.kind = cudaMemcpyDeviceToDevice;
+            copyParams.srcArray = mDensityArrayGL;
+            copyParams.dstArray = mGrid.d_densityArrayTemp;
+            cudaMemcpy3D(&copyParams);
+            copyParams.srcArray = mTempArrayGL;
+            copyParams.dstArray = mGrid.d_temperatureArrayTemp;
+            cudaMemcpy3D(&copyParams);
+        }
+
+        void CudaBackend3d::saveVelocity()
+        {
+            int size = mGrid.dim[0] * mGrid.dim[1] * mGrid.dim[2];
+            cudaMemcpy(mGrid.d_velocity_backup, mGrid.d_velocity, size * sizeof(float3), cudaMemcpyDeviceToDevice);
+        }
+
+        void CudaBackend3d::advectVelocity(float dt, int integrator)
+        {
+            LaunchAdvectVelocity(mGrid.d_velocity, mGrid.d_velocity_backup, dt, mGrid.dim[0], mGrid.dim[1], mGrid.dim[2], integrator);
+        }
+
+        void CudaBackend3d::advectScalars(float dt, bool useBFECC, int integrator)
+        {
+            int w = mGrid.dim[0], h = mGrid.dim[1], d = mGrid.dim[2];
+            LaunchAdvectScalars(mDensitySurf, mGrid.densityTexObjRead, mTempSurf, mGrid.temperatureTexObjRead,
+                mGrid.d_velocity, dt, w, h, d, useBFECC, integrator);
+        }
+
+        void CudaBackend3d::applyBuoyancy(float dt, float alpha, float beta, float ambientTemp)
+        {
+            LaunchApplyBuoyancy(
+                mGrid.d_velocity,
+                mGrid.densityTexObjRead, // 使用上一帧密度
+                mGrid.temperatureTexObjRead, // 使用上一帧温度
+                dt, alpha, beta, ambientTemp,
+                mGrid.dim[0], mGrid.dim[1], mGrid.dim[2]
+            );
+        }
+
+        void CudaBackend3d::computeDivergence(float scale)
+        {
+            LaunchComputeDivergence(mGrid.d_divergence, mGrid.d_velocity, mGrid.dim[0], mGrid.dim[1], mGrid.dim[2], scale);
+        }
+
+        void CudaBackend3d::clearPressure()
+        {
+            int size = mGrid.dim[0] * mGrid.dim[1] * mGrid.dim[2];
+            cudaMemset(mGrid.d_pressure, 0, size * sizeof(float));
+            cudaMemset(mGrid.d_pressure_temp, 0, size * sizeof(float));
+        }
+
+        void CudaBackend3d::scalePressure(float s)
+        {
+            LaunchScalePressure(mGrid.d_pressure, mGrid.dim[0] * mGrid.dim[1] * mGrid.dim[2], s);
+        }
+
+        float CudaBackend3d::pressureResidual()
+        {
+            return LaunchPressureResidual(mGrid.d_pressure, mGrid.d_divergence, mGrid.dim[0], mGrid.dim[1], mGrid.dim[2], mMaxVelocity);
+        }
+
+        float CudaBackend3d::pressureRhsNorm()
+        {
+            return LaunchPressureResidual(nullptr, mGrid.d_divergence, mGrid.dim[0], mGrid.dim[1], mGrid.dim[2], mMaxVelocity);
+        }
+
+        void CudaBackend3d::jacobiIteration()
+        {
+            LaunchJacobiPressure(mGrid.d_pressure_temp, mGrid.d_pressure, mGrid.d_divergence, mGrid.dim[0], mGrid.dim[1], mGrid.dim[2]);
+            std::swap(mGrid.d_pressure, mGrid.d_pressure_temp);
+        }
+
+        void CudaBackend3d::chebyshevIteration(float omega)
+        {
+            LaunchChebyshevJacobi(mGrid.d_pressure_temp, mGrid.d_pressure, mGrid.d_divergence, mGrid.dim[0], mGrid.dim[1], mGrid.dim[2], omega);
+            std::swap(mGrid.d_pressure, mGrid.d_pressure_temp);
+        }
+
+        void CudaBackend3d::subtractGradient(float halfrdx, float scale)
+        {
+            LaunchSubtractGradient(mGrid.d_velocity, mGrid.d_pressure, mGrid.dim[0], mGrid.dim[1], mGrid.dim[2], halfrdx, scale);
+        }
+
+        void CudaBackend3d::reflectVelocity()
+        {
+            if (mGrid.d_velocity_backup) {
+                LaunchReflectVelocity(mGrid.d_velocity, mGrid.d_velocity_backup, mGrid.dim[0] * mGrid.dim[1] * mGrid.dim[2]);
+            }
+        }
+
+        void CudaBackend3d::addSource(const Eulerian3dPara::SourceSmoke& src, float radius)
+        {
+            int w = mGrid.dim[0], h = mGrid.dim[1], d = mGrid.dim[2];
+            LaunchAddSource(mDensitySurf, src.position.x, src.position.y, src.position.z, radius, src.density, w, h, d);
+            LaunchAddSource(mTempSurf, src.position.x, src.position.y, src.position.z, radius, src.temp, w, h, d);
+            float3 velVal = make_float3(src.velocity.x, src.velocity.y, src.velocity.z);
+            LaunchAddSourceVelocity(mGrid.d_velocity, src.position.x, src.position.y, src.position.z, radius, velVal, w, h, d);
+        }
+
+        void CudaBackend3d::dissipate(float rate)
+        {
+            LaunchDissipate(mDensitySurf, mGrid.dim[0], mGrid.dim[1], mGrid.dim[2], rate);
+        }
+    }
+}
+
+#endif // FLUID_USE_CUDA
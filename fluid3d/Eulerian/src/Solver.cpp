@@ -6,89 +6,114 @@
 #include "fluid3d/Eulerian/include/Solver.h"
 #include "Configure.h"
 #include "Global.h"
-
-// Declare CUDA kernel launchers
-extern "C" void LaunchAdvect(cudaSurfaceObject_t targetSurf, cudaTextureObject_t sourceTex, float3* d_velocity, float dt, int w, int h, int d, bool useBFECC);
-extern "C" void LaunchAdvectVelocity(float3* new_vel, float3* old_vel, float dt, int w, int h, int d);
-extern "C" void LaunchApplyBuoyancy(float3* d_velocity, cudaTextureObject_t densityTex, cudaTextureObject_t tempTex, float dt, float alpha, float beta, float ambientTemp, int w, int h, int d);
-extern "C" void LaunchSubtractGradient(float3* d_vel, float* d_p, int w, int h, int d, float halfrdx, float airDensity);
-extern "C" void LaunchComputeDivergence(float* d_div, float3* d_vel, int w, int h, int d, float halfrdx);
-extern "C" void LaunchJacobiPressure(float* p_next, float* p_curr, float* d_div, int w, int h, int d);
-extern "C" void LaunchReflectVelocity(float3* d_vel_curr, float3* d_vel_old, int size);
-extern "C" void LaunchAddSource(cudaSurfaceObject_t destSurf, int x, int y, int z, float radius, float amount, int w, int h, int d);
-extern "C" void LaunchAddSourceVelocity(float3* velocity, int x, int y, int z, float radius, float3 amount, int w, int h, int d);
-extern "C" void LaunchDissipate(cudaSurfaceObject_t densitySurf, int w, int h, int d, float rate);
+#include "CflController.h"
+#include "PressureMonitor.h"
+#include "SolverCPU.h"
+#include <cstdio>
 
 namespace FluidSimulation
 {
     namespace Eulerian3d
     {
+        // Chebyshev ҪвǰpressureCheckInterval Ϊ 0 ʱʹõļ
+        static const int CHEBYSHEV_CHECK_INTERVAL = 10;
+
         /**
          * 캯ʼ
          * @param grid MAC
          */
-        Solver::Solver(MACGrid3d &grid) : mGrid(grid)
+        Solver::Solver(MACGrid3d &grid) : mGrid(grid), mPressureIterations(0), mPressureTime(0.0), mPressureDt(0.0f), mJacobiRadius(0.0f)
         {
             // ʼʱ
             mGrid.reset();
+
+            // ˲仺
+            mBackend = createBackend3d(Eulerian3dPara::backend, mGrid);
+            mBackend->init();
+            Glb::Logger::getInstance().addLog(std::string("3d solver backend: ") + mBackend->name());
+        }
+
+        Solver::~Solver()
+        {
+            delete mBackend;
+            mBackend = NULL;
         }
 
         // helper function
-        void Solver::solveOneStep(cudaSurfaceObject_t densitySurf, cudaArray* densityArrayGL, cudaSurfaceObject_t tempSurf, cudaArray* tempArrayGL, float dt)
+        void Solver::solveOneStep(float dt)
         {
-            int w = mGrid.dim[0], h = mGrid.dim[1], d = mGrid.dim[2];
-
-            // 1. Copy: OpenGL -> Temp
-            cudaMemcpy3DParms copyParams = { 0 };
-            copyParams.extent = make_cudaExtent(w, h, d);
-            copyParams.kind = cudaMemcpyDeviceToDevice;
-            copyParams.srcArray = densityArrayGL;
-            copyParams.dstArray = mGrid.d_densityArrayTemp;
-            cudaMemcpy3D(&copyParams);
-            copyParams.srcArray = tempArrayGL;
-            copyParams.dstArray = mGrid.d_temperatureArrayTemp;
-            cudaMemcpy3D(&copyParams);
-
-            cudaMemcpy(mGrid.d_velocity_backup, mGrid.d_velocity, w * h * d * sizeof(float3), cudaMemcpyDeviceToDevice);
-            LaunchAdvectVelocity(mGrid.d_velocity, mGrid.d_velocity_backup, dt, w, h, d);
+            // 1. Copy: ǰ״̬ -> 
+            mBackend->copyScalarsToTemp();
+
+            mBackend->saveVelocity();
+            mBackend->advectVelocity(dt, Eulerian3dPara::traceIntegrator);
 
             // 2. Advect
-            LaunchAdvect(densitySurf, mGrid.densityTexObjRead, mGrid.d_velocity, dt, w, h, d, Eulerian3dPara::useBFECC);
-            LaunchAdvect(tempSurf, mGrid.temperatureTexObjRead, mGrid.d_velocity, dt, w, h, d, Eulerian3dPara::useBFECC);
-
-            // 3. Force
-            LaunchApplyBuoyancy(
-                mGrid.d_velocity,
-                mGrid.densityTexObjRead, // ʹһ֡ܶ
-				mGrid.temperatureTexObjRead, // ʹһ֡¶
+            mBackend->advectScalars(dt, Eulerian3dPara::useBFECC, Eulerian3dPara::traceIntegrator);
+
+            // 3. Force (ʹһ֡ܶ¶)
+            mBackend->applyBuoyancy(
                 dt,
                 Eulerian3dPara::boussinesqAlpha,
                 Eulerian3dPara::boussinesqBeta,
-                Eulerian3dPara::ambientTemp,
-                w, h, d
+                Eulerian3dPara::ambientTemp
             );
 
             // 4. Project
             float scaleDiv = (mGrid.cellSize * Eulerian3dPara::airDensity) / (2.0f * dt);
-            LaunchComputeDivergence(mGrid.d_divergence, mGrid.d_velocity, w, h, d, scaleDiv);
-            cudaMemset(mGrid.d_pressure, 0, w * h * d * sizeof(float));
-            cudaMemset(mGrid.d_pressure_temp, 0, w * h * d * sizeof(float));
-
-            int iterations = 40;
-            for (int i = 0; i < iterations; i++) {
-                LaunchJacobiPressure(mGrid.d_pressure_temp, mGrid.d_pressure, mGrid.d_divergence, w, h, d);
-                std::swap(mGrid.d_pressure, mGrid.d_pressure_temp);
+            mBackend->computeDivergence(scaleDiv);
+
+            // ѹ 1/dt ȣһѹʱ䲽֮źΪֵ
+            bool warmStart = Eulerian3dPara::warmStartPressure && mPressureDt > 0.0f;
+            if (warmStart)
+                mBackend->scalePressure(mPressureDt / dt);
+            else
+                mBackend->clearPressure();
+
+            bool chebyshev = Eulerian3dPara::pressureSolver == PRESSURE_CHEBYSHEV;
+            int checkInterval = chebyshev && Eulerian3dPara::pressureCheckInterval <= 0 ? CHEBYSHEV_CHECK_INTERVAL : Eulerian3dPara::pressureCheckInterval;
+            Glb::PressureMonitor monitor(Eulerian3dPara::pressureTolerance, checkInterval);
+            float rhsNorm = mBackend->pressureRhsNorm();
+            monitor.begin(warmStart ? mBackend->pressureResidual() : rhsNorm, rhsNorm);
+            int iterations = 0;
+            double residual = 0.0;
+            if (Eulerian3dPara::pressureSolver != PRESSURE_JACOBI &&
+                mBackend->solvePressure(Eulerian3dPara::pressureSolver, Eulerian3dPara::pressureTolerance, Eulerian3dPara::pressureMaxIterations, warmStart, iterations, residual)) {
+                monitor.finish(iterations, residual);
             }
+            else {
+                // ĬҲ CUDA 벻ֵ֧Ļ
+                // Chebyshev : omega_1 = 1, omega_2 = 2 / (2 - rho^2), omega_k+1 = 4 / (4 - rho^2 omega_k)
+                // rho ƫСʱʽ [-1, 1] ϵľֵԲ 1ֻô·ƽĹ
+                if (chebyshev && mJacobiRadius <= 0.0f) {
+                    mJacobiRadius = CpuEstimateJacobiRadius(mGrid.dim[0], mGrid.dim[1], mGrid.dim[2], 30);
+                    Glb::Logger::getInstance().addLog("3d jacobi spectral radius estimate: " + std::to_string(mJacobiRadius));
+                }
+                // Jacobi ̶ 40 ΣChebyshev ö࣬ݲ
+                int maxIterations = chebyshev ? Eulerian3dPara::pressureMaxIterations : 40;
+                float rho2 = mJacobiRadius * mJacobiRadius;
+                mSweepOmega.assign(maxIterations > 0 ? maxIterations : 1, 1.0f);
+                for (int i = 2; chebyshev && i <= maxIterations; i++)
+                    mSweepOmega[i - 1] = i == 2 ? 2.0f / (2.0f - rho2) : 4.0f / (4.0f - rho2 * mSweepOmega[i - 2]);
+                // βв֮ĵһνˣCPU ˿ԺϲΪǰƽ
+                for (int i = 0; i < maxIterations && !monitor.converged(); ) {
+                    int count = monitor.untilCheck(maxIterations - i);
+                    mBackend->pressureSweeps(count, mSweepOmega.data() + i);
+                    i += count;
+                    if (monitor.step(count))
+                        monitor.update(mBackend->pressureResidual());
+                }
+                if (!monitor.upToDate())
+                    monitor.update(mBackend->pressureResidual());
+            }
+            monitor.report();
+            mPressureIterations += monitor.iterations();
+            mPressureTime += monitor.elapsed();
+            mPressureDt = dt;
 
             float halfrdx = 0.5f / mGrid.cellSize;
             float scaleSub = Eulerian3dPara::airDensity / dt;
-            LaunchSubtractGradient(
-                mGrid.d_velocity,
-                mGrid.d_pressure,
-                w, h, d,
-                halfrdx,
-                scaleSub
-            );
+            mBackend->subtractGradient(halfrdx, scaleSub);
         }
 
         /**
@@ -97,71 +122,54 @@ namespace FluidSimulation
          */
         void Solver::solve()
         {
-            // TODO: ʵά
             // Ҫ:
             // 1. ƽ(advection) - ٶȳƽ
             // 2. (縡) - Boussinesq
             // 3. ͶӰ(projection) - ѹʹٶȳɢ
             // 4. ߽紦 - ߽Ľ
-            float dt = Eulerian3dPara::dt;
-            int w = mGrid.dim[0], h = mGrid.dim[1], d = mGrid.dim[2];
-            int size = w * h * d;
-
-			// Map OpenGL 3D texture to CUDA
-            cudaGraphicsMapResources(1, &mGrid.cuda_density_res, 0);
-            cudaArray* densityArrayGL;
-            cudaGraphicsSubResourceGetMappedArray(&densityArrayGL, mGrid.cuda_density_res, 0, 0);
-            cudaGraphicsMapResources(1, &mGrid.cuda_temperature_res, 0);
-            cudaArray* tempArrayGL;
-            cudaGraphicsSubResourceGetMappedArray(&tempArrayGL, mGrid.cuda_temperature_res, 0, 0);
-
-            // Create Surface Object (д OpenGL )
-            cudaResourceDesc surfResDesc;
-            memset(&surfResDesc, 0, sizeof(surfResDesc));
-            surfResDesc.resType = cudaResourceTypeArray;
-            surfResDesc.res.array.array = densityArrayGL;
-            cudaSurfaceObject_t densitySurf;
-            cudaCreateSurfaceObject(&densitySurf, &surfResDesc);
-            surfResDesc.res.array.array = tempArrayGL;
-            cudaSurfaceObject_t tempSurf;
-            cudaCreateSurfaceObject(&tempSurf, &surfResDesc);
-
-            if (Eulerian3dPara::useReflection) {
-                if (mGrid.d_velocity_backup) {
-                    cudaMemcpy(mGrid.d_velocity_backup, mGrid.d_velocity, size * sizeof(float3), cudaMemcpyDeviceToDevice);
+            mBackend->beginStep();
+
+            // Ӧʱ Eulerian3dPara::dt Ϊһ֡ƽʱ䣬 CFL ֳӲ
+            // 3D ںеٶԪΪȵλ
+            Glb::CflController stepper(Eulerian3dPara::dt, Eulerian3dPara::cflNumber, Eulerian3dPara::maxSubsteps);
+            mPressureIterations = 0;
+            mPressureTime = 0.0;
+            while (!stepper.done()) {
+                float vmax = Eulerian3dPara::adaptiveDt ? mBackend->maxVelocity() : 0.0f;
+                float dt = stepper.next(vmax, 1.0f);
+
+                if (Eulerian3dPara::useReflection) {
+                    mBackend->saveVelocity();
+                    solveOneStep(dt * 0.5f);
+                    mBackend->reflectVelocity();
+                    solveOneStep(dt * 0.5f);
                 }
-                solveOneStep(densitySurf, densityArrayGL, tempSurf, tempArrayGL, dt * 0.5f);
-                if (mGrid.d_velocity_backup) {
-                    LaunchReflectVelocity(mGrid.d_velocity, mGrid.d_velocity_backup, size);
+                else {
+                    solveOneStep(dt);
                 }
-                solveOneStep(densitySurf, densityArrayGL, tempSurf, tempArrayGL, dt * 0.5f);
-            }
-            else {
-                solveOneStep(densitySurf, densityArrayGL, tempSurf, tempArrayGL, dt);
             }
+            stepper.report();
+
+            mBackend->synchronize();
 
-            cudaDeviceSynchronize();
+            char text[32];
+            snprintf(text, sizeof(text), "%.2f ms", mPressureTime);
+            Glb::Timer::getInstance().recordValue("pressure iterations", std::to_string(mPressureIterations));
+            Glb::Timer::getInstance().recordValue("pressure time", text);
 
 			// Add Sources
             for (size_t i = 0; i < Eulerian3dPara::source.size(); i++) {
                 auto& src = Eulerian3dPara::source[i];
 
                 if (src.density > 0.001f) {
-                    LaunchAddSource(densitySurf, src.position.x, src.position.y, src.position.z, 1.0f, src.density, w, h, d);
-					LaunchAddSource(tempSurf, src.position.x, src.position.y, src.position.z, 1.0f, src.temp, w, h, d);
-                    float3 velVal = make_float3(src.velocity.x, src.velocity.y, src.velocity.z);
-                    LaunchAddSourceVelocity(mGrid.d_velocity, src.position.x, src.position.y, src.position.z, 1.0f, velVal, w, h, d);
+                    mBackend->addSource(src, 1.0f);
                 }
             }
 
 			// Dissipate
-            LaunchDissipate(densitySurf, w, h, d, 0.99f);
+            mBackend->dissipate(0.99f);
 
-			// Cleanup
-            cudaDestroySurfaceObject(densitySurf);
-            cudaDestroySurfaceObject(tempSurf);
-            cudaGraphicsUnmapResources(1, &mGrid.cuda_density_res, 0);
-            cudaGraphicsUnmapResources(1, &mGrid.cuda_temperature_res, 0);
+            mBackend->endStep();
         }
     }
-}
\ No newline at end of file
+}
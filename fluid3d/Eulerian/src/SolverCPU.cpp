@@ -0,0 +1,527 @@
+﻿/**
+ * SolverCPU.cpp: 3D欧拉流体求解器的 CPU 内核实现
+ * 逐个移植 cuda/Solver.cu 中的 kernel，使无 GPU 的机器也能运行 3D 仿真
+ */
+
+#include "SolverCPU.h"
+#include "GridData3d.h"
+#include "Configure.h"
+#include "Wavefront.h"
+#include <cmath>
+#include <vector>
+
+namespace FluidSimulation
+{
+	namespace Eulerian3d
+	{
+		// 为 false 时所有内核在调用线程上串行执行
+		static bool sParallel = true;
+
+		void CpuSetParallel(bool parallel)
+		{
+			sParallel = parallel;
+		}
+
+		static inline int clampIndex(int i, int n)
+		{
+			return i < 0 ? 0 : (i > n - 1 ? n - 1 : i);
+		}
+
+		// =========================================================
+		// helper function：采样函数
+		// =========================================================
+
+		// 速度场三线性插值，与 sample_velocity_trilinear 一致
+		static glm::vec3 sampleVelocityTrilinear(const glm::vec3* vel, glm::vec3 pos, int w, int h, int d)
+		{
+			// 1. 边界钳制 - Grid 范围是 [0, dim], Cell 中心在 x.5
+			float x = fmaxf(0.5f, fminf(pos.x, w - 0.5f));
+			float y = fmaxf(0.5f, fminf(pos.y, h - 0.5f));
+			float z = fmaxf(0.5f, fminf(pos.z, d - 0.5f));
+
+			// 2. 计算基准索引
+			float u = x - 0.5f; float v = y - 0.5f; float s = z - 0.5f;
+			int x0 = (int)u; int y0 = (int)v; int z0 = (int)s;
+			int x1 = x0 + 1 < w - 1 ? x0 + 1 : w - 1;
+			int y1 = y0 + 1 < h - 1 ? y0 + 1 : h - 1;
+			int z1 = z0 + 1 < d - 1 ? z0 + 1 : d - 1;
+
+			float tx = u - x0; float ty = v - y0; float tz = s - z0;
+
+			auto idx = [&](int i, int j, int k) { return i + j * w + k * w * h; };
+
+			// 3. 读取 8 个邻居并插值
+			glm::vec3 lerpX00 = (1.0f - tx) * vel[idx(x0, y0, z0)] + tx * vel[idx(x1, y0, z0)];
+			glm::vec3 lerpX10 = (1.0f - tx) * vel[idx(x0, y1, z0)] + tx * vel[idx(x1, y1, z0)];
+			glm::vec3 lerpX01 = (1.0f - tx) * vel[idx(x0, y0, z1)] + tx * vel[idx(x1, y0, z1)];
+			glm::vec3 lerpX11 = (1.0f - tx) * vel[idx(x0, y1, z1)] + tx * vel[idx(x1, y1, z1)];
+
+			glm::vec3 lerpY0 = (1.0f - ty) * lerpX00 + ty * lerpX10;
+			glm::vec3 lerpY1 = (1.0f - ty) * lerpX01 + ty * lerpX11;
+
+			return (1.0f - tz) * lerpY0 + tz * lerpY1;
+		}
+
+		// 标量场三线性插值，模拟 tex3D (cudaFilterModeLinear + cudaAddressModeClamp + 非归一化坐标)
+		static float sampleScalarTrilinear(const float* field, glm::vec3 pos, int w, int h, int d)
+		{
+			// 纹素中心位于 x.5
+			float u = pos.x - 0.5f; float v = pos.y - 0.5f; float s = pos.z - 0.5f;
+			float fx = floorf(u); float fy = floorf(v); float fz = floorf(s);
+			float tx = u - fx; float ty = v - fy; float tz = s - fz;
+
+			int x0 = clampIndex((int)fx, w), x1 = clampIndex((int)fx + 1, w);
+			int y0 = clampIndex((int)fy, h), y1 = clampIndex((int)fy + 1, h);
+			int z0 = clampIndex((int)fz, d), z1 = clampIndex((int)fz + 1, d);
+
+			auto idx = [&](int i, int j, int k) { return i + j * w + k * w * h; };
+
+			float lerpX00 = (1.0f - tx) * field[idx(x0, y0, z0)] + tx * field[idx(x1, y0, z0)];
+			float lerpX10 = (1.0f - tx) * field[idx(x0, y1, z0)] + tx * field[idx(x1, y1, z0)];
+			float lerpX01 = (1.0f - tx) * field[idx(x0, y0, z1)] + tx * field[idx(x1, y0, z1)];
+			float lerpX11 = (1.0f - tx) * field[idx(x0, y1, z1)] + tx * field[idx(x1, y1, z1)];
+
+			float lerpY0 = (1.0f - ty) * lerpX00 + ty * lerpX10;
+			float lerpY1 = (1.0f - ty) * lerpX01 + ty * lerpX11;
+
+			return (1.0f - tz) * lerpY0 + tz * lerpY1;
+		}
+
+		// 从 pos 回溯 dt 后的位置，k1 为 pos 处的速度，与 trace_back 一致
+		static inline glm::vec3 traceBack(const glm::vec3* vel, glm::vec3 pos, glm::vec3 k1, float dt, int w, int h, int d, int integrator)
+		{
+			if (integrator == TRACE_RK2)
+			{
+				// 中点法
+				glm::vec3 k2 = sampleVelocityTrilinear(vel, pos - k1 * (0.5f * dt), w, h, d);
+				return pos - k2 * dt;
+			}
+			if (integrator == TRACE_RK3)
+			{
+				// Ralston RK3
+				glm::vec3 k2 = sampleVelocityTrilinear(vel, pos - k1 * (0.5f * dt), w, h, d);
+				glm::vec3 k3 = sampleVelocityTrilinear(vel, pos - k2 * (0.75f * dt), w, h, d);
+				return pos - ((2.0f / 9.0f) * k1 + (3.0f / 9.0f) * k2 + (4.0f / 9.0f) * k3) * dt;
+			}
+			return pos - k1 * dt;
+		}
+
+		// =========================================================
+		// 计算内核
+		// =========================================================
+
+		// 单个单元的标量平流，两个标量场共用同一个回溯位置
+		static inline void advectCell(float* targetA, const float* sourceA, float* targetB, const float* sourceB, const glm::vec3* velocity, float dt, int w, int h, int d, bool useBFECC, int integrator, int x, int y, int z)
+		{
+			int idx = x + y * w + z * w * h;
+			glm::vec3 pos(x + 0.5f, y + 0.5f, z + 0.5f);
+
+			// 1. Backward: 标准半拉格朗日回溯
+			glm::vec3 pos_back = traceBack(velocity, pos, velocity[idx], dt, w, h, d, integrator);
+
+			if (useBFECC)
+			{
+				// 2. Forward: 从回溯位置正向追踪回当前时刻
+				glm::vec3 pos_forward = traceBack(velocity, pos_back, sampleVelocityTrilinear(velocity, pos_back, w, h, d), -dt, w, h, d, integrator);
+				// 3. Correction: 在采样时向相反方向补偿一半误差
+				pos_back = pos_back - (pos_forward - pos) * 0.5f;
+			}
+
+			targetA[idx] = fmaxf(0.0f, sampleScalarTrilinear(sourceA, pos_back, w, h, d));
+			targetB[idx] = fmaxf(0.0f, sampleScalarTrilinear(sourceB, pos_back, w, h, d));
+		}
+
+		void CpuAdvectScalars(float* targetA, const float* sourceA, float* targetB, const float* sourceB, const glm::vec3* velocity, float dt, int w, int h, int d, bool useBFECC, int integrator)
+		{
+#pragma omp parallel for if(sParallel)
+			for (int z = 0; z < d; z++)
+			{
+				for (int y = 0; y < h; y++)
+				{
+					for (int x = 0; x < w; x++)
+					{
+						advectCell(targetA, sourceA, targetB, sourceB, velocity, dt, w, h, d, useBFECC, integrator, x, y, z);
+					}
+				}
+			}
+		}
+
+		// 块 b 覆盖的单元范围 [x0, x1) x [y0, y1) x [z0, z1)
+		static inline void blockRange(int b, int w, int h, int d, int& x0, int& x1, int& y0, int& y1, int& z0, int& z1)
+		{
+			const int bs = Glb::GRID_BRICK_SIZE;
+			int nbx = (w + bs - 1) / bs, nby = (h + bs - 1) / bs;
+			x0 = (b % nbx) * bs; x1 = x0 + bs < w ? x0 + bs : w;
+			y0 = ((b / nbx) % nby) * bs; y1 = y0 + bs < h ? y0 + bs : h;
+			z0 = (b / (nbx * nby)) * bs; z1 = z0 + bs < d ? z0 + bs : d;
+		}
+
+		void CpuAdvectScalarsBlocks(float* targetA, const float* sourceA, float* targetB, const float* sourceB, const glm::vec3* velocity, float dt, int w, int h, int d, bool useBFECC, int integrator, const int* blocks, int numBlocks)
+		{
+#pragma omp parallel for if(sParallel)
+			for (int t = 0; t < numBlocks; t++)
+			{
+				int x0, x1, y0, y1, z0, z1;
+				blockRange(blocks[t], w, h, d, x0, x1, y0, y1, z0, z1);
+				for (int z = z0; z < z1; z++)
+					for (int y = y0; y < y1; y++)
+						for (int x = x0; x < x1; x++)
+							advectCell(targetA, sourceA, targetB, sourceB, velocity, dt, w, h, d, useBFECC, integrator, x, y, z);
+			}
+		}
+
+		void CpuBlockMaxVelocity(float* blockMax, const glm::vec3* velocity, int w, int h, int d)
+		{
+			const int bs = Glb::GRID_BRICK_SIZE;
+			int numBlocks = ((w + bs - 1) / bs) * ((h + bs - 1) / bs) * ((d + bs - 1) / bs);
+#pragma omp parallel for if(sParallel)
+			for (int b = 0; b < numBlocks; b++)
+			{
+				int x0, x1, y0, y1, z0, z1;
+				blockRange(b, w, h, d, x0, x1, y0, y1, z0, z1);
+				float vmax = 0.0f;
+				for (int z = z0; z < z1; z++)
+					for (int y = y0; y < y1; y++)
+						for (int x = x0; x < x1; x++)
+						{
+							const glm::vec3& v = velocity[x + y * w + z * w * h];
+							vmax = fmaxf(vmax, fmaxf(fabsf(v.x), fmaxf(fabsf(v.y), fabsf(v.z))));
+						}
+				blockMax[b] = vmax;
+			}
+		}
+
+		void CpuAdvectVelocity(glm::vec3* new_vel, const glm::vec3* old_vel, float dt, int w, int h, int d, int integrator)
+		{
+#pragma omp parallel for if(sParallel)
+			for (int z = 0; z < d; z++)
+			{
+				for (int y = 0; y < h; y++)
+				{
+					for (int x = 0; x < w; x++)
+					{
+						int idx = x + y * w + z * w * h;
+						glm::vec3 pos(x + 0.5f, y + 0.5f, z + 0.5f);
+						glm::vec3 prevPos = traceBack(old_vel, pos, old_vel[idx], dt, w, h, d, integrator);
+						new_vel[idx] = sampleVelocityTrilinear(old_vel, prevPos, w, h, d);
+					}
+				}
+			}
+		}
+
+		void CpuApplyBuoyancy(glm::vec3* velocity, const float* density, const float* temperature, float dt, float alpha, float beta, float ambientTemp, int w, int h, int d)
+		{
+			int size = w * h * d;
+#pragma omp parallel for if(sParallel)
+			for (int idx = 0; idx < size; idx++)
+			{
+				// 在单元中心采样纹理即为该单元的值
+				float den = density[idx];
+				float T = temperature[idx];
+
+				// 公式: F = -alpha * density + beta * (temp - ambientTemp)
+				if (den > 0.0001f || fabsf(T - ambientTemp) > 0.0001f)
+				{
+					float buoyancy = -alpha * den + beta * (T - ambientTemp);
+					velocity[idx].z += buoyancy * dt;
+				}
+			}
+		}
+
+		void CpuComputeDivergence(float* divergence, const glm::vec3* velocity, int w, int h, int d, float halfrdx)
+		{
+#pragma omp parallel for if(sParallel)
+			for (int z = 0; z < d; z++)
+			{
+				int zl = z - 1 > 0 ? z - 1 : 0; int zr = z + 1 < d - 1 ? z + 1 : d - 1;
+				for (int y = 0; y < h; y++)
+				{
+					int yl = y - 1 > 0 ? y - 1 : 0; int yr = y + 1 < h - 1 ? y + 1 : h - 1;
+					for (int x = 0; x < w; x++)
+					{
+						int xl = x - 1 > 0 ? x - 1 : 0; int xr = x + 1 < w - 1 ? x + 1 : w - 1;
+
+						// 中心差分 (Collocated Grid)
+						float du = velocity[xr + y * w + z * w * h].x - velocity[xl + y * w + z * w * h].x;
+						float dv = velocity[x + yr * w + z * w * h].y - velocity[x + yl * w + z * w * h].y;
+						float dw = velocity[x + y * w + zr * w * h].z - velocity[x + y * w + zl * w * h].z;
+
+						divergence[x + y * w + z * w * h] = (du + dv + dw) * halfrdx;
+					}
+				}
+			}
+		}
+
+		// 第 z 层第 y 行内部单元的一次 Jacobi 迭代，omega 不为 1 时为 Chebyshev 加速
+		static inline void jacobiRow(float* p_next, const float* p_curr, const float* divergence, int w, int slice, int y, int z, float omega)
+		{
+			int row = y * w + z * slice;
+			if (omega == 1.0f)
+			{
+				for (int x = 1; x < w - 1; x++)
+				{
+					int idx = row + x;
+					float sum = p_curr[idx - 1] + p_curr[idx + 1] +
+						p_curr[idx - w] + p_curr[idx + w] +
+						p_curr[idx - slice] + p_curr[idx + slice];
+					p_next[idx] = (sum - divergence[idx]) / 6.0f;
+				}
+				return;
+			}
+			for (int x = 1; x < w - 1; x++)
+			{
+				int idx = row + x;
+				float sum = p_curr[idx - 1] + p_curr[idx + 1] +
+					p_curr[idx - w] + p_curr[idx + w] +
+					p_curr[idx - slice] + p_curr[idx + slice];
+				float jacobi = (sum - divergence[idx]) / 6.0f;
+				p_next[idx] += omega * (jacobi - p_next[idx]);
+			}
+		}
+
+		void CpuJacobiPressure(float* p_next, const float* p_curr, const float* divergence, int w, int h, int d)
+		{
+			int slice = w * h;
+			// 排除体积边界 (与 jacobi_pressure_kernel 一致，边界压力保持不变)
+#pragma omp parallel for if(sParallel)
+			for (int z = 1; z < d - 1; z++)
+			{
+				for (int y = 1; y < h - 1; y++)
+					jacobiRow(p_next, p_curr, divergence, w, slice, y, z, 1.0f);
+			}
+		}
+
+		void CpuChebyshevJacobi(float* p_next, const float* p_curr, const float* divergence, int w, int h, int d, float omega)
+		{
+			int slice = w * h;
+#pragma omp parallel for if(sParallel)
+			for (int z = 1; z < d - 1; z++)
+			{
+				for (int y = 1; y < h - 1; y++)
+					jacobiRow(p_next, p_curr, divergence, w, slice, y, z, omega);
+			}
+		}
+
+		void CpuJacobiPressureSweeps(float* p_curr, float* p_next, const float* divergence, int w, int h, int d, int sweeps, const float* omega, int depth)
+		{
+			// 第 t 次迭代从 buffer[t & 1] 读取，写入 buffer[(t + 1) & 1]
+			int slice = w * h;
+			float* buffer[2] = { p_curr, p_next };
+			for (int done = 0; done < sweeps; )
+			{
+				int passes = sweeps - done < depth ? sweeps - done : depth;
+				if (passes <= 1)
+				{
+					CpuChebyshevJacobi(buffer[(done + 1) & 1], buffer[done & 1], divergence, w, h, d, omega ? omega[done] : 1.0f);
+				}
+				else
+				{
+					Glb::forEachWavefront(1, d - 1, passes, h - 2, sParallel, [&](int pass, int z, int row) {
+						int t = done + pass;
+						jacobiRow(buffer[(t + 1) & 1], buffer[t & 1], divergence, w, slice, row + 1, z, omega ? omega[t] : 1.0f);
+					});
+				}
+				done += passes;
+			}
+		}
+
+		float CpuEstimateJacobiRadius(int w, int h, int d, int iterations)
+		{
+			// 散度为 0 时一次 Jacobi 迭代即 q <- G q，G 对称且谱关于 0 对称
+			// 以内部全为 1 的向量开始 Lanczos 迭代，三对角矩阵的最大特征值 (Ritz 值) 从下方逼近谱半径，比幂迭代快得多
+			int size = w * h * d;
+			int slice = w * h;
+			std::vector<float> q(size, 0.0f), prev(size, 0.0f), g(size, 0.0f), zero(size, 0.0f);
+			double norm = 0.0;
+			for (int z = 1; z < d - 1; z++)
+				for (int j = 1; j < h - 1; j++)
+					for (int i = 1; i < w - 1; i++) {
+						q[i + j * w + z * slice] = 1.0f;
+						norm += 1.0;
+					}
+			if (norm <= 0.0)
+				return 0.0f;
+			float s = (float)(1.0 / sqrt(norm));
+			for (int c = 0; c < size; c++)
+				q[c] *= s;
+
+			std::vector<double> alpha, beta;
+			for (int it = 0; it < iterations; it++)
+			{
+				CpuJacobiPressure(g.data(), q.data(), zero.data(), w, h, d);
+				double a = 0.0;
+				for (int c = 0; c < size; c++)
+					a += (double)q[c] * g[c];
+				double b = beta.empty() ? 0.0 : beta.back();
+				double gg = 0.0;
+				for (int c = 0; c < size; c++) {
+					g[c] -= (float)(a * q[c] + b * prev[c]);
+					gg += (double)g[c] * g[c];
+				}
+				alpha.push_back(a);
+				if (gg <= 1e-24)
+					break;
+				beta.push_back(sqrt(gg));
+				s = (float)(1.0 / beta.back());
+				for (int c = 0; c < size; c++) {
+					prev[c] = q[c];
+					q[c] = g[c] * s;
+				}
+			}
+
+			// 二分法求三对角矩阵的最大特征值，Sturm 序列给出小于 x 的特征值个数
+			int m = (int)alpha.size();
+			double lo = -1.0, hi = 1.0;
+			for (int k = 0; k < m; k++) {
+				double r = (k > 0 ? beta[k - 1] : 0.0) + (k < m - 1 ? beta[k] : 0.0);
+				lo = alpha[k] - r < lo ? alpha[k] - r : lo;
+				hi = alpha[k] + r > hi ? alpha[k] + r : hi;
+			}
+			for (int step = 0; step < 100; step++) {
+				double x = 0.5 * (lo + hi);
+				int below = 0;
+				double t = 1.0;
+				for (int k = 0; k < m; k++) {
+					double off = k > 0 ? beta[k - 1] * beta[k - 1] : 0.0;
+					t = alpha[k] - x - (k > 0 ? off / t : 0.0);
+					if (t == 0.0)
+						t = -1e-300;
+					if (t < 0.0)
+						below++;
+				}
+				if (below < m)
+					lo = x;
+				else
+					hi = x;
+			}
+			// 小于 1 才能保证 Chebyshev 系数有意义
+			return (float)(lo < 0.9999999 ? lo : 0.9999999);
+		}
+
+		void CpuPressureResidual(float* sliceMax, const float* pressure, const float* divergence, int w, int h, int d)
+		{
+			int slice = w * h;
+			sliceMax[0] = 0.0f;
+			sliceMax[d - 1] = 0.0f;
+#pragma omp parallel for if(sParallel)
+			for (int z = 1; z < d - 1; z++)
+			{
+				float m = 0.0f;
+				for (int y = 1; y < h - 1; y++)
+				{
+					int row = y * w + z * slice;
+					if (!pressure)
+					{
+						for (int x = 1; x < w - 1; x++)
+							m = fmaxf(m, fabsf(divergence[row + x]));
+						continue;
+					}
+					for (int x = 1; x < w - 1; x++)
+					{
+						int idx = row + x;
+						float sum = pressure[idx - 1] + pressure[idx + 1] +
+							pressure[idx - w] + pressure[idx + w] +
+							pressure[idx - slice] + pressure[idx + slice];
+						m = fmaxf(m, fabsf(sum - divergence[idx] - 6.0f * pressure[idx]));
+					}
+				}
+				sliceMax[z] = m;
+			}
+		}
+
+		void CpuSubtractGradient(glm::vec3* velocity, const float* pressure, int w, int h, int d, float halfrdx, float airDensity)
+		{
+			if (airDensity <= 0.0001f)
+				return;
+
+			int slice = w * h;
+			float invDensity = 1.0f / airDensity;
+#pragma omp parallel for if(sParallel)
+			for (int z = 1; z < d - 1; z++)
+			{
+				for (int y = 1; y < h - 1; y++)
+				{
+					int row = y * w + z * slice;
+					for (int x = 1; x < w - 1; x++)
+					{
+						int idx = row + x;
+						glm::vec3 gradP(
+							(pressure[idx + 1] - pressure[idx - 1]) * halfrdx,
+							(pressure[idx + w] - pressure[idx - w]) * halfrdx,
+							(pressure[idx + slice] - pressure[idx - slice]) * halfrdx);
+
+						// u_new = u_old - grad(P) / rho
+						velocity[idx] -= gradP * invDensity;
+					}
+				}
+			}
+		}
+
+		void CpuReflectVelocity(glm::vec3* vel_curr, const glm::vec3* vel_old, int size)
+		{
+#pragma omp parallel for if(sParallel)
+			for (int idx = 0; idx < size; idx++)
+			{
+				vel_curr[idx] = 2.0f * vel_curr[idx] - vel_old[idx];
+			}
+		}
+
+		void CpuAddSource(float* field, int x, int y, int z, float radius, float amount, int w, int h, int d)
+		{
+			// 只需遍历源点附近的包围盒
+			int r = (int)ceilf(radius);
+			for (int k = z - r; k <= z + r; k++)
+				for (int j = y - r; j <= y + r; j++)
+					for (int i = x - r; i <= x + r; i++)
+					{
+						if (i < 0 || i >= w || j < 0 || j >= h || k < 0 || k >= d)
+							continue;
+						float dist = sqrtf((float)((i - x) * (i - x) + (j - y) * (j - y) + (k - z) * (k - z)));
+						if (dist < radius)
+							field[i + j * w + k * w * h] += amount;
+					}
+		}
+
+		void CpuAddSourceVelocity(glm::vec3* velocity, int x, int y, int z, float radius, glm::vec3 amount, int w, int h, int d)
+		{
+			int r = (int)ceilf(radius);
+			for (int k = z - r; k <= z + r; k++)
+				for (int j = y - r; j <= y + r; j++)
+					for (int i = x - r; i <= x + r; i++)
+					{
+						if (i < 0 || i >= w || j < 0 || j >= h || k < 0 || k >= d)
+							continue;
+						float dist = sqrtf((float)((i - x) * (i - x) + (j - y) * (j - y) + (k - z) * (k - z)));
+						if (dist < radius)
+							velocity[i + j * w + k * w * h] += amount;
+					}
+		}
+
+		void CpuDissipate(float* field, int w, int h, int d, float rate)
+		{
+			int size = w * h * d;
+#pragma omp parallel for if(sParallel)
+			for (int idx = 0; idx < size; idx++)
+			{
+				field[idx] *= rate;
+			}
+		}
+
+		void CpuDissipateBlocks(float* field, int w, int h, int d, float rate, const int* blocks, int numBlocks)
+		{
+#pragma omp parallel for if(sParallel)
+			for (int t = 0; t < numBlocks; t++)
+			{
+				int x0, x1, y0, y1, z0, z1;
+				blockRange(blocks[t], w, h, d, x0, x1, y0, y1, z0, z1);
+				for (int z = z0; z < z1; z++)
+					for (int y = y0; y < y1; y++)
+					{
+						float* row = field + y * w + z * w * h;
+						for (int x = x0; x < x1; x++)
+							row[x] *= rate;
+					}
+			}
+		}
+	}
+}
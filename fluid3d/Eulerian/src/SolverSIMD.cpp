@@ -0,0 +1,141 @@
+﻿/**
+ * SolverSIMD.cpp: 3D欧拉流体求解器的 AVX2 内核实现
+ * 未以 AVX2 编译时退化为标量循环，保证结果一致
+ */
+
+#include "SolverSIMD.h"
+#include "Wavefront.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace FluidSimulation
+{
+	namespace Eulerian3d
+	{
+		// 第 z 层第 y 行内部单元的一次 Jacobi 迭代，omega 不为 1 时为 Chebyshev 加速
+		static inline void jacobiRow(float* p_next, const float* p_curr, const float* divergence, int w, int slice, int y, int z, float omega)
+		{
+			const float inv6 = 1.0f / 6.0f;
+			const bool plain = omega == 1.0f;
+			int row = y * w + z * slice;
+			int x = 1;
+#if defined(__AVX2__)
+			const __m256 vinv6 = _mm256_set1_ps(inv6);
+			const __m256 vomega = _mm256_set1_ps(omega);
+			for (; x + 8 <= w - 1; x += 8)
+			{
+				int idx = row + x;
+				__m256 sum = _mm256_add_ps(_mm256_loadu_ps(p_curr + idx - 1), _mm256_loadu_ps(p_curr + idx + 1));
+				sum = _mm256_add_ps(sum, _mm256_loadu_ps(p_curr + idx - w));
+				sum = _mm256_add_ps(sum, _mm256_loadu_ps(p_curr + idx + w));
+				sum = _mm256_add_ps(sum, _mm256_loadu_ps(p_curr + idx - slice));
+				sum = _mm256_add_ps(sum, _mm256_loadu_ps(p_curr + idx + slice));
+				sum = _mm256_sub_ps(sum, _mm256_loadu_ps(divergence + idx));
+				__m256 jacobi = _mm256_mul_ps(sum, vinv6);
+				if (!plain)
+				{
+					__m256 prev = _mm256_loadu_ps(p_next + idx);
+					jacobi = _mm256_fmadd_ps(vomega, _mm256_sub_ps(jacobi, prev), prev);
+				}
+				_mm256_storeu_ps(p_next + idx, jacobi);
+			}
+#endif
+			// 剩余部分
+			for (; x < w - 1; x++)
+			{
+				int idx = row + x;
+				float sum = p_curr[idx - 1] + p_curr[idx + 1] +
+					p_curr[idx - w] + p_curr[idx + w] +
+					p_curr[idx - slice] + p_curr[idx + slice];
+				float jacobi = (sum - divergence[idx]) * inv6;
+				p_next[idx] = plain ? jacobi : p_next[idx] + omega * (jacobi - p_next[idx]);
+			}
+		}
+
+		void SimdJacobiPressure(float* p_next, const float* p_curr, const float* divergence, int w, int h, int d)
+		{
+			SimdChebyshevJacobi(p_next, p_curr, divergence, w, h, d, 1.0f);
+		}
+
+		void SimdChebyshevJacobi(float* p_next, const float* p_curr, const float* divergence, int w, int h, int d, float omega)
+		{
+			int slice = w * h;
+#pragma omp parallel for
+			for (int z = 1; z < d - 1; z++)
+			{
+				for (int y = 1; y < h - 1; y++)
+					jacobiRow(p_next, p_curr, divergence, w, slice, y, z, omega);
+			}
+		}
+
+		void SimdJacobiPressureSweeps(float* p_curr, float* p_next, const float* divergence, int w, int h, int d, int sweeps, const float* omega, int depth)
+		{
+			int slice = w * h;
+			float* buffer[2] = { p_curr, p_next };
+			for (int done = 0; done < sweeps; )
+			{
+				int passes = sweeps - done < depth ? sweeps - done : depth;
+				if (passes <= 1)
+				{
+					SimdChebyshevJacobi(buffer[(done + 1) & 1], buffer[done & 1], divergence, w, h, d, omega ? omega[done] : 1.0f);
+				}
+				else
+				{
+					Glb::forEachWavefront(1, d - 1, passes, h - 2, true, [&](int pass, int z, int row) {
+						int t = done + pass;
+						jacobiRow(buffer[(t + 1) & 1], buffer[t & 1], divergence, w, slice, row + 1, z, omega ? omega[t] : 1.0f);
+					});
+				}
+				done += passes;
+			}
+		}
+
+		void SimdReflect(float* curr, const float* old, int n)
+		{
+			const int block = 1 << 14;
+			int numBlocks = (n + block - 1) / block;
+#pragma omp parallel for
+			for (int b = 0; b < numBlocks; b++)
+			{
+				int i = b * block;
+				int end = i + block < n ? i + block : n;
+#if defined(__AVX2__)
+				const __m256 two = _mm256_set1_ps(2.0f);
+				for (; i + 8 <= end; i += 8)
+				{
+					__m256 c = _mm256_loadu_ps(curr + i);
+					_mm256_storeu_ps(curr + i, _mm256_fmsub_ps(two, c, _mm256_loadu_ps(old + i)));
+				}
+#endif
+				for (; i < end; i++)
+				{
+					curr[i] = 2.0f * curr[i] - old[i];
+				}
+			}
+		}
+
+		void SimdDissipate(float* field, int n, float rate)
+		{
+			const int block = 1 << 14;
+			int numBlocks = (n + block - 1) / block;
+#pragma omp parallel for
+			for (int b = 0; b < numBlocks; b++)
+			{
+				int i = b * block;
+				int end = i + block < n ? i + block : n;
+#if defined(__AVX2__)
+				const __m256 vrate = _mm256_set1_ps(rate);
+				for (; i + 8 <= end; i += 8)
+				{
+					_mm256_storeu_ps(field + i, _mm256_mul_ps(_mm256_loadu_ps(field + i), vrate));
+				}
+#endif
+				for (; i < end; i++)
+				{
+					field[i] *= rate;
+				}
+			}
+		}
+	}
+}
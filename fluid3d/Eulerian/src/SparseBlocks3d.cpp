@@ -0,0 +1,129 @@
+﻿/**
+ * SparseBlocks3d.cpp: 密度/温度场稀疏块索引的实现
+ */
+
+#include "SparseBlocks3d.h"
+#include <cmath>
+
+namespace FluidSimulation
+{
+    namespace Eulerian3d
+    {
+        static const int BS = Glb::GRID_BRICK_SIZE;
+
+        static inline int clampInt(int v, int lo, int hi)
+        {
+            return v < lo ? lo : (v > hi ? hi : v);
+        }
+
+        void SparseBlocks3d::init(int w, int h, int d, bool parallel)
+        {
+            mParallel = parallel;
+            mDim[0] = w; mDim[1] = h; mDim[2] = d;
+            for (int a = 0; a < 3; a++)
+                mBlocks[a] = (mDim[a] + BS - 1) / BS;
+            mActive.assign(numBlocks(), 0);
+            mActiveList.clear();
+            mDilatedList.clear();
+        }
+
+        void SparseBlocks3d::activate(int x0, int y0, int z0, int x1, int y1, int z1)
+        {
+            int bx0 = clampInt(x0, 0, mDim[0] - 1) / BS, bx1 = clampInt(x1, 0, mDim[0] - 1) / BS;
+            int by0 = clampInt(y0, 0, mDim[1] - 1) / BS, by1 = clampInt(y1, 0, mDim[1] - 1) / BS;
+            int bz0 = clampInt(z0, 0, mDim[2] - 1) / BS, bz1 = clampInt(z1, 0, mDim[2] - 1) / BS;
+
+            bool changed = false;
+            for (int bz = bz0; bz <= bz1; bz++)
+                for (int by = by0; by <= by1; by++)
+                    for (int bx = bx0; bx <= bx1; bx++) {
+                        unsigned char& a = mActive[bx + by * mBlocks[0] + bz * mBlocks[0] * mBlocks[1]];
+                        changed |= a == 0;
+                        a = 1;
+                    }
+            if (changed)
+                rebuildActiveList();
+        }
+
+        void SparseBlocks3d::dilate(const std::vector<int>& halo)
+        {
+            // 从活跃块出发广度优先搜索，26 邻域下的步数即块间的切比雪夫距离
+            const int unreached = 1 << 30;
+            mDistance.assign(numBlocks(), unreached);
+            std::vector<int> queue(mActiveList);
+            for (int b : mActiveList)
+                mDistance[b] = 0;
+
+            for (size_t head = 0; head < queue.size(); head++) {
+                int b = queue[head];
+                int bx = b % mBlocks[0];
+                int by = (b / mBlocks[0]) % mBlocks[1];
+                int bz = b / (mBlocks[0] * mBlocks[1]);
+                for (int z = clampInt(bz - 1, 0, mBlocks[2] - 1); z <= clampInt(bz + 1, 0, mBlocks[2] - 1); z++)
+                    for (int y = clampInt(by - 1, 0, mBlocks[1] - 1); y <= clampInt(by + 1, 0, mBlocks[1] - 1); y++)
+                        for (int x = clampInt(bx - 1, 0, mBlocks[0] - 1); x <= clampInt(bx + 1, 0, mBlocks[0] - 1); x++) {
+                            int n = x + y * mBlocks[0] + z * mBlocks[0] * mBlocks[1];
+                            if (mDistance[n] == unreached) {
+                                mDistance[n] = mDistance[b] + 1;
+                                queue.push_back(n);
+                            }
+                        }
+            }
+
+            // 与活跃块相距 dist 个块的单元，到活跃单元至少 (dist - 1) * BS + 1 个单元
+            mDilatedList.clear();
+            for (int b = 0; b < numBlocks(); b++)
+                if (mDistance[b] == 0 || (mDistance[b] != unreached && (mDistance[b] - 1) * BS < halo[b]))
+                    mDilatedList.push_back(b);
+        }
+
+        void SparseBlocks3d::prune(float* density, float* temperature, float tolerance)
+        {
+            int w = mDim[0], h = mDim[1], d = mDim[2];
+            int n = (int)mDilatedList.size();
+
+#pragma omp parallel for if(mParallel)
+            for (int t = 0; t < n; t++)
+            {
+                int b = mDilatedList[t];
+                int x0 = (b % mBlocks[0]) * BS, x1 = x0 + BS < w ? x0 + BS : w;
+                int y0 = ((b / mBlocks[0]) % mBlocks[1]) * BS, y1 = y0 + BS < h ? y0 + BS : h;
+                int z0 = (b / (mBlocks[0] * mBlocks[1])) * BS, z1 = z0 + BS < d ? z0 + BS : d;
+
+                bool active = false;
+                for (int z = z0; z < z1 && !active; z++)
+                    for (int y = y0; y < y1 && !active; y++)
+                        for (int x = x0; x < x1; x++) {
+                            int idx = x + y * w + z * w * h;
+                            if (fabsf(density[idx] - densityBackground) > tolerance ||
+                                fabsf(temperature[idx] - temperatureBackground) > tolerance) {
+                                active = true;
+                                break;
+                            }
+                        }
+
+                if (!active) {
+                    // 写回背景值以维持不变式
+                    for (int z = z0; z < z1; z++)
+                        for (int y = y0; y < y1; y++)
+                            for (int x = x0; x < x1; x++) {
+                                int idx = x + y * w + z * w * h;
+                                density[idx] = densityBackground;
+                                temperature[idx] = temperatureBackground;
+                            }
+                }
+                mActive[b] = active ? 1 : 0;
+            }
+
+            rebuildActiveList();
+        }
+
+        void SparseBlocks3d::rebuildActiveList()
+        {
+            mActiveList.clear();
+            for (int b = 0; b < (int)mActive.size(); b++)
+                if (mActive[b])
+                    mActiveList.push_back(b);
+        }
+    }
+}
@@ -16,6 +16,7 @@
 #include "Configure.h"
 #include "Manager.h"
 #include "Logger.h"
+#include "Benchmark.h"
 
 #include <iostream>
 #include <string>
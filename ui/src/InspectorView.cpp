@@ -151,6 +151,26 @@ namespace FluidSimulation
 
 				ImGui::Text("Solver:");
 				ImGui::SliderFloat("Delta Time", &Eulerian2dPara::dt, 0.0f, 0.1f, "%.5f");
+				ImGui::Checkbox("Adaptive Time Step", &Eulerian2dPara::adaptiveDt);
+				if (Eulerian2dPara::adaptiveDt) {
+					ImGui::SliderFloat("CFL Number", &Eulerian2dPara::cflNumber, 0.1f, 10.0f);
+					ImGui::SliderInt("Max Substeps", &Eulerian2dPara::maxSubsteps, 1, 32);
+				}
+				ImGui::Combo("Backend (rerun)", &Eulerian2dPara::backend, solverBackendNames, BACKEND_COUNT);
+				ImGui::Combo("Advection Scheme", &Eulerian2dPara::advectionScheme, advectionSchemeNames, ADVECT_SCHEME_COUNT);
+				ImGui::Combo("Trace Integrator", &Eulerian2dPara::traceIntegrator, traceIntegratorNames, TRACE_INTEGRATOR_COUNT);
+				ImGui::Combo("Pressure Solver", &Eulerian2dPara::pressureSolver, pressureSolverNames, PRESSURE_SOLVER_COUNT);
+				ImGui::InputFloat("Pressure Tolerance", &Eulerian2dPara::pressureTolerance, 0.0f, 0.0f, "%.1e");
+				if (Eulerian2dPara::pressureSolver == PRESSURE_PCG || Eulerian2dPara::pressureSolver == PRESSURE_MULTIGRID || Eulerian2dPara::pressureSolver == PRESSURE_MGPCG || Eulerian2dPara::pressureSolver == PRESSURE_MIXED_PRECISION) {
+					ImGui::SliderInt("Pressure Max Iterations", &Eulerian2dPara::pressureMaxIterations, 1, 1000);
+				}
+				else if (Eulerian2dPara::pressureSolver != PRESSURE_FFT) {
+					ImGui::SliderInt("Residual Check Interval", &Eulerian2dPara::pressureCheckInterval, 0, 50);
+				}
+				if (Eulerian2dPara::pressureSolver == PRESSURE_RED_BLACK_SOR) {
+					ImGui::SliderFloat("SOR Omega", &Eulerian2dPara::sorOmega, 1.0f, 1.99f);
+				}
+				ImGui::Checkbox("Warm Start Pressure", &Eulerian2dPara::warmStartPressure);
 
 				ImGui::Separator();
 
@@ -216,8 +236,34 @@ namespace FluidSimulation
 
 				ImGui::Text("Solver:");
 				ImGui::SliderFloat("Delta Time", &Eulerian3dPara::dt, 0.0f, 0.01f, "%.05f");
+				ImGui::Checkbox("Adaptive Time Step", &Eulerian3dPara::adaptiveDt);
+				if (Eulerian3dPara::adaptiveDt) {
+					ImGui::SliderFloat("CFL Number", &Eulerian3dPara::cflNumber, 0.1f, 10.0f);
+					ImGui::SliderInt("Max Substeps", &Eulerian3dPara::maxSubsteps, 1, 32);
+				}
+				ImGui::Combo("Backend (rerun)", &Eulerian3dPara::backend, solverBackendNames, BACKEND_COUNT);
 				ImGui::Checkbox("Back and Forth Error Compensation and Correction", &Eulerian3dPara::useBFECC);
+				ImGui::Combo("Trace Integrator", &Eulerian3dPara::traceIntegrator, traceIntegratorNames, TRACE_INTEGRATOR_COUNT);
 				ImGui::Checkbox("Half-Step Reflection", &Eulerian3dPara::useReflection);
+				ImGui::Combo("Pressure Solver (CPU)", &Eulerian3dPara::pressureSolver, pressureSolverNames, PRESSURE_SOLVER_COUNT);
+				ImGui::InputFloat("Pressure Tolerance", &Eulerian3dPara::pressureTolerance, 0.0f, 0.0f, "%.1e");
+				if (Eulerian3dPara::pressureSolver == PRESSURE_PCG || Eulerian3dPara::pressureSolver == PRESSURE_MULTIGRID || Eulerian3dPara::pressureSolver == PRESSURE_MGPCG) {
+					ImGui::SliderInt("Pressure Max Iterations", &Eulerian3dPara::pressureMaxIterations, 1, 1000);
+				}
+				else if (Eulerian3dPara::pressureSolver == PRESSURE_CHEBYSHEV) {
+					ImGui::SliderInt("Pressure Max Iterations", &Eulerian3dPara::pressureMaxIterations, 1, 1000);
+					ImGui::SliderInt("Residual Check Interval", &Eulerian3dPara::pressureCheckInterval, 0, 50);
+				}
+				else if (Eulerian3dPara::pressureSolver != PRESSURE_FFT) {
+					ImGui::SliderInt("Residual Check Interval", &Eulerian3dPara::pressureCheckInterval, 0, 40);
+				}
+				ImGui::Checkbox("Warm Start Pressure", &Eulerian3dPara::warmStartPressure);
+				ImGui::Checkbox("Sparse Smoke Blocks (CPU, rerun)", &Eulerian3dPara::sparseScalars);
+				if (ImGui::Button("Grid Layout Benchmark")) {
+					Glb::BenchmarkGridLayout3d();
+				}
+				ImGui::SameLine();
+				ImGui::Text("(blocks for a few seconds)");
 
 				ImGui::Separator();
 